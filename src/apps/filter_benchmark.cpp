@@ -0,0 +1,109 @@
+
+// By downloading, copying, installing or using the software you agree to this license.
+// If you do not agree to this license, do not download, install,
+// copy or use the software.
+
+
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//                        (3-clause BSD License)
+
+// Copyright (C) 2015,
+// 	  Guillaume Lemaitre (g.lemaitre58@gmail.com),
+// 	  Johan Massich (mailsik@gmail.com),
+// 	  Gerard Bahi (zomeck@gmail.com),
+// 	  Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+// Third party copyrights are property of their respective owners.
+
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+
+//   * Neither the names of the copyright holders nor the names of the contributors
+//     may be used to endorse or promote products derived from this software
+//     without specific prior written permission.
+
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+
+// our own code
+#include <img_processing/imageProcessing.h>
+
+// stl library
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+
+// OpenCV library
+#include <opencv2/opencv.hpp>
+
+// Number of runs averaged for each measure
+#define NB_RUNS 10
+
+// Mean elapsed time of a function (in ms)
+template< typename Function >
+static double mean_time_ms(Function func) {
+    // First call to allocate the outputs and wake up the threads
+    func();
+    const std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+    for (int run = 0; run < NB_RUNS; ++run)
+        func();
+    const std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+    return elapsed_seconds.count() * 1000.0 / NB_RUNS;
+}
+
+int main(int argc, char *argv[]) {
+
+    // Maximum number of threads -- 16 by default
+    const int max_threads = (argc > 1) ? std::atoi(argv[1]) : 16;
+    if (max_threads < 1) {
+        std::cout << "Usage of the code: ./filter_benchmark [maxNumberOfThreads]" << std::endl;
+        return -1;
+    }
+
+    // 4K segmentation mask -- blobs with holes and salt and pepper noise
+    cv::RNG rng(42);
+    cv::Mat seg_image = cv::Mat::zeros(2160, 3840, CV_8UC1);
+    for (int i = 0; i < 400; i++) {
+        const cv::Point center(rng.uniform(0, seg_image.cols), rng.uniform(0, seg_image.rows));
+        cv::circle(seg_image, center, rng.uniform(5, 120), cv::Scalar(255), rng.uniform(0, 2) ? -1 : rng.uniform(2, 8));
+    }
+    cv::Mat noise(seg_image.size(), CV_8UC1);
+    cv::randu(noise, cv::Scalar(0), cv::Scalar(256));
+    seg_image.setTo(cv::Scalar(255), noise > 250);
+    seg_image.setTo(cv::Scalar(0), noise < 5);
+
+    // Exactness of the binary path
+    cv::Mat bin_reference, bin_binary, work_image;
+    imageprocessing::filter_image(seg_image, bin_reference);
+    imageprocessing::filter_image_binary(seg_image, bin_binary, work_image);
+    std::cout << "Mask " << seg_image.cols << "x" << seg_image.rows << ", " << cv::countNonZero(bin_reference != bin_binary)
+              << " different pixels, mean of " << NB_RUNS << " runs (ms)" << std::endl;
+
+    const double t_reference = mean_time_ms([&]() { imageprocessing::filter_image(seg_image, bin_reference); });
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "filter_image"
+              << std::setw(14) << "binary" << std::setw(10) << "speed-up" << std::endl;
+    for (int nb_threads = 1; nb_threads <= max_threads; nb_threads *= 2) {
+        const double t_binary = mean_time_ms([&]() { imageprocessing::filter_image_binary(seg_image, bin_binary, work_image, nb_threads); });
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(8) << nb_threads << std::setw(14) << t_reference
+                  << std::setw(14) << t_binary << std::setw(10) << t_reference / t_binary << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+
+// By downloading, copying, installing or using the software you agree to this license.
+// If you do not agree to this license, do not download, install,
+// copy or use the software.
+
+
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//                        (3-clause BSD License)
+
+// Copyright (C) 2015,
+// 	  Guillaume Lemaitre (g.lemaitre58@gmail.com),
+// 	  Johan Massich (mailsik@gmail.com),
+// 	  Gerard Bahi (zomeck@gmail.com),
+// 	  Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+// Third party copyrights are property of their respective owners.
+
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+
+//   * Neither the names of the copyright holders nor the names of the contributors
+//     may be used to endorse or promote products derived from this software
+//     without specific prior written permission.
+
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+
+// our own code
+#include <detection/trafficSignDetector.h>
+
+// stl library
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+// OpenCV library
+#include <opencv2/opencv.hpp>
+
+// Fit error below which the remaining hypotheses are skipped -- can be given as first argument
+#define DEFAULT_EARLY_EXIT_ERROR 0.05
+
+// Work of the hypothesis search over the test set
+struct SearchReport {
+    SearchReport() : nb_candidates(0), nb_fitted(0), nb_aborted(0), nb_iterations(0), fit_time(0.0), nb_same_sign_type(0) {}
+
+    int nb_candidates;
+    int nb_fitted;
+    int nb_aborted;
+    int nb_iterations;
+    double fit_time;
+    int nb_same_sign_type;
+};
+
+static void print_report(const std::string& name, const SearchReport& report, const SearchReport& reference) {
+    const int nb_hypotheses = report.nb_candidates * NB_SIGN_TYPES;
+    std::cout << std::fixed << std::setprecision(1)
+              << std::setw(20) << name
+              << std::setw(10) << report.nb_fitted
+              << std::setw(10) << report.nb_aborted
+              << std::setw(10) << nb_hypotheses - report.nb_fitted - report.nb_aborted
+              << std::setw(12) << report.nb_iterations
+              << std::setw(11) << 100.0 * (1.0 - static_cast<double> (report.nb_iterations) / reference.nb_iterations) << "%"
+              << std::setw(12) << report.fit_time
+              << std::setw(9) << report.nb_same_sign_type << "/" << report.nb_candidates << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+
+    const double early_exit_error = (argc > 1) ? std::atof(argv[1]) : DEFAULT_EARLY_EXIT_ERROR;
+
+    const std::string filenames[] = { "/circular0009.jpg", "/different0011.jpg", "/different0035.jpg",
+                                      "/octogonal0010.jpg", "/octogonal0017.jpg", "/triangular0016.jpg" };
+
+    // Exhaustive search, pruning, then pruning with early exit
+    detection::DetectorConfig configs[3];
+    configs[1].fit_pruning = true;
+    configs[2].fit_pruning = true;
+    configs[2].fit_early_exit_error = early_exit_error;
+    const std::string names[3] = { "exhaustive", "pruning", "pruning + exit" };
+
+    SearchReport reports[3];
+    for (size_t i = 0; i < sizeof(filenames) / sizeof(filenames[0]); i++) {
+        const cv::Mat input_image = cv::imread(std::string(TEST_DATA_DIR) + filenames[i]);
+        if (!input_image.data) {
+            std::cout << "Error to read the image " << filenames[i] << std::endl;
+            return -1;
+        }
+
+        std::vector< detection::Detection > detections[3];
+        for (int c = 0; c < 3; c++) {
+            detection::TrafficSignDetector detector(configs[c]);
+            detector.detect(input_image, detections[c]);
+
+            for (size_t d = 0; d < detections[c].size(); d++) {
+                reports[c].nb_candidates++;
+                reports[c].nb_fitted += detections[c][d].nb_fitted_hypotheses;
+                reports[c].nb_aborted += detections[c][d].nb_aborted_hypotheses;
+                reports[c].nb_iterations += detections[c][d].nb_iterations;
+                reports[c].fit_time += detections[c][d].fit_time;
+                reports[c].nb_same_sign_type += detections[c][d].sign_type == detections[0][d].sign_type;
+            }
+        }
+    }
+
+    std::cout << "Hypothesis search over the test set -- early exit below " << early_exit_error << std::endl;
+    std::cout << std::setw(20) << "search" << std::setw(10) << "fitted" << std::setw(10) << "aborted"
+              << std::setw(10) << "skipped" << std::setw(12) << "iterations" << std::setw(12) << "saved"
+              << std::setw(12) << "time (ms)" << std::setw(15) << "same type" << std::endl;
+    for (int c = 0; c < 3; c++)
+        print_report(names[c], reports[c], reports[0]);
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+
+// By downloading, copying, installing or using the software you agree to this license.
+// If you do not agree to this license, do not download, install,
+// copy or use the software.
+
+
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//                        (3-clause BSD License)
+
+// Copyright (C) 2015,
+// 	  Guillaume Lemaitre (g.lemaitre58@gmail.com),
+// 	  Johan Massich (mailsik@gmail.com),
+// 	  Gerard Bahi (zomeck@gmail.com),
+// 	  Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+// Third party copyrights are property of their respective owners.
+
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+
+//   * Neither the names of the copyright holders nor the names of the contributors
+//     may be used to endorse or promote products derived from this software
+//     without specific prior written permission.
+
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+
+// our own code
+#include <img_processing/colorConversion.h>
+
+// stl library
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+
+// OpenCV library
+#include <opencv2/opencv.hpp>
+
+// Number of runs averaged for each measure
+#define NB_RUNS 50
+
+// Previous implementation of rgb_to_log_rb -- overlapping tiles and at<>() accessors
+static void legacy_rgb_to_log_rb(const cv::Mat& rgbImage, std::vector< cv::Mat >& log_chromatic_image) {
+
+    log_chromatic_image.resize(2);
+    cv::Mat& log_chromatic_r = log_chromatic_image[0];
+    cv::Mat& log_chromatic_b = log_chromatic_image[1];
+    log_chromatic_r.create(rgbImage.size(), CV_32F);
+    log_chromatic_b.create(rgbImage.size(), CV_32F);
+    log_chromatic_r.setTo(cv::Scalar(0));
+    log_chromatic_b.setTo(cv::Scalar(0));
+
+    const int blockIter = 64;
+    const int Niiter = std::max(1, int(std::ceil(float(rgbImage.rows)/blockIter)));
+    const int Njiter = std::max(1, int(std::ceil(float(rgbImage.cols)/blockIter)));
+
+    for (int iit = 0; iit <= Niiter; ++iit) {
+        for (int i = iit*blockIter ; i < iit*(blockIter+1); i++) {
+            if (i >= rgbImage.rows)
+                break;
+            for (int jit = 0; jit <= Njiter; ++jit) {
+                for (int j = jit*blockIter; j < jit*(blockIter+1); j++) {
+                    if (j >= rgbImage.cols)
+                        break;
+                    const cv::Vec3b px = rgbImage.at<cv::Vec3b>(i, j);
+                    const float division = 1.0f / static_cast<float> (px[1] == 0 ? px[1] + 1 : px[1]);
+                    log_chromatic_r.at<float>(i, j) = std::log(static_cast<float> (px[2])*division);
+                    log_chromatic_b.at<float>(i, j) = std::log(static_cast<float> (px[0])*division);
+                }
+            }
+        }
+    }
+}
+
+// Previous implementation of rgb_to_log_rb with the tile bounds fixed -- same at<>() accessors, every pixel computed once
+static void legacy_full_rgb_to_log_rb(const cv::Mat& rgbImage, std::vector< cv::Mat >& log_chromatic_image) {
+
+    log_chromatic_image.resize(2);
+    cv::Mat& log_chromatic_r = log_chromatic_image[0];
+    cv::Mat& log_chromatic_b = log_chromatic_image[1];
+    log_chromatic_r.create(rgbImage.size(), CV_32F);
+    log_chromatic_b.create(rgbImage.size(), CV_32F);
+
+    const int blockIter = 64;
+    for (int ii = 0; ii < rgbImage.rows; ii += blockIter) {
+        for (int jj = 0; jj < rgbImage.cols; jj += blockIter) {
+            for (int i = ii; i < std::min(ii + blockIter, rgbImage.rows); i++) {
+                for (int j = jj; j < std::min(jj + blockIter, rgbImage.cols); j++) {
+                    const cv::Vec3b px = rgbImage.at<cv::Vec3b>(i, j);
+                    const float division = 1.0f / static_cast<float> (px[1] == 0 ? px[1] + 1 : px[1]);
+                    log_chromatic_r.at<float>(i, j) = std::log(static_cast<float> (px[2])*division);
+                    log_chromatic_b.at<float>(i, j) = std::log(static_cast<float> (px[0])*division);
+                }
+            }
+        }
+    }
+}
+
+// Mean elapsed time of a function (in ms)
+template< typename Function >
+static double mean_time_ms(Function func) {
+    // First call to allocate the outputs
+    func();
+    const std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+    for (int run = 0; run < NB_RUNS; ++run)
+        func();
+    const std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+    return elapsed_seconds.count() * 1000.0 / NB_RUNS;
+}
+
+int main() {
+
+    const std::string filenames[] = { "/circular0009.jpg", "/different0011.jpg", "/different0035.jpg",
+                                      "/octogonal0010.jpg", "/octogonal0017.jpg", "/triangular0016.jpg" };
+
+    // legacy only computes the pixels of its overlapping tiles (see coverage), legacy full computes all of them with the same accessors --
+    // the speed-up is measured against legacy full
+    std::cout << "Mean of " << NB_RUNS << " runs (ms)" << std::endl;
+    std::cout << std::setw(20) << "image" << std::setw(12) << "legacy" << std::setw(14) << "legacy full" << std::setw(12) << "tiled"
+              << std::setw(12) << "tiled fast" << std::setw(10) << "speed-up" << std::setw(16) << "coverage" << std::endl;
+
+    for (size_t i = 0; i < sizeof(filenames) / sizeof(filenames[0]); i++) {
+        const cv::Mat rgb_image = cv::imread(std::string(TEST_DATA_DIR) + filenames[i]);
+        if (!rgb_image.data) {
+            std::cout << "Error to read the image " << filenames[i] << std::endl;
+            return -1;
+        }
+
+        std::vector< cv::Mat > log_legacy, log_legacy_full, log_tiled, log_fast;
+        const double t_legacy = mean_time_ms([&]() { legacy_rgb_to_log_rb(rgb_image, log_legacy); });
+        const double t_legacy_full = mean_time_ms([&]() { legacy_full_rgb_to_log_rb(rgb_image, log_legacy_full); });
+        const double t_tiled = mean_time_ms([&]() { colorconversion::rgb_to_log_rb(rgb_image, log_tiled); });
+        const double t_fast = mean_time_ms([&]() { colorconversion::rgb_to_log_rb_fast(rgb_image, log_fast); });
+
+        // Ratio of the pixels on which the previous implementation agrees -- most of the pixels were never computed
+        cv::Mat computed = (log_legacy[0] == log_tiled[0]) & (log_legacy[1] == log_tiled[1]);
+        const double ratio = static_cast<double> (cv::countNonZero(computed)) / rgb_image.total();
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << std::setw(20) << filenames[i].substr(1)
+                  << std::setw(12) << t_legacy << std::setw(14) << t_legacy_full << std::setw(12) << t_tiled << std::setw(12) << t_fast
+                  << std::setw(10) << t_legacy_full / t_fast << std::setw(15) << 100.0 * ratio << "%" << std::endl;
+    }
+
+    return 0;
+}
@@ -41,47 +41,101 @@
 // the use of this software, even if advised of the possibility of such damage.
 
 // our own code
-#include <img_processing/segmentation.h>
-#include <img_processing/colorConversion.h>
-#include <img_processing/imageProcessing.h>
-#include <img_processing/contour.h>
-#include <optimization/smartOptimisation.h>
-#include <common/math_utils.h>
-#include <common/timer.h>
+#include <detection/trafficSignDetector.h>
+#include <detection/pipelinedDetector.h>
+#include <common/boundedQueue.h>
 
 // stl library
 #include <string>
+#include <vector>
 #include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <deque>
+#include <thread>
 #include <chrono>
 #include <ctime>
-#include <limits>
+#include <cmath>
+#include <cctype>
 
 // OpenCV library
 #include <opencv2/opencv.hpp>
 
-// Eigen library
-#include <Eigen/Core>
-
+// Number of frames buffered between the threads of the streaming mode
+#define STREAM_QUEUE_SIZE 4
+
+typedef std::chrono::time_point<std::chrono::system_clock> TimePoint;
+
+// Frame read from a stream
+struct StreamFrame {
+    size_t index;
+    cv::Mat image;
+    TimePoint read_time;
+};
+
+// Detections of a frame of a stream
+struct StreamResult {
+    size_t index;
+    std::vector< detection::Detection > detections;
+    detection::DetectionTimings timings;
+    TimePoint read_time;
+};
+
+// Elapsed time between two time points (in ms)
+static double elapsed_ms(const TimePoint& start, const TimePoint& end) {
+    const std::chrono::duration<double> elapsed_seconds = end - start;
+    return elapsed_seconds.count() * 1000.0;
+}
 
-//TODO: code here should be abstracted outside the app, modify tests accordingly
-int main(int argc, char *argv[]) {
+// Percentile of a set of measures -- nearest rank
+static double percentile(std::vector< double > values, const double& p) {
+    if (values.empty())
+        return 0.0;
+    const size_t rank = std::min(values.size(), static_cast<size_t> (std::max(1.0, std::ceil(p / 100.0 * values.size())))) - 1;
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
 
-    // Chec the number of arguments
-    if (argc != 2) {
-        std::cout << "********************************" << std::endl;
-        std::cout << "Usage of the code: ./traffic-sign-detection imageFileName.extension" << std::endl;
-        std::cout << "********************************" << std::endl;
+static void print_usage() {
+    std::cout << "********************************" << std::endl;
+    std::cout << "Usage of the code: ./traffic-sign-detection imageFileName.extension [red|blue|all]" << std::endl;
+    std::cout << "                   ./traffic-sign-detection --stream videoFile|cameraIndex|imagePattern [red|blue|all]" << std::endl;
+    std::cout << "The image pattern of a numbered sequence is given as frames/%06d.png" << std::endl;
+    std::cout << "********************************" << std::endl;
+}
 
-        return -1;
+// Colour of the traffic signs to detect
+static bool parse_colour(const std::string& colour, detection::DetectorConfig& config) {
+    if (colour == "red")
+        config.labels = SEG_MASK_RED;
+    else if (colour == "blue")
+        config.labels = SEG_MASK_BLUE;
+    else if (colour == "all")
+        config.labels = SEG_MASK_ALL;
+    else {
+        std::cout << "Unknown colour ''" << colour << "'', use red, blue or all" << std::endl;
+        return false;
     }
+    return true;
+}
+
+// Open a video file, a camera or a numbered image sequence
+static bool open_capture(const std::string& source, cv::VideoCapture& capture) {
+    // A source made of digits only is a camera index
+    if (!source.empty() && std::all_of(source.begin(), source.end(), ::isdigit))
+        capture.open(std::stoi(source));
+    else
+        capture.open(source);
+    return capture.isOpened();
+}
+
+// Detection on a single image -- the result is displayed until a key is pressed
+static int run_image(const std::string& input_filename, const detection::DetectorConfig& config) {
 
     // Clock for measuring the elapsed time
     std::chrono::time_point<std::chrono::system_clock> start, end;
     start = std::chrono::system_clock::now();
 
-    // Read the input image - convert char* to string
-    std::string input_filename(argv[1]);
-
     // Read the input image
     cv::Mat input_image = cv::imread(input_filename);
 
@@ -93,193 +147,35 @@ int main(int argc, char *argv[]) {
     // Check that the image read is a 3 channels image
     CV_Assert(input_image.channels() == 3);
 
-
-    /*
-   * Conversion of the image in some specific color space
-   */
-
-    // Conversion of the rgb image in ihls color space
-    cv::Mat ihls_image;
-    colorconversion::convert_rgb_to_ihls(input_image, ihls_image);
-    // Conversion from RGB to logarithmic chromatic red and blue
-    std::vector< cv::Mat > log_image;
-    colorconversion::rgb_to_log_rb(input_image, log_image);
-
-    /*
-   * Segmentation of the image using the previous transformation
-   */
-
-    // Segmentation of the IHLS and more precisely of the normalised hue channel
-    // ONE PARAMETER TO CONSIDER - COLOR OF THE TRAFFIC SIGN TO DETECT - RED VS BLUE
-    int nhs_mode = 0; // nhs_mode == 0 -> red segmentation / nhs_mode == 1 -> blue segmentation
-    cv::Mat nhs_image_seg_red;
-
-    segmentation::seg_norm_hue(ihls_image, nhs_image_seg_red, nhs_mode);
-    //nhs_mode = 1; // nhs_mode == 0 -> red segmentation / nhs_mode == 1 -> blue segmentation
-    //cv::Mat nhs_image_seg_blue;
-    cv::Mat nhs_image_seg_blue = nhs_image_seg_red.clone();
-    //segmentation::seg_norm_hue(ihls_image, nhs_image_seg_blue, nhs_mode);
-    // Segmentation of the log chromatic image
-    // TODO - DEFINE THE THRESHOLD FOR THE BLUE TRAFFIC SIGN. FOR NOW WE AVOID THE PROCESSING FOR BLUE SIGN AND LET ONLY THE OTHER METHOD TO TAKE CARE OF IT.
-    cv::Mat log_image_seg;
-    segmentation::seg_log_chromatic(log_image, log_image_seg);
-
-    /*
-   * Merging and filtering of the previous segmentation
-   */
-
-    // Merge the results of previous segmentation using an OR operator
-    // Pre-allocation of an image by cloning a previous image
-    cv::Mat merge_image_seg_with_red = nhs_image_seg_red.clone();
-    cv::Mat merge_image_seg = nhs_image_seg_blue.clone();
-    cv::bitwise_or(nhs_image_seg_red, log_image_seg, merge_image_seg_with_red);
-    cv::bitwise_or(nhs_image_seg_blue, merge_image_seg_with_red, merge_image_seg);
-
-    // Filter the image using median filtering and morpho math
-    cv::Mat bin_image;
-    imageprocessing::filter_image(merge_image_seg, bin_image);
-
-
-    cv::imwrite("seg.jpg", bin_image);
-
-    /*
-   * Extract candidates (i.e., contours) and remove inconsistent candidates
-   */
-
-    std::vector< std::vector< cv::Point > > distorted_contours;
-    imageprocessing::contours_extraction(bin_image, distorted_contours);
-
-    /*
-   * Correct the distortion for each contour
-   */
-
-    // Initialisation of the variables which will be returned after the distortion. These variables are linked with the transformation applied to correct the distortion
-    std::vector< cv::Mat > rotation_matrix(distorted_contours.size());
-    std::vector< cv::Mat > scaling_matrix(distorted_contours.size());
-    std::vector< cv::Mat > translation_matrix(distorted_contours.size());
-    for (unsigned int contour_idx = 0; contour_idx < distorted_contours.size(); contour_idx++) {
-        rotation_matrix[contour_idx] = cv::Mat::eye(3, 3, CV_32F);
-        scaling_matrix[contour_idx] = cv::Mat::eye(3, 3, CV_32F);
-        translation_matrix[contour_idx] = cv::Mat::eye(3, 3, CV_32F);
-    }
-
-    // Correct the distortion
-    std::vector< std::vector< cv::Point2f > > undistorted_contours;
-    imageprocessing::correction_distortion(distorted_contours, undistorted_contours, translation_matrix, rotation_matrix, scaling_matrix);
-
-    // Normalise the contours to be inside a unit circle
-    std::vector<double> factor_vector(undistorted_contours.size());
-    std::vector< std::vector< cv::Point2f > > normalised_contours;
-    initopt::normalise_all_contours(undistorted_contours, normalised_contours, factor_vector);
-
-    std::vector< std::vector< cv::Point2f > > detected_signs_2f(normalised_contours.size());
-    std::vector< std::vector< cv::Point > > detected_signs(normalised_contours.size());
-
-    // For each contours
-    for (unsigned int contour_idx = 0; contour_idx < normalised_contours.size(); contour_idx++) {
-
-        Timer tmr("for each contours");
-        // For each type of traffic sign
-        /*
-     * sign_type = 0 -> nb_edges = 3;  gielis_sym = 6; radius
-     * sign_type = 1 -> nb_edges = 4;  gielis_sym = 4; radius
-     * sign_type = 2 -> nb_edges = 12; gielis_sym = 4; radius
-     * sign_type = 3 -> nb_edges = 8;  gielis_sym = 8; radius
-     * sign_type = 4 -> nb_edges = 3;  gielis_sym = 6; radius / 2
-     */
-
-        Timer tmrSgnType("For signType");
-        optimisation::ConfigStruct_<double> final_config;
-        double best_fit = std::numeric_limits<double>::infinity();
-        //int type_sign_to_keep = 0;
-        for (int sign_type = 0; sign_type < 5; sign_type++) {
-            Timer tmrIteration(" for_signType_iter");
-
-            // Check the center mass for a contour
-            cv::Point2f mass_center = initopt::mass_center_discovery(input_image, translation_matrix[contour_idx],
-                                                                     rotation_matrix[contour_idx], scaling_matrix[contour_idx],
-                                                                     normalised_contours[contour_idx], factor_vector[contour_idx],
-                                                                     sign_type);
-
-            // Find the rotation offset
-            double rot_offset = initopt::rotation_offset(normalised_contours[contour_idx]);
-
-            // Declaration of the parameters of the gielis with the default parameters
-            optimisation::ConfigStruct_<double> contour_config;
-            // Set the number of symmetry
-            int gielis_symmetry = 0;
-            switch (sign_type) {
-            case 0:
-                gielis_symmetry = 6;
-                break;
-            case 1:
-                gielis_symmetry = 4;
-                break;
-            case 2:
-                gielis_symmetry = 4;
-                break;
-            case 3:
-                gielis_symmetry = 8;
-                break;
-            case 4:
-                gielis_symmetry = 6;
-                break;
-            }
-            contour_config.p = gielis_symmetry;
-            // Set the rotation matrix
-            contour_config.theta_offset = rot_offset;
-            // Set the mass center
-            contour_config.x_offset = mass_center.x;
-            contour_config.y_offset = mass_center.y;
-
-            Timer tmrOpt("\t for_signType_gielisOptimization");
-            // Go for the optimisation
-            Eigen::Vector4d mean_err(0,0,0,0), std_err(0,0,0,0);
-            optimisation::gielis_optimisation(normalised_contours[contour_idx], contour_config, mean_err, std_err);
-
-            mean_err = mean_err.cwiseAbs();
-            double err_fit = mean_err.sum();
-
-            if (err_fit < best_fit) {
-                best_fit = err_fit;
-                final_config = contour_config;
-                //type_sign_to_keep = sign_type;
-            }
-        }
-
-        Timer tmr2("Reconstruct contour");
-
-        // Reconstruct the contour
-        std::cout << "Contour #" << contour_idx << ":\n" << final_config << std::endl;
-        std::vector< cv::Point2f > gielis_contour;
-        int nb_points = 1000;
-        optimisation::gielis_reconstruction(final_config, gielis_contour, nb_points);
-        std::vector< cv::Point2f > denormalised_gielis_contour;
-        initopt::denormalise_contour(gielis_contour, denormalised_gielis_contour, factor_vector[contour_idx]);
-        std::vector< cv::Point2f > distorted_gielis_contour;
-        imageprocessing::inverse_transformation_contour(denormalised_gielis_contour, distorted_gielis_contour,
-                                                        translation_matrix[contour_idx], rotation_matrix[contour_idx],
-                                                        scaling_matrix[contour_idx]);
-
-        // Transform to cv::Point to show the results
-        std::vector< cv::Point > distorted_gielis_contour_int(distorted_gielis_contour.size());
-        for (unsigned int i = 0; i < distorted_gielis_contour.size(); i++) {
-            distorted_gielis_contour_int[i].x = (int) std::round(distorted_gielis_contour[i].x);
-            distorted_gielis_contour_int[i].y = (int) std::round(distorted_gielis_contour[i].y);
-        }
-
-        detected_signs_2f[contour_idx] = distorted_gielis_contour;
-        detected_signs[contour_idx] = distorted_gielis_contour_int;
-
-    }
+    // Detect the traffic signs
+    detection::TrafficSignDetector detector(config);
+    std::vector< detection::Detection > detections;
+    detector.detect(input_image, detections);
 
     end = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsed_seconds = end-start;
     std::time_t end_time = std::chrono::system_clock::to_time_t(end);
 
+    const detection::DetectionTimings& timings = detector.timings();
+    for (size_t contour_idx = 0; contour_idx < detections.size(); contour_idx++)
+        std::cout << "Contour #" << contour_idx << " (sign type " << detections[contour_idx].sign_type
+                  << ", fit error " << detections[contour_idx].fit_error << "):\n" << detections[contour_idx].config << std::endl;
+
+    std::cout << "Segmentation: " << timings.segmentation << " ms\n"
+              << "Filtering: " << timings.filtering << " ms\n"
+              << "Extraction: " << timings.extraction << " ms\n"
+              << "Localisation: " << timings.localisation << " ms\n"
+              << "Fitting: " << timings.fitting << " ms\n"
+              << "Reconstruction: " << timings.reconstruction << " ms\n";
+
     std::cout << "Finished computation at " << std::ctime(&end_time)
               << "Elapsed time: " << elapsed_seconds.count()*1000 << " ms\n";
 
+    cv::imwrite("seg.jpg", detector.binary_image());
+
+    std::vector< std::vector< cv::Point > > detected_signs(detections.size());
+    for (size_t contour_idx = 0; contour_idx < detections.size(); contour_idx++)
+        detected_signs[contour_idx] = detections[contour_idx].contour;
 
     cv::Mat output_image = input_image.clone();
     cv::Scalar color(0,255,0);
@@ -291,3 +187,124 @@ int main(int argc, char *argv[]) {
 
     return 0;
 }
+
+// Detection on a stream -- the frames are read, detected and written by three threads linked by bounded queues,
+// the detection itself being pipelined across consecutive frames
+static int run_stream(const std::string& source, const detection::DetectorConfig& config) {
+
+    cv::VideoCapture capture;
+    if (!open_capture(source, capture)) {
+        std::cout << "Error to open the stream. Check ''cv::VideoCapture'' function of OpenCV" << std::endl;
+        return -1;
+    }
+
+    parallel::BoundedQueue< StreamFrame > frame_queue(STREAM_QUEUE_SIZE);
+    parallel::BoundedQueue< StreamResult > result_queue(STREAM_QUEUE_SIZE);
+
+    // Measures of every frame (in ms) -- only accessed by the writer
+    std::vector< double > segmentation, filtering, extraction, localisation, fitting, reconstruction, total, latency;
+
+    const TimePoint start = std::chrono::system_clock::now();
+
+    // Reader -- the capture may reuse its buffer, each frame is copied
+    std::thread reader([&]() {
+        cv::Mat image;
+        for (size_t index = 0; capture.read(image) && image.data; index++) {
+            StreamFrame frame;
+            frame.index = index;
+            frame.image = image.clone();
+            frame.read_time = std::chrono::system_clock::now();
+            if (!frame_queue.push(frame))
+                break;
+        }
+        frame_queue.close();
+    });
+
+    // Writer -- one line per detection as soon as the frame is processed
+    std::thread writer([&]() {
+        std::cout << "frame,sign_type,fit_error,x,y,width,height" << std::endl;
+        StreamResult result;
+        while (result_queue.pop(result)) {
+            for (size_t contour_idx = 0; contour_idx < result.detections.size(); contour_idx++) {
+                const detection::Detection& detection = result.detections[contour_idx];
+                const cv::Rect box = cv::boundingRect(detection.contour);
+                std::cout << result.index << "," << detection.sign_type << "," << detection.fit_error << ","
+                          << box.x << "," << box.y << "," << box.width << "," << box.height << "\n";
+            }
+            std::cout.flush();
+
+            segmentation.push_back(result.timings.segmentation);
+            filtering.push_back(result.timings.filtering);
+            extraction.push_back(result.timings.extraction);
+            localisation.push_back(result.timings.localisation);
+            fitting.push_back(result.timings.fitting);
+            reconstruction.push_back(result.timings.reconstruction);
+            total.push_back(result.timings.total);
+            latency.push_back(elapsed_ms(result.read_time, std::chrono::system_clock::now()));
+        }
+    });
+
+    // Detection -- the results leave the pipeline in the order of the frames
+    detection::PipelinedDetector detector(config);
+    std::deque< StreamFrame > pending_frames;
+    const auto retrieve_oldest = [&]() {
+        StreamResult result;
+        result.index = pending_frames.front().index;
+        result.read_time = pending_frames.front().read_time;
+        detector.retrieve(result.detections, result.timings);
+        pending_frames.pop_front();
+        result_queue.push(result);
+    };
+    StreamFrame frame;
+    while (frame_queue.pop(frame)) {
+        CV_Assert(frame.image.channels() == 3);
+        while (!detector.submit(frame.image))
+            retrieve_oldest();
+        pending_frames.push_back(frame);
+    }
+    while (!pending_frames.empty())
+        retrieve_oldest();
+    result_queue.close();
+
+    reader.join();
+    writer.join();
+
+    const double elapsed = elapsed_ms(start, std::chrono::system_clock::now());
+    const size_t nb_frames = total.size();
+
+    std::cerr << "Frames: " << nb_frames << ", sustained rate: "
+              << (elapsed > 0.0 ? 1000.0 * nb_frames / elapsed : 0.0) << " FPS" << std::endl;
+
+    // Percentiles of each stage (in ms)
+    const std::string names[] = { "Segmentation", "Filtering", "Extraction", "Localisation", "Fitting", "Reconstruction", "Detection", "Latency" };
+    const std::vector< double >* measures[] = { &segmentation, &filtering, &extraction, &localisation, &fitting, &reconstruction, &total, &latency };
+    std::cerr << std::setw(16) << "stage (ms)" << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << std::endl;
+    for (size_t stage = 0; stage < sizeof(names) / sizeof(names[0]); stage++)
+        std::cerr << std::fixed << std::setprecision(2) << std::setw(16) << names[stage]
+                  << std::setw(10) << percentile(*measures[stage], 50.0)
+                  << std::setw(10) << percentile(*measures[stage], 90.0)
+                  << std::setw(10) << percentile(*measures[stage], 99.0) << std::endl;
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+    // Check the number of arguments
+    const bool stream = (argc > 1) && (std::string(argv[1]) == "--stream");
+    const int first_arg = stream ? 2 : 1;
+    if (argc != first_arg + 1 && argc != first_arg + 2) {
+        print_usage();
+        return -1;
+    }
+
+    // Colour of the traffic signs to detect -- red by default
+    detection::DetectorConfig config;
+    if (argc == first_arg + 2 && !parse_colour(argv[first_arg + 1], config))
+        return -1;
+
+    // Read the input - convert char* to string
+    const std::string input(argv[first_arg]);
+
+    return stream ? run_stream(input, config) : run_image(input, config);
+}
@@ -0,0 +1,118 @@
+
+// By downloading, copying, installing or using the software you agree to this license.
+// If you do not agree to this license, do not download, install,
+// copy or use the software.
+
+
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//                        (3-clause BSD License)
+
+// Copyright (C) 2015,
+// 	  Guillaume Lemaitre (g.lemaitre58@gmail.com),
+// 	  Johan Massich (mailsik@gmail.com),
+// 	  Gerard Bahi (zomeck@gmail.com),
+// 	  Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+// Third party copyrights are property of their respective owners.
+
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+
+//   * Neither the names of the copyright holders nor the names of the contributors
+//     may be used to endorse or promote products derived from this software
+//     without specific prior written permission.
+
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+
+// our own code
+#include <img_processing/colorConversion.h>
+#include <img_processing/segmentation.h>
+
+// stl library
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+
+// OpenCV library
+#include <opencv2/opencv.hpp>
+
+// Number of runs averaged for each measure
+#define NB_RUNS 10
+
+// Mean elapsed time of a function (in ms)
+template< typename Function >
+static double mean_time_ms(Function func) {
+    // First call to allocate the outputs and wake up the threads
+    func();
+    const std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+    for (int run = 0; run < NB_RUNS; ++run)
+        func();
+    const std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+    return elapsed_seconds.count() * 1000.0 / NB_RUNS;
+}
+
+int main(int argc, char *argv[]) {
+
+    // Maximum number of threads -- 16 by default
+    const int max_threads = (argc > 1) ? std::atoi(argv[1]) : 16;
+    if (max_threads < 1) {
+        std::cout << "Usage of the code: ./segmentation_benchmark [maxNumberOfThreads]" << std::endl;
+        return -1;
+    }
+
+    // Random 4K frame
+    cv::Mat rgb_image(2160, 3840, CV_8UC3);
+    cv::randu(rgb_image, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    cv::Mat ihls_image, nhs_image_seg, log_image_seg, seg_image;
+    std::vector< cv::Mat > log_image;
+    colorconversion::convert_rgb_to_ihls(rgb_image, ihls_image);
+    colorconversion::rgb_to_log_rb(rgb_image, log_image);
+
+    std::cout << "Frame " << rgb_image.cols << "x" << rgb_image.rows << ", mean of " << NB_RUNS << " runs (ms)" << std::endl;
+    std::cout << std::setw(8) << "threads"
+              << std::setw(14) << "rgb_to_ihls" << std::setw(14) << "rgb_to_log_rb"
+              << std::setw(14) << "seg_norm_hue" << std::setw(14) << "seg_log_chr"
+              << std::setw(14) << "seg_fused" << std::setw(10) << "speed-up" << std::endl;
+
+    double reference = 0.0;
+    for (int nb_threads = 1; nb_threads <= max_threads; nb_threads *= 2) {
+        const double t_ihls = mean_time_ms([&]() { colorconversion::convert_rgb_to_ihls(rgb_image, ihls_image, nb_threads); });
+        const double t_log = mean_time_ms([&]() { colorconversion::rgb_to_log_rb(rgb_image, log_image, nb_threads); });
+        const double t_nhs = mean_time_ms([&]() { segmentation::seg_norm_hue(ihls_image, nhs_image_seg, 0, R_HUE_MAX, R_HUE_MIN, R_SAT_MIN, nb_threads); });
+        const double t_log_seg = mean_time_ms([&]() { segmentation::seg_log_chromatic(log_image, log_image_seg, nb_threads); });
+        const double t_fused = mean_time_ms([&]() { segmentation::seg_fused(rgb_image, seg_image, nb_threads); });
+
+        // Speed-up of the whole separate pipeline
+        const double total = t_ihls + t_log + t_nhs + t_log_seg;
+        if (nb_threads == 1)
+            reference = total;
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(8) << nb_threads
+                  << std::setw(14) << t_ihls << std::setw(14) << t_log
+                  << std::setw(14) << t_nhs << std::setw(14) << t_log_seg
+                  << std::setw(14) << t_fused << std::setw(10) << reference / total << std::endl;
+    }
+
+    return 0;
+}
@@ -50,6 +50,8 @@ add_subdirectory(img_processing)
 
 add_subdirectory(optimization)
 
+add_subdirectory(detection)
+
 add_subdirectory(apps)
 
 add_subdirectory(tests)
@@ -0,0 +1,99 @@
+/*
+By downloading, copying, installing or using the software you agree to this license.
+If you do not agree to this license, do not download, install,
+copy or use the software.
+
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2015,
+      Guillaume Lemaitre (g.lemaitre58@gmail.com),
+      Johan Massich (mailsik@gmail.com),
+      Gerard Bahi (zomeck@gmail.com),
+      Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are disclaimed.
+In no event shall copyright holders or contributors be liable for any direct,
+indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+#pragma once
+
+// stl library
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+namespace parallel {
+
+// Blocking queue with a maximum number of items -- the producers wait while the queue is full
+template< typename T >
+class BoundedQueue {
+public:
+    explicit BoundedQueue(const size_t& capacity) : m_capacity(capacity), m_closed(false) {}
+
+    // Add an item, waiting while the queue is full -- false if the queue has been closed
+    bool push(const T& item) {
+        std::unique_lock< std::mutex > lock(m_mutex);
+        m_not_full.wait(lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed)
+            return false;
+        m_items.push_back(item);
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    // Remove the oldest item, waiting while the queue is empty -- false once the queue is closed and empty
+    bool pop(T& item) {
+        std::unique_lock< std::mutex > lock(m_mutex);
+        m_not_empty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+        if (m_items.empty())
+            return false;
+        item = m_items.front();
+        m_items.pop_front();
+        m_not_full.notify_one();
+        return true;
+    }
+
+    // No more items can be pushed -- the remaining items can still be popped
+    void close() {
+        std::lock_guard< std::mutex > lock(m_mutex);
+        m_closed = true;
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+    }
+
+private:
+    const size_t m_capacity;
+    bool m_closed;
+    std::deque< T > m_items;
+    std::mutex m_mutex;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+};
+
+}
@@ -0,0 +1,108 @@
+/*
+By downloading, copying, installing or using the software you agree to this license.
+If you do not agree to this license, do not download, install,
+copy or use the software.
+
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2015,
+      Guillaume Lemaitre (g.lemaitre58@gmail.com),
+      Johan Massich (mailsik@gmail.com),
+      Gerard Bahi (zomeck@gmail.com),
+      Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are disclaimed.
+In no event shall copyright holders or contributors be liable for any direct,
+indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+#include "parallel.h"
+
+// stl library
+#include <algorithm>
+#include <atomic>
+
+// Adapter of a RangeBody for cv::parallel_for_ -- the lambda overload does not exist in OpenCV 2.4
+class RangeLoopBody : public cv::ParallelLoopBody {
+public:
+    explicit RangeLoopBody(const parallel::RangeBody& body) : m_body(body) {}
+
+    void operator()(const cv::Range& range) const { m_body(range); }
+
+private:
+    const parallel::RangeBody& m_body;
+};
+
+// Default backend -- the thread pool of OpenCV
+static void opencv_executor(const cv::Range& range, const parallel::RangeBody& body, const int& nb_stripes) {
+    cv::parallel_for_(range, RangeLoopBody(body), static_cast<double> (nb_stripes));
+}
+
+static parallel::Executor current_executor = opencv_executor;
+
+namespace parallel {
+
+// Replace the backend of the parallel loops
+void set_executor(const Executor& executor) {
+    current_executor = executor ? executor : Executor(opencv_executor);
+}
+
+// Number of stripes used for a number of threads
+int nb_stripes(const int& nb_threads) {
+    return (nb_threads > 0) ? nb_threads : std::max(1, cv::getNumThreads());
+}
+
+// Run a body over a range with at most nb_threads threads
+void for_each_range(const cv::Range& range, const RangeBody& body, const int& nb_threads) {
+
+    if (range.end <= range.start)
+        return;
+
+    // Never create more stripes than indices
+    const int stripes = std::min(nb_stripes(nb_threads), range.end - range.start);
+    if (stripes <= 1) {
+        body(range);
+        return;
+    }
+
+    current_executor(range, body, stripes);
+}
+
+// Run a body on each index with at most nb_threads threads
+void for_each_index(const int& count, const std::function< void(const int&) >& body, const int& nb_threads) {
+
+    // Each stripe is a worker taking the indices one at a time until none is left
+    std::atomic< int > next_index(0);
+    const int nb_workers = std::min(nb_stripes(nb_threads), count);
+    for_each_range(cv::Range(0, nb_workers), [&](const cv::Range&) {
+        for (int index = next_index++; index < count; index = next_index++)
+            body(index);
+    }, nb_threads);
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+By downloading, copying, installing or using the software you agree to this license.
+If you do not agree to this license, do not download, install,
+copy or use the software.
+
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2015,
+      Guillaume Lemaitre (g.lemaitre58@gmail.com),
+      Johan Massich (mailsik@gmail.com),
+      Gerard Bahi (zomeck@gmail.com),
+      Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are disclaimed.
+In no event shall copyright holders or contributors be liable for any direct,
+indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+#pragma once
+
+// stl library
+#include <functional>
+
+// OpenCV library
+#include <opencv2/opencv.hpp>
+
+namespace parallel {
+
+// Body of a parallel loop -- processes the indices [range.start, range.end)
+typedef std::function< void(const cv::Range&) > RangeBody;
+
+// Backend running a body over a range split in nb_stripes sub-ranges
+typedef std::function< void(const cv::Range&, const RangeBody&, const int&) > Executor;
+
+// Replace the backend of the parallel loops -- an empty executor restores cv::parallel_for_
+void set_executor(const Executor& executor);
+
+// Number of stripes used for a number of threads -- 0 uses every thread of OpenCV
+int nb_stripes(const int& nb_threads);
+
+// Run a body over a range with at most nb_threads threads -- 1 runs the body serially in the calling thread
+void for_each_range(const cv::Range& range, const RangeBody& body, const int& nb_threads);
+
+// Run a body on each index of [0, count) with at most nb_threads threads -- the idle threads take the next index,
+// so that tasks of uneven duration are balanced between the threads
+void for_each_index(const int& count, const std::function< void(const int&) >& body, const int& nb_threads);
+
+}
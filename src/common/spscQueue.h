@@ -0,0 +1,156 @@
+/*
+By downloading, copying, installing or using the software you agree to this license.
+If you do not agree to this license, do not download, install,
+copy or use the software.
+
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2015,
+      Guillaume Lemaitre (g.lemaitre58@gmail.com),
+      Johan Massich (mailsik@gmail.com),
+      Gerard Bahi (zomeck@gmail.com),
+      Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are disclaimed.
+In no event shall copyright holders or contributors be liable for any direct,
+indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+#pragma once
+
+// stl library
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of attempts of a blocking push or pop before the thread sleeps
+#define SPSC_QUEUE_SPIN_COUNT 256
+
+namespace parallel {
+
+// Lock-free ring buffer between one producer thread and one consumer thread -- the blocking push and pop spin
+// briefly, then sleep on a condition variable until the other side moves an item
+template< typename T >
+class SpscQueue {
+public:
+    explicit SpscQueue(const size_t& capacity) : m_items(capacity + 1), m_head(0), m_tail(0), m_nb_waiting(0) {}
+
+    // Add an item -- false if the queue is full
+    bool try_push(const T& item) {
+        if (!store(item))
+            return false;
+        wake();
+        return true;
+    }
+
+    // Remove the oldest item -- false if the queue is empty
+    bool try_pop(T& item) {
+        if (!load(item))
+            return false;
+        wake();
+        return true;
+    }
+
+    // Add an item, waiting while the queue is full
+    void push(const T& item) {
+        for (int attempt = 0; attempt < SPSC_QUEUE_SPIN_COUNT; attempt++) {
+            if (try_push(item))
+                return;
+            std::this_thread::yield();
+        }
+        wait([&]() { return store(item); });
+        wake();
+    }
+
+    // Remove the oldest item, waiting while the queue is empty
+    void pop(T& item) {
+        for (int attempt = 0; attempt < SPSC_QUEUE_SPIN_COUNT; attempt++) {
+            if (try_pop(item))
+                return;
+            std::this_thread::yield();
+        }
+        wait([&]() { return load(item); });
+        wake();
+    }
+
+    // Number of threads sleeping in push or pop
+    int nb_waiting() const { return m_nb_waiting.load(std::memory_order_relaxed); }
+
+private:
+    bool store(const T& item) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) % m_items.size();
+        if (next == m_head.load(std::memory_order_acquire))
+            return false;
+        m_items[tail] = item;
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool load(T& item) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        item = m_items[head];
+        m_head.store((head + 1) % m_items.size(), std::memory_order_release);
+        return true;
+    }
+
+    // Sleep until the operation succeeds -- the waiter is registered before the queue is checked again, so that
+    // either the check sees the item of the other side or the other side sees the waiter and notifies it
+    template< typename Operation >
+    void wait(const Operation& operation) {
+        std::unique_lock< std::mutex > lock(m_mutex);
+        m_nb_waiting.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!operation())
+            m_wakeup.wait(lock);
+        m_nb_waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Notify a sleeping thread after an item moved -- only takes the mutex when a thread sleeps
+    void wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_nb_waiting.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard< std::mutex > lock(m_mutex);
+            m_wakeup.notify_all();
+        }
+    }
+
+    // One slot is always left empty to tell a full queue from an empty one
+    std::vector< T > m_items;
+    std::atomic< size_t > m_head;
+    std::atomic< size_t > m_tail;
+    std::atomic< int > m_nb_waiting;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+};
+
+}
@@ -0,0 +1,144 @@
+/*
+By downloading, copying, installing or using the software you agree to this license.
+If you do not agree to this license, do not download, install,
+copy or use the software.
+
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2015,
+      Guillaume Lemaitre (g.lemaitre58@gmail.com),
+      Johan Massich (mailsik@gmail.com),
+      Gerard Bahi (zomeck@gmail.com),
+      Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are disclaimed.
+In no event shall copyright holders or contributors be liable for any direct,
+indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+// own library
+#include "pipelinedDetector.h"
+
+// Elapsed time since a given time point (in ms)
+static double elapsed_ms(const std::chrono::time_point<std::chrono::system_clock>& start) {
+    const std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+    return elapsed_seconds.count() * 1000.0;
+}
+
+namespace detection {
+
+PipelinedDetector::PipelinedDetector(const DetectorConfig& config, const size_t& queue_size) :
+    m_detector(config),
+    m_nb_pending(0)
+{
+    // One frame in each stage and queue_size frames waiting in front of each stage
+    const size_t nb_jobs = NB_PIPELINE_STAGES * (queue_size + 1);
+    for (size_t job_idx = 0; job_idx < nb_jobs; job_idx++) {
+        m_jobs.push_back(std::unique_ptr< Job > (new Job()));
+        m_free_jobs.push_back(m_jobs.back().get());
+    }
+
+    // The queues can hold every job -- pushing in a queue never waits
+    for (int queue_idx = 0; queue_idx <= NB_PIPELINE_STAGES; queue_idx++)
+        m_queues.push_back(std::unique_ptr< parallel::SpscQueue< Job* > > (new parallel::SpscQueue< Job* > (nb_jobs + 1)));
+
+    for (int stage = 0; stage < NB_PIPELINE_STAGES; stage++)
+        m_threads.push_back(std::thread(&PipelinedDetector::run_stage, this, stage));
+}
+
+PipelinedDetector::~PipelinedDetector() {
+    // The null job stops each stage after the frames in front of it
+    m_queues[0]->push(NULL);
+    for (size_t thread_idx = 0; thread_idx < m_threads.size(); thread_idx++)
+        m_threads[thread_idx].join();
+}
+
+// Push a frame in the pipeline
+bool PipelinedDetector::submit(const cv::Mat& input_image) {
+
+    // Check that the image is a 3 channels image
+    CV_Assert(input_image.channels() == 3);
+
+    if (m_free_jobs.empty())
+        return false;
+
+    Job* job = m_free_jobs.back();
+    m_free_jobs.pop_back();
+    job->image = input_image;
+    job->submit_time = std::chrono::system_clock::now();
+    m_queues[0]->push(job);
+    m_nb_pending++;
+    return true;
+}
+
+// Pop the detections of the oldest frame
+bool PipelinedDetector::retrieve(std::vector< Detection >& detections, DetectionTimings& timings) {
+
+    if (m_nb_pending == 0)
+        return false;
+
+    Job* job;
+    m_queues[NB_PIPELINE_STAGES]->pop(job);
+    job->timings.total = elapsed_ms(job->submit_time);
+    detections.swap(job->detections);
+    timings = job->timings;
+
+    // Release the reference on the image of the caller
+    job->image.release();
+    m_free_jobs.push_back(job);
+    m_nb_pending--;
+    return true;
+}
+
+// Run a stage on the jobs of its input queue
+void PipelinedDetector::run_stage(const int& stage) {
+
+    Job* job;
+    do {
+        m_queues[stage]->pop(job);
+        if (job) {
+            switch (stage) {
+            case 0:
+                m_detector.segment(job->image, job->buffers, job->timings);
+                break;
+            case 1:
+                m_detector.extract(job->buffers, job->timings);
+                break;
+            case 2:
+                m_detector.localise(job->image, job->buffers, job->timings);
+                break;
+            default:
+                m_detector.fit(job->buffers, job->detections, job->timings);
+            }
+        }
+        // The null job is forwarded to the next stage
+        m_queues[stage + 1]->push(job);
+    } while (job);
+}
+
+}
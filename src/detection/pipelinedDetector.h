@@ -0,0 +1,114 @@
+/*
+By downloading, copying, installing or using the software you agree to this license.
+If you do not agree to this license, do not download, install,
+copy or use the software.
+
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2015,
+      Guillaume Lemaitre (g.lemaitre58@gmail.com),
+      Johan Massich (mailsik@gmail.com),
+      Gerard Bahi (zomeck@gmail.com),
+      Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are disclaimed.
+In no event shall copyright holders or contributors be liable for any direct,
+indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+#pragma once
+
+// own library
+#include "trafficSignDetector.h"
+#include <common/spscQueue.h>
+
+// stl library
+#include <vector>
+#include <memory>
+#include <thread>
+#include <chrono>
+
+// Number of stages of the pipeline -- segmentation, extraction, localisation, fitting
+#define NB_PIPELINE_STAGES 4
+// Number of frames which can wait between two stages of the pipeline by default
+#define PIPELINE_QUEUE_SIZE 2
+
+namespace detection {
+
+// Detection engine running the stages of consecutive frames at the same time, one thread per stage --
+// the segmentation of frame N + 1 overlaps the fitting of frame N, each frame gives the same detections than TrafficSignDetector::detect
+class PipelinedDetector {
+public:
+    explicit PipelinedDetector(const DetectorConfig& config = DetectorConfig(), const size_t& queue_size = PIPELINE_QUEUE_SIZE);
+
+    // The frames still in the pipeline are processed and dropped
+    ~PipelinedDetector();
+
+    // Push a BGR frame in the pipeline -- false if the pipeline is full and the oldest result has to be retrieved first
+    // The image is shared and not copied: it must not be modified until its result has been retrieved
+    bool submit(const cv::Mat& input_image);
+
+    // Pop the detections of the oldest frame, waiting until they are ready -- false if no frame is in the pipeline
+    // The total timing is the time elapsed between the submission and the end of the last stage
+    bool retrieve(std::vector< Detection >& detections, DetectionTimings& timings);
+
+    // Number of frames in the pipeline
+    size_t nb_pending() const { return m_nb_pending; }
+
+    // Maximum number of frames in the pipeline
+    size_t capacity() const { return m_jobs.size(); }
+
+    const DetectorConfig& config() const { return m_detector.config(); }
+
+private:
+    // Frame going through the pipeline with its own buffers
+    struct Job {
+        cv::Mat image;
+        FrameBuffers buffers;
+        std::vector< Detection > detections;
+        DetectionTimings timings;
+        std::chrono::time_point<std::chrono::system_clock> submit_time;
+    };
+
+    // Run a stage on the jobs of its input queue until a null job is received
+    void run_stage(const int& stage);
+
+    // Only used through its const stages
+    TrafficSignDetector m_detector;
+
+    std::vector< std::unique_ptr< Job > > m_jobs;
+    // Jobs which are not in the pipeline -- only accessed by the calling thread
+    std::vector< Job* > m_free_jobs;
+    size_t m_nb_pending;
+
+    // Queue k feeds the stage k -- the last queue gives the results back to the calling thread
+    std::vector< std::unique_ptr< parallel::SpscQueue< Job* > > > m_queues;
+    std::vector< std::thread > m_threads;
+};
+
+}
@@ -0,0 +1,404 @@
+/*
+By downloading, copying, installing or using the software you agree to this license.
+If you do not agree to this license, do not download, install,
+copy or use the software.
+
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2015,
+      Guillaume Lemaitre (g.lemaitre58@gmail.com),
+      Johan Massich (mailsik@gmail.com),
+      Gerard Bahi (zomeck@gmail.com),
+      Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are disclaimed.
+In no event shall copyright holders or contributors be liable for any direct,
+indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+// own library
+#include "trafficSignDetector.h"
+#include <img_processing/segmentation.h>
+#include <img_processing/colorConversion.h>
+#include <img_processing/imageProcessing.h>
+#include <img_processing/contour.h>
+#include <common/parallel.h>
+
+// stl library
+#include <chrono>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+// Number of symmetries of the Gielis curve for each sign type
+static const int gielis_symmetry[NB_SIGN_TYPES] = { 6, 4, 4, 8, 6 };
+
+// Sign types localised by one pass of the radial symmetry detector -- same number of edges, different radii
+#define NB_LOCALISATION_GROUPS 4
+static const std::vector< int > localisation_groups[NB_LOCALISATION_GROUPS] = { { 0, 4 }, { 1 }, { 2 }, { 3 } };
+
+// Shape prior used to order the hypotheses of a candidate
+#define PRIOR_POLY_EPSILON 0.02     // tolerance of the polygonal approximation, relative to the perimeter
+#define PRIOR_MIN_SOLIDITY 0.90     // below this area / hull area ratio, the shape is not trusted
+#define PRIOR_MAX_TRIANGLE_COMPACTNESS 0.70 // compactness of a triangle: 0.60, square: 0.79, octagon: 0.95, circle: 1
+#define PRIOR_MIN_CIRCLE_COMPACTNESS 0.97
+
+// Order of the sign types from the most to the least likely, using a cheap description of the contour
+static void sign_type_order(const std::vector< cv::Point2f >& contour, int order[NB_SIGN_TYPES]) {
+
+    // Default order -- the shape is not reliable enough
+    for (int sign_type = 0; sign_type < NB_SIGN_TYPES; sign_type++)
+        order[sign_type] = sign_type;
+    if (contour.size() < 3)
+        return;
+
+    const double perimeter = cv::arcLength(contour, true);
+    const double area = cv::contourArea(contour);
+    std::vector< cv::Point2f > hull;
+    cv::convexHull(contour, hull);
+    const double hull_area = cv::contourArea(hull);
+    if (perimeter <= 0.0 || hull_area <= 0.0 || area / hull_area < PRIOR_MIN_SOLIDITY)
+        return;
+
+    std::vector< cv::Point2f > polygon;
+    cv::approxPolyDP(contour, polygon, PRIOR_POLY_EPSILON * perimeter, true);
+    const int nb_vertices = static_cast<int> (polygon.size());
+    const double compactness = 4.0 * M_PI * area / (perimeter * perimeter);
+
+    // Most likely sign types, the remaining ones keep the default order
+    std::vector< int > likely;
+    if (compactness < PRIOR_MAX_TRIANGLE_COMPACTNESS || nb_vertices == 3)
+        likely = { 0, 4 };
+    else if (compactness > PRIOR_MIN_CIRCLE_COMPACTNESS || nb_vertices > 8)
+        likely = { 2, 3 };
+    else if (nb_vertices == 4)
+        likely = { 1 };
+    else
+        likely = { 3, 2 };
+
+    int rank = 0;
+    for (size_t i = 0; i < likely.size(); i++)
+        order[rank++] = likely[i];
+    for (int sign_type = 0; sign_type < NB_SIGN_TYPES; sign_type++)
+        if (std::find(likely.begin(), likely.end(), sign_type) == likely.end())
+            order[rank++] = sign_type;
+}
+
+// Elapsed time since a given time point (in ms)
+static double elapsed_ms(const std::chrono::time_point<std::chrono::system_clock>& start) {
+    const std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+    return elapsed_seconds.count() * 1000.0;
+}
+
+namespace detection {
+
+TrafficSignDetector::TrafficSignDetector(const DetectorConfig& config) :
+    m_config(config)
+{
+    // The table is built once for the whole life of the detector
+    if (m_config.segmentation_mode == SEGMENTATION_LUT)
+        segmentation::build_seg_lut(m_seg_lut, m_config.lut_bits);
+}
+
+// Detect the traffic signs of a BGR image
+void TrafficSignDetector::detect(const cv::Mat& input_image, std::vector< Detection >& detections) {
+
+    // Check that the image is a 3 channels image
+    CV_Assert(input_image.channels() == 3);
+
+    const std::chrono::time_point<std::chrono::system_clock> start_total = std::chrono::system_clock::now();
+
+    segment(input_image, m_buffers, m_timings);
+    extract(m_buffers, m_timings);
+    localise(input_image, m_buffers, m_timings);
+    fit(m_buffers, detections, m_timings);
+
+    m_timings.total = elapsed_ms(start_total);
+}
+
+// Conversion, segmentation and merging of the masks
+void TrafficSignDetector::segment(const cv::Mat& input_image, FrameBuffers& buffers, DetectionTimings& timings) const {
+
+    const std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+
+    // Any other colour than red needs the label image
+    if (m_config.labels != SEG_MASK_RED) {
+        segment_labels(input_image, buffers);
+        segmentation::labels_to_mask(buffers.label_image, buffers.merge_image_seg, m_config.labels);
+    }
+    // Conversion and segmentation without any intermediate image
+    else if (m_config.segmentation_mode == SEGMENTATION_FUSED) {
+        segmentation::seg_fused(input_image, buffers.merge_image_seg, m_config.nb_threads);
+    }
+    // Red normalised hue and log chromatic labels read in the look-up table
+    else if (m_config.segmentation_mode == SEGMENTATION_LUT) {
+        segmentation::seg_lut(input_image, buffers.merge_image_seg, m_seg_lut, SEG_MASK_RED);
+    }
+    else {
+        // Conversion of the rgb image in ihls color space
+        colorconversion::convert_rgb_to_ihls_simd(input_image, buffers.ihls_image, colorconversion::SIMD_AUTO, m_config.nb_threads);
+
+        // Segmentation of the normalised hue channel -- red traffic signs
+        segmentation::seg_norm_hue(buffers.ihls_image, buffers.nhs_image_seg, 0, R_HUE_MAX, R_HUE_MIN, R_SAT_MIN, m_config.nb_threads);
+        // Segmentation of the log chromatic condition -- the ratio table avoids the logarithmic chromatic planes
+        segmentation::seg_log_chromatic_rgb(input_image, buffers.log_image_seg, m_config.nb_threads);
+
+        // Merge the results of previous segmentation using an OR operator
+        cv::bitwise_or(buffers.nhs_image_seg, buffers.log_image_seg, buffers.merge_image_seg);
+    }
+
+    timings.segmentation = elapsed_ms(start);
+}
+
+// Segmentation of the red and blue traffic signs into buffers.label_image
+void TrafficSignDetector::segment_labels(const cv::Mat& input_image, FrameBuffers& buffers) const {
+
+    if (m_config.segmentation_mode == SEGMENTATION_FUSED) {
+        segmentation::seg_fused_labels(input_image, buffers.label_image, m_config.nb_threads);
+        return;
+    }
+
+    if (m_config.segmentation_mode == SEGMENTATION_LUT) {
+        segmentation::seg_lut_labels(input_image, buffers.label_image, m_seg_lut);
+        return;
+    }
+
+    // Both colours are segmented in the same pass over the IHLS image
+    colorconversion::convert_rgb_to_ihls_simd(input_image, buffers.ihls_image, colorconversion::SIMD_AUTO, m_config.nb_threads);
+    segmentation::seg_norm_hue_labels(buffers.ihls_image, buffers.label_image, m_config.nb_threads);
+    segmentation::seg_log_chromatic_rgb(input_image, buffers.log_image_seg, m_config.nb_threads);
+
+    // Add the log chromatic label
+    cv::bitwise_and(buffers.log_image_seg, cv::Scalar(SEG_LABEL_LOG), buffers.log_image_seg);
+    cv::bitwise_or(buffers.label_image, buffers.log_image_seg, buffers.label_image);
+}
+
+// Filter the mask, then extract, undistort and normalise the candidates
+void TrafficSignDetector::extract(FrameBuffers& buffers, DetectionTimings& timings) const {
+
+    // Filter the image using median filtering and morpho math
+    std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+    imageprocessing::filter_image_binary(buffers.merge_image_seg, buffers.bin_image, buffers.filter_work_image, m_config.nb_threads);
+    timings.filtering = elapsed_ms(start);
+
+    start = std::chrono::system_clock::now();
+
+    // Extract candidates (i.e., contours) and remove inconsistent candidates
+    imageprocessing::contours_extraction(buffers.bin_image, buffers.distorted_contours);
+
+    // Correct the distortion
+    imageprocessing::correction_distortion(buffers.distorted_contours, buffers.undistorted_contours, buffers.transforms);
+
+    // Normalise the contours to be inside a unit circle
+    initopt::normalise_all_contours(buffers.undistorted_contours, buffers.normalised_contours, buffers.transforms.factor);
+
+    timings.extraction = elapsed_ms(start);
+}
+
+// Rotation offset and mass center of each candidate and hypothesis
+void TrafficSignDetector::localise(const cv::Mat& input_image, FrameBuffers& buffers, DetectionTimings& timings) const {
+
+    const std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+
+    // Find the rotation offset, warp the ROI around each candidate and compute its gradients -- they do not depend on the type of traffic sign
+    const size_t nb_contours = buffers.normalised_contours.size();
+    buffers.rotation_offsets.resize(nb_contours);
+    buffers.roi_images.resize(nb_contours);
+    buffers.roi_gradients.resize(nb_contours);
+    buffers.roi_dimensions.resize(nb_contours);
+    buffers.roi_radii.resize(nb_contours);
+    parallel::for_each_index(static_cast<int> (nb_contours), [&](const int& contour_idx) {
+        buffers.rotation_offsets[contour_idx] = initopt::rotation_offset(buffers.normalised_contours[contour_idx]);
+        initopt::mass_center_roi(input_image, buffers.transforms.translation(contour_idx), buffers.transforms.correction(contour_idx),
+                                 buffers.normalised_contours[contour_idx], buffers.transforms.factor[contour_idx],
+                                 buffers.roi_images[contour_idx], buffers.roi_dimensions[contour_idx], buffers.roi_radii[contour_idx]);
+        initopt::roi_gradients(buffers.roi_images[contour_idx], buffers.roi_gradients[contour_idx]);
+    }, m_config.nb_fitting_threads);
+
+    // Check the center mass of each hypothesis -- the sign types with the same number of edges share one pass over the edges
+    buffers.mass_centers.resize(nb_contours * NB_SIGN_TYPES);
+    parallel::for_each_index(static_cast<int> (nb_contours) * NB_LOCALISATION_GROUPS, [&](const int& job_idx) {
+        const int contour_idx = job_idx / NB_LOCALISATION_GROUPS;
+        const std::vector< int >& sign_types = localisation_groups[job_idx % NB_LOCALISATION_GROUPS];
+        std::vector< cv::Point2f > mass_centers;
+        initopt::mass_center_discovery(buffers.roi_gradients[contour_idx], buffers.roi_dimensions[contour_idx],
+                                       buffers.transforms.translation(contour_idx), buffers.roi_radii[contour_idx],
+                                       buffers.transforms.factor[contour_idx], sign_types, mass_centers);
+        for (size_t t = 0; t < sign_types.size(); t++)
+            buffers.mass_centers[contour_idx * NB_SIGN_TYPES + sign_types[t]] = mass_centers[t];
+    }, m_config.nb_fitting_threads);
+
+    timings.localisation = elapsed_ms(start);
+}
+
+// Gielis fitting of each candidate and reconstruction of the best hypotheses
+void TrafficSignDetector::fit(FrameBuffers& buffers, std::vector< Detection >& detections, DetectionTimings& timings) const {
+
+    const size_t nb_contours = buffers.normalised_contours.size();
+    detections.resize(nb_contours);
+
+    // Fit the Gielis curves of every hypothesis, then keep the best one of each candidate
+    std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+    const int nb_hypotheses = static_cast<int> (nb_contours) * NB_SIGN_TYPES;
+    buffers.hypothesis_configs.resize(nb_hypotheses);
+    buffers.hypothesis_errors.resize(nb_hypotheses);
+    buffers.hypothesis_times.resize(nb_hypotheses);
+    buffers.hypothesis_chi_squares.resize(nb_hypotheses);
+    buffers.hypothesis_checkpoint_chi_squares.resize(nb_hypotheses);
+    buffers.hypothesis_iterations.resize(nb_hypotheses);
+    buffers.hypothesis_status.resize(nb_hypotheses);
+    if (m_config.fit_pruning || m_config.fit_early_exit_error > 0.0) {
+        // The hypotheses of a candidate depend on each other -- only the candidates are shared between the threads
+        parallel::for_each_index(static_cast<int> (nb_contours), [&](const int& contour_idx) {
+            fit_candidate(buffers, contour_idx);
+        }, m_config.nb_fitting_threads);
+    }
+    else {
+        parallel::for_each_index(nb_hypotheses, [&](const int& hypothesis_idx) {
+            fit_hypothesis(buffers, hypothesis_idx);
+        }, m_config.nb_fitting_threads);
+    }
+    for (size_t contour_idx = 0; contour_idx < nb_contours; contour_idx++)
+        select_hypothesis(buffers, contour_idx, detections[contour_idx]);
+    timings.fitting = elapsed_ms(start);
+
+    // Go back in the image coordinates
+    start = std::chrono::system_clock::now();
+    for (size_t contour_idx = 0; contour_idx < nb_contours; contour_idx++)
+        reconstruct(buffers, contour_idx, detections[contour_idx]);
+    timings.reconstruction = elapsed_ms(start);
+}
+
+// Fit the Gielis curve of one hypothesis
+void TrafficSignDetector::fit_hypothesis(FrameBuffers& buffers, const int& hypothesis_idx, const double& abort_chi_square) const {
+
+    const std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+
+    const int contour_idx = hypothesis_idx / NB_SIGN_TYPES;
+    const int sign_type = hypothesis_idx % NB_SIGN_TYPES;
+
+    // Declaration of the parameters of the gielis with the default parameters
+    const cv::Point2f& mass_center = buffers.mass_centers[hypothesis_idx];
+    optimisation::ConfigStruct2d& contour_config = buffers.hypothesis_configs[hypothesis_idx];
+    contour_config = optimisation::ConfigStruct2d();
+    contour_config.p = gielis_symmetry[sign_type];
+    contour_config.theta_offset = buffers.rotation_offsets[contour_idx];
+    contour_config.x_offset = mass_center.x;
+    contour_config.y_offset = mass_center.y;
+
+    // Go for the optimisation
+    Eigen::Vector4d mean_err(0,0,0,0), std_err(0,0,0,0);
+    optimisation::FitControl control;
+    control.abort_chi_square = abort_chi_square;
+    optimisation::gielis_optimisation(buffers.normalised_contours[contour_idx], contour_config, mean_err, std_err, control);
+
+    mean_err = mean_err.cwiseAbs();
+    buffers.hypothesis_errors[hypothesis_idx] = control.aborted ? std::numeric_limits<double>::infinity() : mean_err.sum();
+    buffers.hypothesis_times[hypothesis_idx] = elapsed_ms(start);
+    buffers.hypothesis_chi_squares[hypothesis_idx] = control.chi_square;
+    buffers.hypothesis_checkpoint_chi_squares[hypothesis_idx] = control.checkpoint_chi_square;
+    buffers.hypothesis_iterations[hypothesis_idx] = control.nb_iterations;
+    buffers.hypothesis_status[hypothesis_idx] = control.aborted ? HYPOTHESIS_ABORTED : HYPOTHESIS_FITTED;
+}
+
+// Fit the hypotheses of one candidate from the most to the least likely sign type
+void TrafficSignDetector::fit_candidate(FrameBuffers& buffers, const int& contour_idx) const {
+
+    int order[NB_SIGN_TYPES];
+    if (m_config.fit_pruning)
+        sign_type_order(buffers.normalised_contours[contour_idx], order);
+    else
+        for (int sign_type = 0; sign_type < NB_SIGN_TYPES; sign_type++)
+            order[sign_type] = sign_type;
+
+    // Smallest chi square after OPTIMIZE_ABORT_MIN_ITERATIONS iterations so far -- a hypothesis far above it at the same point is
+    // abandoned, as the chi squares of the hypotheses are only comparable after as many iterations
+    double best_checkpoint_chi_square = std::numeric_limits<double>::infinity();
+    double best_error = std::numeric_limits<double>::infinity();
+    for (int rank = 0; rank < NB_SIGN_TYPES; rank++) {
+        const int hypothesis_idx = contour_idx * NB_SIGN_TYPES + order[rank];
+
+        // A good enough hypothesis has been found
+        if (best_error < m_config.fit_early_exit_error) {
+            buffers.hypothesis_errors[hypothesis_idx] = std::numeric_limits<double>::infinity();
+            buffers.hypothesis_times[hypothesis_idx] = 0.0;
+            buffers.hypothesis_chi_squares[hypothesis_idx] = 0.0;
+            buffers.hypothesis_checkpoint_chi_squares[hypothesis_idx] = std::numeric_limits<double>::infinity();
+            buffers.hypothesis_iterations[hypothesis_idx] = 0;
+            buffers.hypothesis_status[hypothesis_idx] = HYPOTHESIS_SKIPPED;
+            continue;
+        }
+
+        fit_hypothesis(buffers, hypothesis_idx, m_config.fit_pruning ? FIT_PRUNING_MARGIN * best_checkpoint_chi_square : std::numeric_limits<double>::infinity());
+        best_checkpoint_chi_square = std::min(best_checkpoint_chi_square, buffers.hypothesis_checkpoint_chi_squares[hypothesis_idx]);
+        best_error = std::min(best_error, buffers.hypothesis_errors[hypothesis_idx]);
+    }
+}
+
+// Keep the best hypothesis of a candidate -- the first sign type wins in case of equality, as in a sequential search
+void TrafficSignDetector::select_hypothesis(const FrameBuffers& buffers, const size_t& contour_idx, Detection& detection) const {
+
+    detection.fit_error = std::numeric_limits<double>::infinity();
+    detection.sign_type = -1;
+    detection.fit_time = 0.0;
+    detection.nb_fitted_hypotheses = 0;
+    detection.nb_aborted_hypotheses = 0;
+    detection.nb_iterations = 0;
+
+    for (int sign_type = 0; sign_type < NB_SIGN_TYPES; sign_type++) {
+        const size_t hypothesis_idx = contour_idx * NB_SIGN_TYPES + sign_type;
+        detection.fit_time += buffers.hypothesis_times[hypothesis_idx];
+        detection.nb_iterations += buffers.hypothesis_iterations[hypothesis_idx];
+        detection.nb_fitted_hypotheses += buffers.hypothesis_status[hypothesis_idx] == HYPOTHESIS_FITTED;
+        detection.nb_aborted_hypotheses += buffers.hypothesis_status[hypothesis_idx] == HYPOTHESIS_ABORTED;
+        if (buffers.hypothesis_errors[hypothesis_idx] < detection.fit_error) {
+            detection.fit_error = buffers.hypothesis_errors[hypothesis_idx];
+            detection.config = buffers.hypothesis_configs[hypothesis_idx];
+            detection.sign_type = sign_type;
+        }
+    }
+}
+
+// Reconstruct the contour of a detection in the image coordinates
+void TrafficSignDetector::reconstruct(FrameBuffers& buffers, const size_t& contour_idx, Detection& detection) const {
+
+    // Reconstruct the contour in the normalised frame
+    optimisation::gielis_reconstruction(detection.config, buffers.gielis_contour, m_config.nb_points_reconstruction);
+    initopt::denormalise_contour(buffers.gielis_contour, buffers.denormalised_gielis_contour, buffers.transforms.factor[contour_idx]);
+    // Remove the correction of the distortion
+    buffers.transforms.correction(contour_idx).inverse(buffers.denormalised_gielis_contour, detection.contour_2f);
+
+    // Transform to cv::Point to draw the results
+    detection.contour.resize(detection.contour_2f.size());
+    for (size_t i = 0; i < detection.contour_2f.size(); i++) {
+        detection.contour[i].x = (int) std::round(detection.contour_2f[i].x);
+        detection.contour[i].y = (int) std::round(detection.contour_2f[i].y);
+    }
+}
+
+}
@@ -0,0 +1,240 @@
+/*
+By downloading, copying, installing or using the software you agree to this license.
+If you do not agree to this license, do not download, install,
+copy or use the software.
+
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2015,
+      Guillaume Lemaitre (g.lemaitre58@gmail.com),
+      Johan Massich (mailsik@gmail.com),
+      Gerard Bahi (zomeck@gmail.com),
+      Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are disclaimed.
+In no event shall copyright holders or contributors be liable for any direct,
+indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+#pragma once
+
+// own library
+#include <optimization/smartOptimisation.h>
+#include <img_processing/segmentation.h>
+#include <img_processing/contour.h>
+
+// stl library
+#include <vector>
+#include <limits>
+
+// OpenCV library
+#include <opencv2/opencv.hpp>
+
+/* Definition of the traffic sign hypotheses */
+// sign_type = 0 -> nb_edges = 3;  gielis_sym = 6; radius
+// sign_type = 1 -> nb_edges = 4;  gielis_sym = 4; radius
+// sign_type = 2 -> nb_edges = 12; gielis_sym = 4; radius
+// sign_type = 3 -> nb_edges = 8;  gielis_sym = 8; radius
+// sign_type = 4 -> nb_edges = 3;  gielis_sym = 6; radius / 2
+#define NB_SIGN_TYPES 5
+
+// A pruned hypothesis is abandoned when its chi square after OPTIMIZE_ABORT_MIN_ITERATIONS iterations is this many times
+// the best one of the candidate after as many iterations -- a winning hypothesis can still be 1.6 times above it then
+#define FIT_PRUNING_MARGIN 2.0
+
+namespace detection {
+
+// Elapsed time of each stage of the detection (in ms)
+struct DetectionTimings {
+    DetectionTimings() : segmentation(0.0), filtering(0.0), extraction(0.0), localisation(0.0), fitting(0.0), reconstruction(0.0), total(0.0) {}
+
+    double segmentation;   // colour conversion, segmentation and merging of the masks
+    double filtering;      // morpho math and median filtering of the binary mask
+    double extraction;     // contours extraction, distortion correction and normalisation
+    double localisation;   // rotation offset and mass center discovery of every candidate and hypothesis
+    double fitting;        // Gielis optimisation of every candidate and hypothesis
+    double reconstruction; // reconstruction of the detected contours in the image
+    double total;
+};
+
+// Traffic sign detected inside an image
+struct Detection {
+    Detection() : sign_type(-1), fit_error(0.0), fit_time(0.0), nb_fitted_hypotheses(0), nb_aborted_hypotheses(0), nb_iterations(0) {}
+
+    // Reconstructed Gielis contour in the image coordinates
+    std::vector< cv::Point > contour;
+    std::vector< cv::Point2f > contour_2f;
+    // Gielis parameters of the best hypothesis, expressed in the normalised frame of the candidate
+    optimisation::ConfigStruct2d config;
+    // Best hypothesis -- see NB_SIGN_TYPES
+    int sign_type;
+    // Sum of the absolute mean errors of the best fit
+    double fit_error;
+    // Time spent to fit all the hypotheses of this candidate (in ms)
+    double fit_time;
+    // Number of hypotheses fitted until convergence and abandoned during the fitting -- the other ones were skipped
+    int nb_fitted_hypotheses;
+    int nb_aborted_hypotheses;
+    // Number of Levenberg-Marquardt iterations of all the hypotheses of this candidate
+    int nb_iterations;
+};
+
+// Outcome of the fitting of a hypothesis
+enum HypothesisStatus {
+    HYPOTHESIS_FITTED = 0,  // fitted until convergence
+    HYPOTHESIS_ABORTED = 1, // abandoned since another hypothesis of the candidate already fits better
+    HYPOTHESIS_SKIPPED = 2  // not fitted since another hypothesis of the candidate already fits well enough
+};
+
+// Strategy used to segment the image
+enum SegmentationMode {
+    SEGMENTATION_SEPARATE = 0, // IHLS image and log chromatic condition segmented separately, then merged
+    SEGMENTATION_FUSED = 1,    // single pass over the RGB image -- see segmentation::seg_fused
+    SEGMENTATION_LUT = 2       // one look-up per pixel in a quantised table -- see segmentation::seg_lut
+};
+
+// Parameters of the detector
+struct DetectorConfig {
+    DetectorConfig() : segmentation_mode(SEGMENTATION_FUSED), labels(SEG_MASK_RED), lut_bits(SEG_LUT_BITS), nb_threads(1), nb_fitting_threads(1), fit_pruning(false), fit_early_exit_error(0.0), nb_points_reconstruction(1000) {}
+
+    SegmentationMode segmentation_mode;
+    // Segmentation labels kept as candidates -- SEG_MASK_RED, SEG_MASK_BLUE or SEG_MASK_ALL
+    uchar labels;
+    // Number of bits per channel of the segmentation look-up table -- 8 bits to be exact
+    int lut_bits;
+    // Number of threads of the colour conversion, segmentation and filtering -- 0 uses every core
+    int nb_threads;
+    // Number of threads sharing the (candidate, sign type) hypotheses of the localisation and the fitting -- 0 uses every core
+    int nb_fitting_threads;
+    // Fit the hypotheses of a candidate from the most to the least likely sign type and abandon the ones which fit worse than the best one so far
+    // after the same number of iterations -- see FIT_PRUNING_MARGIN
+    bool fit_pruning;
+    // Fit error below which the remaining hypotheses of a candidate are skipped -- 0 fits all of them
+    double fit_early_exit_error;
+    // Number of points used to reconstruct each Gielis contour
+    int nb_points_reconstruction;
+};
+
+// Working buffers of one frame -- reused from one frame to the next
+struct FrameBuffers {
+    // Working images
+    cv::Mat ihls_image;
+    cv::Mat nhs_image_seg;
+    cv::Mat log_image_seg;
+    cv::Mat label_image;
+    cv::Mat merge_image_seg;
+    cv::Mat bin_image;
+    cv::Mat filter_work_image;
+
+    // Candidates of the frame
+    std::vector< std::vector< cv::Point > > distorted_contours;
+    std::vector< std::vector< cv::Point2f > > undistorted_contours;
+    std::vector< std::vector< cv::Point2f > > normalised_contours;
+    // Correction of the distortion and normalisation factor of each candidate
+    imageprocessing::ContourTransforms transforms;
+
+    // Rotation offset, warped ROI, gradients of the ROI and radius of each candidate
+    std::vector< double > rotation_offsets;
+    std::vector< cv::Mat > roi_images;
+    std::vector< initopt::RoiGradients > roi_gradients;
+    std::vector< cv::Rect > roi_dimensions;
+    std::vector< int > roi_radii;
+    // Mass center, Gielis parameters, fit error and fit time of each hypothesis -- indexed by contour_idx * NB_SIGN_TYPES + sign_type
+    std::vector< cv::Point2f > mass_centers;
+    std::vector< optimisation::ConfigStruct2d > hypothesis_configs;
+    std::vector< double > hypothesis_errors;
+    std::vector< double > hypothesis_times;
+    // Chi square at the end and after OPTIMIZE_ABORT_MIN_ITERATIONS iterations, number of iterations and outcome of the
+    // optimisation of each hypothesis
+    std::vector< double > hypothesis_chi_squares;
+    std::vector< double > hypothesis_checkpoint_chi_squares;
+    std::vector< int > hypothesis_iterations;
+    std::vector< HypothesisStatus > hypothesis_status;
+
+    // Reconstruction buffers
+    std::vector< cv::Point2f > gielis_contour;
+    std::vector< cv::Point2f > denormalised_gielis_contour;
+};
+
+// Detection engine -- the working buffers are owned by the detector and reused from one image to the next
+class TrafficSignDetector {
+public:
+    explicit TrafficSignDetector(const DetectorConfig& config = DetectorConfig());
+
+    // Detect the traffic signs of a BGR image
+    void detect(const cv::Mat& input_image, std::vector< Detection >& detections);
+
+    // Stages of detect -- a stage only writes into the buffers of its frame, so that several frames can go through different stages at the same time
+    // Conversion, segmentation and merging of the masks into buffers.merge_image_seg
+    void segment(const cv::Mat& input_image, FrameBuffers& buffers, DetectionTimings& timings) const;
+    // Filtering of the mask, extraction, undistortion and normalisation of the candidates
+    void extract(FrameBuffers& buffers, DetectionTimings& timings) const;
+    // Rotation offset and mass center of each candidate and hypothesis
+    void localise(const cv::Mat& input_image, FrameBuffers& buffers, DetectionTimings& timings) const;
+    // Gielis fitting of all the hypotheses of each candidate and reconstruction of the best ones
+    void fit(FrameBuffers& buffers, std::vector< Detection >& detections, DetectionTimings& timings) const;
+
+    // Timings of the last call to detect
+    const DetectionTimings& timings() const { return m_timings; }
+
+    // Filtered binary mask of the last call to detect
+    const cv::Mat& binary_image() const { return m_buffers.bin_image; }
+
+    // Segmentation labels of the last call to detect -- only computed when other labels than SEG_MASK_RED are requested
+    const cv::Mat& label_image() const { return m_buffers.label_image; }
+
+    const DetectorConfig& config() const { return m_config; }
+
+private:
+    // Segmentation of the red and blue traffic signs into buffers.label_image
+    void segment_labels(const cv::Mat& input_image, FrameBuffers& buffers) const;
+
+    // Fit the Gielis curve of one (candidate, sign type) hypothesis -- abandoned when its chi square is above abort_chi_square
+    // after OPTIMIZE_ABORT_MIN_ITERATIONS iterations
+    void fit_hypothesis(FrameBuffers& buffers, const int& hypothesis_idx, const double& abort_chi_square = std::numeric_limits<double>::infinity()) const;
+
+    // Fit the hypotheses of one candidate one after the other, with pruning and early exit
+    void fit_candidate(FrameBuffers& buffers, const int& contour_idx) const;
+
+    // Keep the best hypothesis of a candidate
+    void select_hypothesis(const FrameBuffers& buffers, const size_t& contour_idx, Detection& detection) const;
+
+    // Reconstruct the contour of a detection in the image coordinates
+    void reconstruct(FrameBuffers& buffers, const size_t& contour_idx, Detection& detection) const;
+
+    DetectorConfig m_config;
+    DetectionTimings m_timings;
+
+    // Segmentation look-up table -- only built in SEGMENTATION_LUT mode
+    segmentation::SegmentationLut m_seg_lut;
+
+    // Buffers of detect
+    FrameBuffers m_buffers;
+};
+
+}
@@ -43,78 +43,124 @@ the use of this software, even if advised of the possibility of such damage.
 
 #include "colorConversion.h"
 
-namespace colorconversion {
-
-// Function to convert an RGB image (uchar) to log chromatic format (double)
-void rgb_to_log_rb(const cv::Mat& rgbImage, std::vector< cv::Mat >& log_chromatic_image) {
-
-    // Allocate the output - Format: double with two channels
-    cv::Mat log_chromatic_r = cv::Mat::zeros(rgbImage.size(), CV_32F);
-    cv::Mat log_chromatic_b = cv::Mat::zeros(rgbImage.size(), CV_32F);
-    if (!log_chromatic_image.empty())
-        log_chromatic_image.erase(log_chromatic_image.begin(), log_chromatic_image.end());
-
-    // Split the channels rgb
-    //std::vector< cv::Mat > rgbVector;
-
-    const int blockIter = 64;
-    const int Niiter = std::max(1, int(std::ceil(float(rgbImage.rows)/blockIter)));
-    const int Njiter = std::max(1, int(std::ceil(float(rgbImage.cols)/blockIter)));
-
-    for (int iit = 0; iit <= Niiter; ++iit)
-    {
-        for (int i = iit*blockIter ; i < iit*(blockIter+1); i++) {
+// stl library
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+
+/* Size of the square tiles of rgb_to_log_rb (in pixels) */
+#define LOG_TILE_SIZE 64
+
+/* Polynomial approximation of log2(1 + t) for t in [0, 1) -- |error| <= 1.7e-5 */
+#define LOG2_P0  1.651467088e-05f
+#define LOG2_P1  1.441492412f
+#define LOG2_P2 -0.7064864491f
+#define LOG2_P3  0.4094702987f
+#define LOG2_P4 -0.1874886046f
+#define LOG2_P5  0.04300495779f
 
-            if(i>=rgbImage.rows)
-            {
-                break;
-            }
-
-            for (int jit = 0; jit <= Njiter; ++jit)
-            {
-                for (int j = jit*blockIter; j < jit*(blockIter+1); j++) {
-
-                    if(j>=rgbImage.cols)
-                    {
-                        break;
-                    }
+namespace colorconversion {
 
+// Natural logarithm -- reference of rgb_to_log_rb
+struct ExactLog {
+    static inline float log(const float& x) { return std::log(x); }
+};
+
+// Natural logarithm approximation -- log2 of the mantissa by a polynomial, without any branch so that the loops can be vectorised
+struct FastLog {
+    static inline float log(const float& x) {
+        uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        // x = 2^e * m with m in [1, 2) -- log(0) gives -127 * ln(2) instead of -inf
+        const float e = static_cast<float> (static_cast<int> (bits >> 23) - 127);
+        bits = (bits & 0x007FFFFF) | 0x3F800000;
+        float m;
+        std::memcpy(&m, &bits, sizeof(m));
+        const float t = m - 1.0f;
+        float poly = LOG2_P5;
+        poly = poly * t + LOG2_P4;
+        poly = poly * t + LOG2_P3;
+        poly = poly * t + LOG2_P2;
+        poly = poly * t + LOG2_P1;
+        poly = poly * t + LOG2_P0;
+        return (e + poly) * static_cast<float> (M_LN2);
+    }
+};
+
+// Conversion of the tiles of an image to log chromatic red and blue
+template< typename Log >
+static void rgb_to_log_rb_tiles(const cv::Mat& rgb_image, std::vector< cv::Mat >& log_chromatic_image, const int& nb_threads) {
+
+    CV_Assert(rgb_image.type() == CV_8UC3);
+
+    // Allocate the output - Format: float with two planes
+    // The planes are reused if the output has already been allocated with the same size
+    log_chromatic_image.resize(2);
+    cv::Mat& log_chromatic_r = log_chromatic_image[0];
+    cv::Mat& log_chromatic_b = log_chromatic_image[1];
+    log_chromatic_r.create(rgb_image.size(), CV_32F);
+    log_chromatic_b.create(rgb_image.size(), CV_32F);
+
+    // Every pixel belongs to exactly one tile
+    const int nb_tile_rows = (rgb_image.rows + LOG_TILE_SIZE - 1) / LOG_TILE_SIZE;
+
+    // The rows of tiles are processed in parallel
+    parallel::for_each_range(cv::Range(0, nb_tile_rows), [&](const cv::Range& tile_rows) {
+        for (int tile_i = tile_rows.start; tile_i < tile_rows.end; ++tile_i) {
+            const int i_end = std::min((tile_i + 1) * LOG_TILE_SIZE, rgb_image.rows);
+            for (int j_start = 0; j_start < rgb_image.cols; j_start += LOG_TILE_SIZE) {
+                const int j_end = std::min(j_start + LOG_TILE_SIZE, rgb_image.cols);
+                for (int i = tile_i * LOG_TILE_SIZE; i < i_end; ++i) {
                     // The image in opencv are encoded in BGR and not RGB
-                    const cv::Vec3b px = rgbImage.at<cv::Vec3b>(i, j);
-
-                    // Do not divide by zero
-                    // Compute the log chromatic red
-                    const float division = 1.0f / static_cast<float> (px[1] == 0 ? px[1] + 1 : px[1]);
-                    log_chromatic_r.at<float>(i, j) = std::log(static_cast<float> (px[2])*division);
-
-                    // Compute the log chromatic blue
-                    log_chromatic_b.at<float>(i, j) = std::log(static_cast<float> (px[0])*division);
+                    const uchar* rgb_data = rgb_image.ptr<uchar> (i);
+                    float* log_r_data = log_chromatic_r.ptr<float> (i);
+                    float* log_b_data = log_chromatic_b.ptr<float> (i);
+                    for (int j = j_start; j < j_end; ++j) {
+                        // Do not divide by zero
+                        const uchar g = rgb_data[3 * j + 1];
+                        const float division = 1.0f / static_cast<float> (g == 0 ? g + 1 : g);
+                        // Compute the log chromatic red
+                        log_r_data[j] = Log::log(static_cast<float> (rgb_data[3 * j + 2]) * division);
+                        // Compute the log chromatic blue
+                        log_b_data[j] = Log::log(static_cast<float> (rgb_data[3 * j]) * division);
+                    }
                 }
             }
         }
+    }, nb_threads);
+}
 
-    }
+// Function to convert an RGB image (uchar) to log chromatic format (float)
+void rgb_to_log_rb(const cv::Mat& rgb_image, std::vector< cv::Mat >& log_chromatic_image, const int& nb_threads) {
+    rgb_to_log_rb_tiles< ExactLog >(rgb_image, log_chromatic_image, nb_threads);
+}
 
-    log_chromatic_image.push_back(log_chromatic_r);
-    log_chromatic_image.push_back(log_chromatic_b);
+// Function to convert an RGB image (uchar) to log chromatic format (float) with an approximated logarithm
+void rgb_to_log_rb_fast(const cv::Mat& rgb_image, std::vector< cv::Mat >& log_chromatic_image, const int& nb_threads) {
+    rgb_to_log_rb_tiles< FastLog >(rgb_image, log_chromatic_image, nb_threads);
 }
 
 // Conversion from RGB to IHLS
-void convert_rgb_to_ihls(const cv::Mat& rgb_image, cv::Mat& ihls_image) {
+void convert_rgb_to_ihls(const cv::Mat& rgb_image, cv::Mat& ihls_image, const int& nb_threads) {
 
     // Check the that the image has three channels
     CV_Assert(rgb_image.channels() == 3);
 
     // Create the output image if needed
-    // ihls_image.create(rgb_image.size(), CV_8UC3);
-    ihls_image = rgb_image.clone();
-
-    for (auto it = ihls_image.begin<cv::Vec3b>(); it != ihls_image.end<cv::Vec3b>(); ++it) {
-        const cv::Vec3b bgr = (*it);
-        (*it)[0] = static_cast<uchar> (retrieve_saturation(static_cast<float> (bgr[2]), static_cast<float> (bgr[1]), static_cast<float> (bgr[0])));
-        (*it)[1] = static_cast<uchar> (retrieve_luminance(static_cast<float> (bgr[2]), static_cast<float> (bgr[1]), static_cast<float> (bgr[0])));
-        (*it)[2] = static_cast<uchar> (retrieve_normalised_hue(static_cast<float> (bgr[2]), static_cast<float> (bgr[1]), static_cast<float> (bgr[0])));
-    }
+    ihls_image.create(rgb_image.size(), CV_8UC3);
+
+    parallel::for_each_range(cv::Range(0, rgb_image.rows), [&](const cv::Range& rows) {
+        for (int i = rows.start; i < rows.end; ++i) {
+            const cv::Vec3b* rgb_data = rgb_image.ptr<cv::Vec3b> (i);
+            cv::Vec3b* ihls_data = ihls_image.ptr<cv::Vec3b> (i);
+            for (int j = 0; j < rgb_image.cols; ++j) {
+                const cv::Vec3b bgr = rgb_data[j];
+                ihls_data[j][0] = static_cast<uchar> (retrieve_saturation(static_cast<float> (bgr[2]), static_cast<float> (bgr[1]), static_cast<float> (bgr[0])));
+                ihls_data[j][1] = static_cast<uchar> (retrieve_luminance(static_cast<float> (bgr[2]), static_cast<float> (bgr[1]), static_cast<float> (bgr[0])));
+                ihls_data[j][2] = static_cast<uchar> (retrieve_normalised_hue(static_cast<float> (bgr[2]), static_cast<float> (bgr[1]), static_cast<float> (bgr[0])));
+            }
+        }
+    }, nb_threads);
 }
 
 }
@@ -45,6 +45,7 @@ the use of this software, even if advised of the possibility of such damage.
 
 // own library
 #include <common/math_utils.h>
+#include <common/parallel.h>
 
 // stl library
 #include <vector>
@@ -55,11 +56,31 @@ the use of this software, even if advised of the possibility of such damage.
 
 namespace colorconversion {
 
-// Conversion from RGB to logarithm RB
-void rgb_to_log_rb(const cv::Mat& rgb_image, std::vector< cv::Mat >& log_chromatic_image);
+// Conversion from RGB to logarithm RB -- the rows of tiles are shared between nb_threads threads (0 for every core)
+void rgb_to_log_rb(const cv::Mat& rgb_image, std::vector< cv::Mat >& log_chromatic_image, const int& nb_threads = 1);
 
-// Conversion from RGB to IHLS
-void convert_rgb_to_ihls(const cv::Mat& rgb_image, cv::Mat& ihls_image);
+// Conversion from RGB to logarithm RB with a polynomial approximation of the logarithm -- |error| <= 1.2e-5, log(0) = -88.03
+void rgb_to_log_rb_fast(const cv::Mat& rgb_image, std::vector< cv::Mat >& log_chromatic_image, const int& nb_threads = 1);
+
+// Conversion from RGB to IHLS -- the rows are shared between nb_threads threads (0 for every core)
+void convert_rgb_to_ihls(const cv::Mat& rgb_image, cv::Mat& ihls_image, const int& nb_threads = 1);
+
+// Instruction sets available for the vectorised conversion
+enum SimdLevel {
+    SIMD_AUTO = -1,  // best instruction set supported by the CPU
+    SIMD_SCALAR = 0,
+    SIMD_SSE41 = 1,  // 4 pixels per iteration
+    SIMD_AVX2 = 2    // 8 pixels per iteration
+};
+
+// Best instruction set supported by the CPU
+SimdLevel simd_level_supported();
+
+// Vectorised conversion of one row of BGR pixels to IHLS -- bit-exact with convert_rgb_to_ihls
+void convert_row_rgb_to_ihls(const uchar* rgb_row, uchar* ihls_row, const int& width, SimdLevel level = SIMD_AUTO);
+
+// Vectorised conversion from RGB to IHLS -- the instruction set is selected at runtime
+void convert_rgb_to_ihls_simd(const cv::Mat& rgb_image, cv::Mat& ihls_image, SimdLevel level = SIMD_AUTO, const int& nb_threads = 1);
 
 // Theta computation
 inline float retrieve_theta(const float& r, const float& g, const float& b) { return acos((r - (g * 0.5) - (b * 0.5)) / sqrtf((r * r) + (g * g) + (b * b) - (r * g) - (r * b) - (g * b))); }
@@ -0,0 +1,327 @@
+/*
+By downloading, copying, installing or using the software you agree to this license.
+If you do not agree to this license, do not download, install,
+copy or use the software.
+
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2015,
+      Guillaume Lemaitre (g.lemaitre58@gmail.com),
+      Johan Massich (mailsik@gmail.com),
+      Gerard Bahi (zomeck@gmail.com),
+      Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are disclaimed.
+In no event shall copyright holders or contributors be liable for any direct,
+indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+// own library
+#include "colorConversion.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLOR_CONVERSION_X86
+#include <immintrin.h>
+#endif
+
+/* Polynomial approximation of acos -- Abramowitz and Stegun 4.4.46 */
+// acos(x) = sqrt(1 - x) * (a0 + a1 x + ... + a7 x^7) for x in [0, 1] -- |error| <= 2e-8
+#define ACOS_A0  1.5707963050f
+#define ACOS_A1 -0.2145988016f
+#define ACOS_A2  0.0889789874f
+#define ACOS_A3 -0.0501743046f
+#define ACOS_A4  0.0308918810f
+#define ACOS_A5 -0.0170881256f
+#define ACOS_A6  0.0066700901f
+#define ACOS_A7 -0.0012624911f
+
+// The hue values closer than this margin to an integer are recomputed with the scalar reference,
+// so that the truncation to uchar gives exactly the same result than convert_rgb_to_ihls
+#define HUE_FALLBACK_MARGIN 2e-3f
+
+namespace colorconversion {
+
+// Scalar conversion of one pixel -- same expressions than convert_rgb_to_ihls
+static inline void convert_pixel_rgb_to_ihls(const uchar* bgr, uchar* ihls) {
+    const float b = static_cast<float> (bgr[0]);
+    const float g = static_cast<float> (bgr[1]);
+    const float r = static_cast<float> (bgr[2]);
+    ihls[0] = static_cast<uchar> (retrieve_saturation(r, g, b));
+    ihls[1] = static_cast<uchar> (retrieve_luminance(r, g, b));
+    ihls[2] = static_cast<uchar> (retrieve_normalised_hue(r, g, b));
+}
+
+// Scalar hue of one pixel -- used to correct the lanes close to an integer
+static inline uchar scalar_normalised_hue(const uchar* bgr) {
+    return static_cast<uchar> (retrieve_normalised_hue(static_cast<float> (bgr[2]), static_cast<float> (bgr[1]), static_cast<float> (bgr[0])));
+}
+
+// Scalar kernel
+static void convert_row_scalar(const uchar* rgb_row, uchar* ihls_row, const int& width) {
+    for (int j = 0; j < width; ++j)
+        convert_pixel_rgb_to_ihls(rgb_row + 3 * j, ihls_row + 3 * j);
+}
+
+#ifdef COLOR_CONVERSION_X86
+
+/*
+ * The hue is computed with a formulation which does not suffer from cancellation:
+ * with N = 2R - G - B and D = G - B, cos(theta) = N / sqrt(N^2 + 3 D^2) and
+ * 1 - |cos(theta)| = 3 D^2 / ((N^2 + 3 D^2) (1 + |cos(theta)|)).
+ * All the intermediate integer values are exactly represented in float.
+ */
+
+// SSE4.1 normalised hue of 4 pixels
+__attribute__((target("sse4.1")))
+static inline __m128 normalised_hue_sse41(const __m128& r, const __m128& g, const __m128& b) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 n = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(r, r), g), b);
+    const __m128 d = _mm_sub_ps(g, b);
+    const __m128 d2 = _mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(d, d));
+    // Grey pixels have a null hue -- avoid the division by zero
+    const __m128 q = _mm_max_ps(_mm_add_ps(_mm_mul_ps(n, n), d2), one);
+    const __m128 cos_theta = _mm_div_ps(n, _mm_sqrt_ps(q));
+    const __m128 abs_cos_theta = _mm_andnot_ps(_mm_set1_ps(-0.0f), cos_theta);
+    const __m128 one_minus_x = _mm_div_ps(d2, _mm_mul_ps(q, _mm_add_ps(one, abs_cos_theta)));
+
+    // Horner evaluation of the polynomial
+    __m128 poly = _mm_set1_ps(ACOS_A7);
+    poly = _mm_add_ps(_mm_mul_ps(poly, abs_cos_theta), _mm_set1_ps(ACOS_A6));
+    poly = _mm_add_ps(_mm_mul_ps(poly, abs_cos_theta), _mm_set1_ps(ACOS_A5));
+    poly = _mm_add_ps(_mm_mul_ps(poly, abs_cos_theta), _mm_set1_ps(ACOS_A4));
+    poly = _mm_add_ps(_mm_mul_ps(poly, abs_cos_theta), _mm_set1_ps(ACOS_A3));
+    poly = _mm_add_ps(_mm_mul_ps(poly, abs_cos_theta), _mm_set1_ps(ACOS_A2));
+    poly = _mm_add_ps(_mm_mul_ps(poly, abs_cos_theta), _mm_set1_ps(ACOS_A1));
+    poly = _mm_add_ps(_mm_mul_ps(poly, abs_cos_theta), _mm_set1_ps(ACOS_A0));
+    const __m128 acos_abs = _mm_mul_ps(_mm_sqrt_ps(one_minus_x), poly);
+
+    // acos(-x) = pi - acos(x)
+    const __m128 pi = _mm_set1_ps(static_cast<float> (M_PI));
+    const __m128 theta = _mm_blendv_ps(acos_abs, _mm_sub_ps(pi, acos_abs), _mm_cmplt_ps(n, _mm_setzero_ps()));
+
+    // H = theta if B <= G -- H = 2 * pi - theta if B > G
+    const __m128 hue = _mm_blendv_ps(theta, _mm_sub_ps(_mm_add_ps(pi, pi), theta), _mm_cmpgt_ps(b, g));
+    return _mm_mul_ps(hue, _mm_set1_ps(static_cast<float> (255.0 / (2.0 * M_PI))));
+}
+
+// SSE4.1 kernel -- 4 pixels per iteration
+__attribute__((target("sse4.1")))
+static void convert_row_sse41(const uchar* rgb_row, uchar* ihls_row, const int& width) {
+
+    // De-interleave the B, G and R bytes of 4 pixels into 32 bits lanes
+    const __m128i shuffle_b = _mm_setr_epi8(0, -1, -1, -1, 3, -1, -1, -1, 6, -1, -1, -1, 9, -1, -1, -1);
+    const __m128i shuffle_g = _mm_setr_epi8(1, -1, -1, -1, 4, -1, -1, -1, 7, -1, -1, -1, 10, -1, -1, -1);
+    const __m128i shuffle_r = _mm_setr_epi8(2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1);
+    // Interleave the S (bytes 0-3), L (bytes 4-7) and H (bytes 8-11) of 4 pixels
+    const __m128i shuffle_slh = _mm_setr_epi8(0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1);
+    const __m128 margin = _mm_set1_ps(HUE_FALLBACK_MARGIN);
+    const __m128 one_minus_margin = _mm_set1_ps(1.0f - HUE_FALLBACK_MARGIN);
+
+    int j = 0;
+    // 16 bytes are loaded and stored for 4 pixels (12 bytes) -- the 4 extra bytes are overwritten by the next pixels
+    for (; j + 6 <= width; j += 4) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*> (rgb_row + 3 * j));
+        const __m128i bi = _mm_shuffle_epi8(px, shuffle_b);
+        const __m128i gi = _mm_shuffle_epi8(px, shuffle_g);
+        const __m128i ri = _mm_shuffle_epi8(px, shuffle_r);
+        const __m128 b = _mm_cvtepi32_ps(bi);
+        const __m128 g = _mm_cvtepi32_ps(gi);
+        const __m128 r = _mm_cvtepi32_ps(ri);
+
+        // Saturation computation -- S = max(R, G, B) − min(R, G, B)
+        const __m128i si = _mm_sub_epi32(_mm_max_epi32(_mm_max_epi32(ri, gi), bi), _mm_min_epi32(_mm_min_epi32(ri, gi), bi));
+        // Luminance computation -- L = 0.210R + 0.715G + 0.072B
+        __m128 l = _mm_mul_ps(_mm_set1_ps(0.210f), r);
+        l = _mm_add_ps(l, _mm_mul_ps(_mm_set1_ps(0.715f), g));
+        l = _mm_add_ps(l, _mm_mul_ps(_mm_set1_ps(0.072f), b));
+        const __m128i li = _mm_cvttps_epi32(l);
+        // Normalised hue computation
+        const __m128 h = normalised_hue_sse41(r, g, b);
+        const __m128i hi = _mm_cvttps_epi32(h);
+
+        // Pack and interleave the S, L and H bytes
+        const __m128i slh = _mm_packus_epi16(_mm_packs_epi32(si, li), _mm_packs_epi32(hi, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*> (ihls_row + 3 * j), _mm_shuffle_epi8(slh, shuffle_slh));
+
+        // Recompute the hue of the pixels which are too close to an integer
+        const __m128 frac = _mm_sub_ps(h, _mm_floor_ps(h));
+        const int fallback = _mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(frac, margin), _mm_cmpgt_ps(frac, one_minus_margin)));
+        if (fallback) {
+            for (int k = 0; k < 4; ++k)
+                if (fallback & (1 << k))
+                    ihls_row[3 * (j + k) + 2] = scalar_normalised_hue(rgb_row + 3 * (j + k));
+        }
+    }
+
+    // Remaining pixels
+    convert_row_scalar(rgb_row + 3 * j, ihls_row + 3 * j, width - j);
+}
+
+// AVX2 normalised hue of 8 pixels
+__attribute__((target("avx2")))
+static inline __m256 normalised_hue_avx2(const __m256& r, const __m256& g, const __m256& b) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 n = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(r, r), g), b);
+    const __m256 d = _mm256_sub_ps(g, b);
+    const __m256 d2 = _mm256_mul_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(d, d));
+    // Grey pixels have a null hue -- avoid the division by zero
+    const __m256 q = _mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(n, n), d2), one);
+    const __m256 cos_theta = _mm256_div_ps(n, _mm256_sqrt_ps(q));
+    const __m256 abs_cos_theta = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), cos_theta);
+    const __m256 one_minus_x = _mm256_div_ps(d2, _mm256_mul_ps(q, _mm256_add_ps(one, abs_cos_theta)));
+
+    // Horner evaluation of the polynomial
+    __m256 poly = _mm256_set1_ps(ACOS_A7);
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, abs_cos_theta), _mm256_set1_ps(ACOS_A6));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, abs_cos_theta), _mm256_set1_ps(ACOS_A5));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, abs_cos_theta), _mm256_set1_ps(ACOS_A4));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, abs_cos_theta), _mm256_set1_ps(ACOS_A3));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, abs_cos_theta), _mm256_set1_ps(ACOS_A2));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, abs_cos_theta), _mm256_set1_ps(ACOS_A1));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, abs_cos_theta), _mm256_set1_ps(ACOS_A0));
+    const __m256 acos_abs = _mm256_mul_ps(_mm256_sqrt_ps(one_minus_x), poly);
+
+    // acos(-x) = pi - acos(x)
+    const __m256 pi = _mm256_set1_ps(static_cast<float> (M_PI));
+    const __m256 theta = _mm256_blendv_ps(acos_abs, _mm256_sub_ps(pi, acos_abs), _mm256_cmp_ps(n, _mm256_setzero_ps(), _CMP_LT_OQ));
+
+    // H = theta if B <= G -- H = 2 * pi - theta if B > G
+    const __m256 hue = _mm256_blendv_ps(theta, _mm256_sub_ps(_mm256_add_ps(pi, pi), theta), _mm256_cmp_ps(b, g, _CMP_GT_OQ));
+    return _mm256_mul_ps(hue, _mm256_set1_ps(static_cast<float> (255.0 / (2.0 * M_PI))));
+}
+
+// AVX2 kernel -- 8 pixels per iteration
+__attribute__((target("avx2")))
+static void convert_row_avx2(const uchar* rgb_row, uchar* ihls_row, const int& width) {
+
+    // De-interleave the B, G and R bytes of 4 pixels into 32 bits lanes -- in each 128 bits lane
+    const __m256i shuffle_b = _mm256_setr_epi8(0, -1, -1, -1, 3, -1, -1, -1, 6, -1, -1, -1, 9, -1, -1, -1,
+                                               0, -1, -1, -1, 3, -1, -1, -1, 6, -1, -1, -1, 9, -1, -1, -1);
+    const __m256i shuffle_g = _mm256_setr_epi8(1, -1, -1, -1, 4, -1, -1, -1, 7, -1, -1, -1, 10, -1, -1, -1,
+                                               1, -1, -1, -1, 4, -1, -1, -1, 7, -1, -1, -1, 10, -1, -1, -1);
+    const __m256i shuffle_r = _mm256_setr_epi8(2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1,
+                                               2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1);
+    // Interleave the S (bytes 0-3), L (bytes 4-7) and H (bytes 8-11) of 4 pixels -- in each 128 bits lane
+    const __m256i shuffle_slh = _mm256_setr_epi8(0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1,
+                                                 0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1);
+    const __m256 margin = _mm256_set1_ps(HUE_FALLBACK_MARGIN);
+    const __m256 one_minus_margin = _mm256_set1_ps(1.0f - HUE_FALLBACK_MARGIN);
+
+    int j = 0;
+    // 28 bytes are loaded and stored for 8 pixels (24 bytes) -- the 4 extra bytes are overwritten by the next pixels
+    for (; j + 10 <= width; j += 8) {
+        const __m128i px_low = _mm_loadu_si128(reinterpret_cast<const __m128i*> (rgb_row + 3 * j));
+        const __m128i px_high = _mm_loadu_si128(reinterpret_cast<const __m128i*> (rgb_row + 3 * j + 12));
+        const __m256i px = _mm256_inserti128_si256(_mm256_castsi128_si256(px_low), px_high, 1);
+        const __m256i bi = _mm256_shuffle_epi8(px, shuffle_b);
+        const __m256i gi = _mm256_shuffle_epi8(px, shuffle_g);
+        const __m256i ri = _mm256_shuffle_epi8(px, shuffle_r);
+        const __m256 b = _mm256_cvtepi32_ps(bi);
+        const __m256 g = _mm256_cvtepi32_ps(gi);
+        const __m256 r = _mm256_cvtepi32_ps(ri);
+
+        // Saturation computation -- S = max(R, G, B) − min(R, G, B)
+        const __m256i si = _mm256_sub_epi32(_mm256_max_epi32(_mm256_max_epi32(ri, gi), bi), _mm256_min_epi32(_mm256_min_epi32(ri, gi), bi));
+        // Luminance computation -- L = 0.210R + 0.715G + 0.072B
+        __m256 l = _mm256_mul_ps(_mm256_set1_ps(0.210f), r);
+        l = _mm256_add_ps(l, _mm256_mul_ps(_mm256_set1_ps(0.715f), g));
+        l = _mm256_add_ps(l, _mm256_mul_ps(_mm256_set1_ps(0.072f), b));
+        const __m256i li = _mm256_cvttps_epi32(l);
+        // Normalised hue computation
+        const __m256 h = normalised_hue_avx2(r, g, b);
+        const __m256i hi = _mm256_cvttps_epi32(h);
+
+        // Pack and interleave the S, L and H bytes -- the pack instructions work in each 128 bits lane
+        const __m256i slh = _mm256_shuffle_epi8(_mm256_packus_epi16(_mm256_packs_epi32(si, li), _mm256_packs_epi32(hi, hi)), shuffle_slh);
+        _mm_storeu_si128(reinterpret_cast<__m128i*> (ihls_row + 3 * j), _mm256_castsi256_si128(slh));
+        _mm_storeu_si128(reinterpret_cast<__m128i*> (ihls_row + 3 * j + 12), _mm256_extracti128_si256(slh, 1));
+
+        // Recompute the hue of the pixels which are too close to an integer
+        const __m256 frac = _mm256_sub_ps(h, _mm256_floor_ps(h));
+        const int fallback = _mm256_movemask_ps(_mm256_or_ps(_mm256_cmp_ps(frac, margin, _CMP_LT_OQ), _mm256_cmp_ps(frac, one_minus_margin, _CMP_GT_OQ)));
+        if (fallback) {
+            for (int k = 0; k < 8; ++k)
+                if (fallback & (1 << k))
+                    ihls_row[3 * (j + k) + 2] = scalar_normalised_hue(rgb_row + 3 * (j + k));
+        }
+    }
+
+    // Remaining pixels
+    convert_row_scalar(rgb_row + 3 * j, ihls_row + 3 * j, width - j);
+}
+
+#endif
+
+// Best instruction set supported by the CPU
+SimdLevel simd_level_supported() {
+#ifdef COLOR_CONVERSION_X86
+    static const SimdLevel level = __builtin_cpu_supports("avx2") ? SIMD_AVX2 : (__builtin_cpu_supports("sse4.1") ? SIMD_SSE41 : SIMD_SCALAR);
+    return level;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+// Vectorised conversion of one row of BGR pixels to IHLS
+void convert_row_rgb_to_ihls(const uchar* rgb_row, uchar* ihls_row, const int& width, SimdLevel level) {
+
+    // Never use an instruction set which is not supported
+    const SimdLevel supported_level = simd_level_supported();
+    if (level == SIMD_AUTO || level > supported_level)
+        level = supported_level;
+
+    switch (level) {
+#ifdef COLOR_CONVERSION_X86
+    case SIMD_AVX2:
+        convert_row_avx2(rgb_row, ihls_row, width);
+        break;
+    case SIMD_SSE41:
+        convert_row_sse41(rgb_row, ihls_row, width);
+        break;
+#endif
+    default:
+        convert_row_scalar(rgb_row, ihls_row, width);
+    }
+}
+
+// Vectorised conversion from RGB to IHLS
+void convert_rgb_to_ihls_simd(const cv::Mat& rgb_image, cv::Mat& ihls_image, SimdLevel level, const int& nb_threads) {
+
+    // Check the that the image has three channels
+    CV_Assert(rgb_image.type() == CV_8UC3);
+
+    // Create the output image if needed
+    ihls_image.create(rgb_image.size(), CV_8UC3);
+
+    parallel::for_each_range(cv::Range(0, rgb_image.rows), [&](const cv::Range& rows) {
+        for (int i = rows.start; i < rows.end; ++i)
+            convert_row_rgb_to_ihls(rgb_image.ptr<uchar> (i), ihls_image.ptr<uchar> (i), rgb_image.cols, level);
+    }, nb_threads);
+}
+
+}
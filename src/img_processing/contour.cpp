@@ -189,6 +189,36 @@ int radius_estimation(const std::vector< cv::Point2f >& contour) {
     return (int) std::ceil(radius / (double)contour.size());
 }
 
+// Function to find the part of a ROI inside an image and the padding needed around it
+void roi_padding(const cv::Size& image_size, const cv::Rect& roi, cv::Rect& within_roi, int& top, int& bottom, int& left, int& right) {
+
+    // Create a ROI with the part which is inside the original picture
+    within_roi = roi;
+    if (roi.x < 0) {
+        within_roi.x = 0;
+        within_roi.width -= roi.x;
+    }
+    if (roi.y < 0) {
+        within_roi.y = 0;
+        within_roi.height -= roi.y;
+    }
+    if ((within_roi.x + within_roi.width) >= image_size.width)
+        within_roi.width = image_size.width - within_roi.x;
+    if ((within_roi.y + within_roi.height) >= image_size.height)
+        within_roi.height = image_size.height - within_roi.y;
+
+    // Now create pad around the image with replication
+    top = 0; bottom = 0; left = 0; right = 0;
+    if (roi.x < 0)
+        left = std::abs(roi.x);
+    if (roi.y < 0)
+        top = std::abs(roi.y);
+    if ((roi.x + roi.width) >= image_size.width)
+        right = roi.width - (image_size.width - roi.x);
+    if ((roi.y + roi.height) >= image_size.height)
+        bottom = roi.height - (image_size.height - roi.y);
+}
+
 // Function to extract a ROI from one image with border copy if the ROI is too large
 void roi_extraction(const cv::Mat& original_image, const cv::Rect& roi, cv::Mat& output_image) {
 
@@ -199,40 +229,48 @@ void roi_extraction(const cv::Mat& original_image, const cv::Rect& roi, cv::Mat&
     // Otherwise we need to pad arounf the image
     else {
 
-        // Create a ROI with the part which is inside the original picture
-        cv::Rect within_roi(roi);
-        if (roi.x < 0) {
-            within_roi.x = 0;
-            within_roi.width -= roi.x;
-        }
-        if (roi.y < 0) {
-            within_roi.y = 0;
-            within_roi.height -= roi.y;
-        }
-        if ((within_roi.x + within_roi.width) >= original_image.cols)
-            within_roi.width = original_image.cols - within_roi.x;
-        if ((within_roi.y + within_roi.height) >= original_image.rows)
-            within_roi.height = original_image.rows - within_roi.y;
+        cv::Rect within_roi;
+        int top, bottom, left, right;
+        roi_padding(original_image.size(), roi, within_roi, top, bottom, left, right);
 
         // Crop the ROI within the image
         cv::Mat within_image = original_image(within_roi);
 
-        // Now create pad around the image with replication
-        int top = 0, bottom = 0, left = 0, right = 0;
-        if (roi.x < 0)
-            left = std::abs(roi.x);
-        if (roi.y < 0)
-            top = std::abs(roi.y);
-        if ((roi.x + roi.width) >= original_image.cols)
-            right = roi.width - (original_image.cols - roi.x);
-        if ((roi.y + roi.height) >= original_image.rows)
-            bottom = roi.height - (original_image.rows - roi.y);
-
         // Pad the image
         cv::copyMakeBorder(within_image, output_image, top, bottom, left, right, cv::BORDER_REPLICATE);
     }
 }
 
+// Function to warp a ROI of an image -- only the pixels of the ROI are interpolated
+void warp_roi_extraction(const cv::Mat& original_image, const cv::Mat& transform_warping, const cv::Rect& roi, cv::Mat& output_image) {
+
+    // Same ROI as warping the whole image then calling roi_extraction -- the shifted homography only changes the
+    // rounding of the interpolation coordinates
+    cv::Rect within_roi;
+    int top = 0, bottom = 0, left = 0, right = 0;
+    if ((roi.x > 0) && ((roi.x + roi.width) < original_image.cols) &&
+            (roi.y > 0) && ((roi.y + roi.height) < original_image.rows) )
+        within_roi = roi;
+    else
+        roi_padding(original_image.size(), roi, within_roi, top, bottom, left, right);
+
+    // Shift the destination of the warping to the origin of the ROI
+    cv::Mat transform_roi;
+    transform_warping.convertTo(transform_roi, CV_64F);
+    cv::Mat shift = cv::Mat::eye(3, 3, CV_64F);
+    shift.at<double>(0, 2) = -within_roi.x;
+    shift.at<double>(1, 2) = -within_roi.y;
+    transform_roi = shift * transform_roi;
+
+    cv::Mat within_image;
+    cv::warpPerspective(original_image, within_image, transform_roi, within_roi.size(), cv::INTER_CUBIC, cv::BORDER_REPLICATE);
+
+    if (top == 0 && bottom == 0 && left == 0 && right == 0)
+        output_image = within_image;
+    else
+        cv::copyMakeBorder(within_image, output_image, top, bottom, left, right, cv::BORDER_REPLICATE);
+}
+
 // Function to return max and min in x and y of contours
 void extract_min_max(const std::vector< cv::Point2f >& contour, double &min_y, double &min_x, double &max_x, double &max_y) {
     // Find the minimum coordinate around the supposed target
@@ -289,13 +327,11 @@ void gradient_thresh(cv::Mat &magnitude_image, cv::Mat &gradient_x, cv::Mat& gra
 
 }
 
-// Function to determine the angles from the gradient images
-void orientations_from_gradient(const cv::Mat& gradient_x, const cv::Mat& gradient_y, const int& edges_number, cv::Mat &gradient_vp_x, cv::Mat &gradient_vp_y, cv::Mat &gradient_bar_x, cv::Mat &gradient_bar_y) {
+// Function to determine the angle of the gradient in degree
+void gradient_angle_degree(const cv::Mat& gradient_x, const cv::Mat& gradient_y, cv::Mat& gradient_gp_degree) {
 
     // Allocation of the diffrent gradients
     cv::Mat gradient_gp_radian = cv::Mat(gradient_x.size(), CV_32F);
-    cv::Mat gradient_gp_degree = cv::Mat(gradient_x.size(), CV_32F);
-    cv::Mat gradient_vp_degree = cv::Mat(gradient_x.size(), CV_32F);
 
     // Compute gradient gp in radian
     for (int i = 0; i < gradient_gp_radian.rows; i++)
@@ -304,6 +340,20 @@ void orientations_from_gradient(const cv::Mat& gradient_x, const cv::Mat& gradie
 
     // Convert from gradient gp to degree
     cv::divide((180.0 * gradient_gp_radian), cv::Mat::ones(gradient_gp_radian.size(), CV_32F) * M_PI, gradient_gp_degree);
+}
+
+// Function to determine the angles from the gradient images
+void orientations_from_gradient(const cv::Mat& gradient_x, const cv::Mat& gradient_y, const int& edges_number, cv::Mat &gradient_vp_x, cv::Mat &gradient_vp_y, cv::Mat &gradient_bar_x, cv::Mat &gradient_bar_y) {
+
+    cv::Mat gradient_gp_degree;
+    gradient_angle_degree(gradient_x, gradient_y, gradient_gp_degree);
+    orientations_from_gradient(gradient_x, gradient_y, gradient_gp_degree, edges_number, gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y);
+}
+
+// Function to determine the angles from the gradient images and the angle of the gradient
+void orientations_from_gradient(const cv::Mat& gradient_x, const cv::Mat& gradient_y, const cv::Mat& gradient_gp_degree, const int& edges_number, cv::Mat &gradient_vp_x, cv::Mat &gradient_vp_y, cv::Mat &gradient_bar_x, cv::Mat &gradient_bar_y) {
+
+    cv::Mat gradient_vp_degree = cv::Mat(gradient_x.size(), CV_32F);
 
     // Compute the gradient vp in degree
     for (int i = 0; i < gradient_vp_degree.rows; i++) {
@@ -357,182 +407,211 @@ cv::Mat round_matrix(const cv::Mat& original_matrix) {
     return result;
 }
 
-// Function to determine mass center by voting
-cv::Point2f mass_center_by_voting(const cv::Mat& magnitude_image, const cv::Mat& gradient_x, const cv::Mat& gradient_y, const cv::Mat& gradient_bar_x, const cv::Mat& gradient_bar_y, const cv::Mat& gradient_vp_x, const cv::Mat& gradient_vp_y, const float& radius, const int& edges_number) {
+// Function to compact the pixels with a non-zero magnitude into a list of edges
+void edge_list_extraction(const cv::Mat& magnitude_image, const cv::Mat& gradient_x, const cv::Mat& gradient_y, const cv::Mat& gradient_bar_x, const cv::Mat& gradient_bar_y, const cv::Mat& gradient_vp_x, const cv::Mat& gradient_vp_y, EdgeList& edges) {
 
-    // Create all the possible combination of coordinate
-    cv::Mat coord_x = cv::Mat(magnitude_image.size(), CV_32F);
-    cv::Mat coord_y = cv::Mat(magnitude_image.size(), CV_32F);
-    for(int i = 0; i < coord_x.rows; i++) {
-        float* ptr_coord_x = coord_x.ptr<float>(i);
-        float* ptr_coord_y = coord_y.ptr<float>(i);
-        for(int j = 0; j < coord_x.cols; j++) {
-            ptr_coord_x[j] = (float) j;
-            ptr_coord_y[j] = (float) i;
+    edges.clear();
+    for (int i = 0; i < magnitude_image.rows; i++) {
+        const float* ptr_magnitude = magnitude_image.ptr<float>(i);
+        const float* ptr_gradient_x = gradient_x.ptr<float>(i);
+        const float* ptr_gradient_y = gradient_y.ptr<float>(i);
+        const float* ptr_gradient_bar_x = gradient_bar_x.ptr<float>(i);
+        const float* ptr_gradient_bar_y = gradient_bar_y.ptr<float>(i);
+        const float* ptr_gradient_vp_x = gradient_vp_x.ptr<float>(i);
+        const float* ptr_gradient_vp_y = gradient_vp_y.ptr<float>(i);
+        for (int j = 0; j < magnitude_image.cols; j++) {
+            if (ptr_magnitude[j] != 0.00) {
+                edges.x.push_back(j);
+                edges.y.push_back(i);
+                edges.gradient_x.push_back(ptr_gradient_x[j]);
+                edges.gradient_y.push_back(ptr_gradient_y[j]);
+                edges.gradient_bar_x.push_back(ptr_gradient_bar_x[j]);
+                edges.gradient_bar_y.push_back(ptr_gradient_bar_y[j]);
+                edges.gradient_vp_x.push_back(ptr_gradient_vp_x[j]);
+                edges.gradient_vp_y.push_back(ptr_gradient_vp_y[j]);
+            }
         }
     }
+}
+
+// Function to compute the linear offsets of the votes of one edge inside a buffer of a given step
+static inline void vote_offsets(const float* m_table, const int& nb_votes, const float& bar_x, const float& bar_y, const int& step, int* offsets) {
+    for (int k = 0; k < nb_votes; k++)
+        offsets[k] = (int) std::ceil(m_table[k] * bar_y) * step + (int) std::ceil(m_table[k] * bar_x);
+}
+
+// Function to accumulate the votes of one edge -- the buffers are padded so that no vote falls outside
+static inline void accumulate_votes(const int* offsets, const float* vote_table, const int& nb_votes, const int& pos_center, const int& neg_center, const float& vp_x, const float& vp_y, float* ptr_Or, float* ptr_BrX, float* ptr_BrY) {
+    for (int k = 0; k < nb_votes; k++) {
+        const float vote = vote_table[k];
+        const int pos_idx = pos_center + offsets[k];
+        ptr_Or[pos_idx] += vote;
+        ptr_BrX[pos_idx] += vote * vp_x;
+        ptr_BrY[pos_idx] += vote * vp_y;
+        const int neg_idx = neg_center + offsets[k];
+        ptr_Or[neg_idx] += vote;
+        ptr_BrX[neg_idx] += vote * vp_x;
+        ptr_BrY[neg_idx] += vote * vp_y;
+    }
+}
+
+// Function to cast the votes of a list of edges for a given radius
+void edges_voting(const EdgeList& edges, const cv::Size& image_size, const float& radius, const int& W, cv::Mat& Or, cv::Mat& BrX, cv::Mat& BrY) {
+
+    std::vector< cv::Mat > Or_radii, BrX_radii, BrY_radii;
+    edges_voting(edges, image_size, std::vector< float >(1, radius), std::vector< int >(1, W), Or_radii, BrX_radii, BrY_radii);
+    Or = Or_radii[0];
+    BrX = BrX_radii[0];
+    BrY = BrY_radii[0];
+}
+
+// Function to cast the votes of a list of edges for several radii in a single pass over the edges
+void edges_voting(const EdgeList& edges, const cv::Size& image_size, const std::vector< float >& radii, const std::vector< int >& Ws, std::vector< cv::Mat >& Or, std::vector< cv::Mat >& BrX, std::vector< cv::Mat >& BrY) {
+
+    CV_Assert(radii.size() == Ws.size());
+    const size_t nb_radii = radii.size();
+    const int W_max = *std::max_element(Ws.begin(), Ws.end());
+
+    // Line of length 4W + 1 orthogonal to the gradient -- positive votes in the middle, then negative votes at both ends
+    // The votes are indexed by m + 2 W_max in the offsets shared by all the radii
+    std::vector< std::vector< int > > m_index_tables(nb_radii);
+    std::vector< std::vector< float > > vote_tables(nb_radii);
+    for (size_t r = 0; r < nb_radii; r++) {
+        const int W = Ws[r];
+        std::vector< int >& m_index_table = m_index_tables[r];
+        std::vector< float >& vote_table = vote_tables[r];
+        for (int m = - W; m <= W; m++) { m_index_table.push_back(m + 2 * W_max); vote_table.push_back(1.00); }
+        for (int m = - 2 * W; m <= - W - 1; m++) { m_index_table.push_back(m + 2 * W_max); vote_table.push_back(- 1.00); }
+        for (int m = W + 1; m <= 2 * W; m++) { m_index_table.push_back(m + 2 * W_max); vote_table.push_back(- 1.00); }
+    }
+    const int nb_m = 4 * W_max + 1;
+    std::vector< float > m_table(nb_m);
+    for (int m = - 2 * W_max; m <= 2 * W_max; m++)
+        m_table[m + 2 * W_max] = (float) m;
+
+    // A vote moves at most 2W + 1 pixels away from its center, which is inside the image
+    const int pad = 2 * W_max + 1;
+    const cv::Size padded_size(image_size.width + 2 * pad, image_size.height + 2 * pad);
+    std::vector< cv::Mat > padded_Or(nb_radii), padded_BrX(nb_radii), padded_BrY(nb_radii);
+    for (size_t r = 0; r < nb_radii; r++) {
+        padded_Or[r] = cv::Mat::zeros(padded_size, CV_32F);
+        padded_BrX[r] = cv::Mat::zeros(padded_size, CV_32F);
+        padded_BrY[r] = cv::Mat::zeros(padded_size, CV_32F);
+    }
 
-    // Allocate the different image needed during the voting process
-    cv::Mat pos_vote_x;
-    cv::Mat pos_vote_y;
-    cv::Mat neg_vote_x;
-    cv::Mat neg_vote_y;
-
-    cv::Mat Or = cv::Mat::zeros(magnitude_image.size(), CV_32F);
-    cv::Mat Br = cv::Mat::zeros(magnitude_image.size(), CV_32F);
-    cv::Mat BrX = cv::Mat::zeros(magnitude_image.size(), CV_32F);
-    cv::Mat BrY = cv::Mat::zeros(magnitude_image.size(), CV_32F);
-
-    // Determine the coordinates of the positively and negatively affected pixels
-    // For the positive part
-    cv::add(coord_x, round_matrix(radius * gradient_x), pos_vote_x);
-    cv::add(coord_y, round_matrix(radius * gradient_y), pos_vote_y);
-    // For the negative part
-    cv::subtract(coord_x, round_matrix(radius * gradient_x), neg_vote_x);
-    cv::subtract(coord_y, round_matrix(radius * gradient_y), neg_vote_y);
-
-    // Check if the values are inside the boundaries
-    for(int i = 0; i < pos_vote_x.rows; i++) {
-        float* ptr_pos_vote_x = pos_vote_x.ptr<float>(i);
-        float* ptr_pos_vote_y = pos_vote_y.ptr<float>(i);
-        float* ptr_neg_vote_x = neg_vote_x.ptr<float>(i);
-        float* ptr_neg_vote_y = neg_vote_y.ptr<float>(i);
-
-        for(int j = 0; j < pos_vote_x.cols; j++) {
-            if(ptr_pos_vote_x[j] < 1) ptr_pos_vote_x[j] = 1;
-            if(ptr_pos_vote_y[j] < 1) ptr_pos_vote_y[j] = 1;
-            if(ptr_neg_vote_x[j] < 1) ptr_neg_vote_x[j] = 1;
-            if(ptr_neg_vote_y[j] < 1) ptr_neg_vote_y[j] = 1;
-            if(ptr_pos_vote_x[j] > pos_vote_x.cols - 1) ptr_pos_vote_x[j] = pos_vote_x.cols - 1;
-            if(ptr_pos_vote_y[j] > pos_vote_y.rows - 1) ptr_pos_vote_y[j] = pos_vote_y.rows - 1;
-            if(ptr_neg_vote_x[j] > neg_vote_x.cols - 1) ptr_neg_vote_x[j] = neg_vote_x.cols - 1;
-            if(ptr_neg_vote_y[j] > neg_vote_y.rows - 1) ptr_neg_vote_y[j] = neg_vote_y.rows - 1;
+    const int cols = image_size.width;
+    const int rows = image_size.height;
+    const int step = padded_size.width;
+    std::vector< int > m_offsets(nb_m), offsets(nb_m);
+
+    for (size_t e = 0; e < edges.size(); e++) {
+
+        // The offsets along the vote line do not depend on the radius
+        vote_offsets(&m_table[0], nb_m, edges.gradient_bar_x[e], edges.gradient_bar_y[e], step, &m_offsets[0]);
+
+        for (size_t r = 0; r < nb_radii; r++) {
+
+            // Coordinates of the positively and negatively affected pixels, kept inside the image
+            const float offset_x = (float) cvRound(radii[r] * edges.gradient_x[e]);
+            const float offset_y = (float) cvRound(radii[r] * edges.gradient_y[e]);
+            const int pos_vote_x = (int) std::min(std::max((float) edges.x[e] + offset_x, 1.0f), (float) (cols - 1));
+            const int pos_vote_y = (int) std::min(std::max((float) edges.y[e] + offset_y, 1.0f), (float) (rows - 1));
+            const int neg_vote_x = (int) std::min(std::max((float) edges.x[e] - offset_x, 1.0f), (float) (cols - 1));
+            const int neg_vote_y = (int) std::min(std::max((float) edges.y[e] - offset_y, 1.0f), (float) (rows - 1));
+
+            const int nb_votes = static_cast<int> (m_index_tables[r].size());
+            for (int k = 0; k < nb_votes; k++)
+                offsets[k] = m_offsets[m_index_tables[r][k]];
+            accumulate_votes(&offsets[0], &vote_tables[r][0], nb_votes,
+                             (pos_vote_y + pad) * step + pos_vote_x + pad, (neg_vote_y + pad) * step + neg_vote_x + pad,
+                             edges.gradient_vp_x[e], edges.gradient_vp_y[e],
+                             padded_Or[r].ptr<float>(0), padded_BrX[r].ptr<float>(0), padded_BrY[r].ptr<float>(0));
         }
     }
 
+    // The votes which fell in the padding are outside the image
+    const cv::Rect inside(pad, pad, cols, rows);
+    Or.resize(nb_radii);
+    BrX.resize(nb_radii);
+    BrY.resize(nb_radii);
+    for (size_t r = 0; r < nb_radii; r++) {
+        Or[r] = padded_Or[r](inside);
+        BrX[r] = padded_BrX[r](inside);
+        BrY[r] = padded_BrY[r](inside);
+    }
+}
+
+// Function to determine mass center by voting
+cv::Point2f mass_center_by_voting(const cv::Mat& magnitude_image, const cv::Mat& gradient_x, const cv::Mat& gradient_y, const cv::Mat& gradient_bar_x, const cv::Mat& gradient_bar_y, const cv::Mat& gradient_vp_x, const cv::Mat& gradient_vp_y, const float& radius, const int& edges_number) {
+
+    // Only the edges vote
+    EdgeList edges;
+    edge_list_extraction(magnitude_image, gradient_x, gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, edges);
+
     // Calculate W, the unit length of the vote lines in pixel
     int W = (int) ceil(radius * std::tan(M_PI / (float) edges_number));
 
     //Compute Votes
-    for (int i = 0; i < magnitude_image.rows; i++) {
-        for (int j = 0; j < magnitude_image.cols; j++) {
-            if (magnitude_image.at<float>(i, j) != 0.00) {
-                // Positive votes
-                for (int m = - W; m <= W; m++) {
-                    int LXpos = (int) pos_vote_x.at<float>(i, j) + (int) ceil((float) m * gradient_bar_x.at<float>(i, j));
-                    int LYpos = (int) pos_vote_y.at<float>(i, j) + (int) ceil((float) m * gradient_bar_y.at<float>(i, j));
-
-                    int LXneg = (int) neg_vote_x.at<float>(i, j) + (int) ceil((float) m * gradient_bar_x.at<float>(i, j));
-                    int LYneg = (int) neg_vote_y.at<float>(i, j) + (int) ceil((float) m * gradient_bar_y.at<float>(i, j));
-
-                    if((LXpos >= 0) && (LXpos < magnitude_image.cols) &&
-                            (LYpos >= 0) && (LYpos < magnitude_image.rows)) {
-                        // Vote for Or image
-                        Or.at<float>(LYpos, LXpos) = Or.at<float>(LYpos, LXpos) + 1.00;
-
-                        // Vote the Br image for X and Y
-                        BrX.at<float>(LYpos, LXpos) = BrX.at<float>(LYpos, LXpos) + gradient_vp_x.at<float>(i, j);
-                        BrY.at<float>(LYpos, LXpos) = BrY.at<float>(LYpos, LXpos) + gradient_vp_y.at<float>(i, j);
-                    }
-                    if((LXneg >= 0) && (LXneg < magnitude_image.cols) &&
-                            (LYneg >= 0) && (LYneg < magnitude_image.rows)) {
-                        // Vote for Or image
-                        Or.at<float>(LYneg, LXneg) = Or.at<float>(LYneg, LXneg) + 1.00;
-
-                        // Vote the Br image for X and Y
-                        BrX.at<float>(LYneg, LXneg) = BrX.at<float>(LYneg, LXneg) + gradient_vp_x.at<float>(i, j);
-                        BrY.at<float>(LYneg, LXneg) = BrY.at<float>(LYneg, LXneg) + gradient_vp_y.at<float>(i, j);
-                    }
-                }
-
-                // First negative votes
-                for (int m = (- 2 * W); m <= (- W - 1); m++) {
-                    int LXpos = (int) pos_vote_x.at<float>(i, j) + (int) ceil((float) m * gradient_bar_x.at<float>(i, j));
-                    int LYpos = (int) pos_vote_y.at<float>(i, j) + (int) ceil((float) m * gradient_bar_y.at<float>(i, j));
-
-                    int LXneg = (int) neg_vote_x.at<float>(i, j) + (int) ceil((float) m * gradient_bar_x.at<float>(i, j));
-                    int LYneg = (int) neg_vote_y.at<float>(i, j) + (int) ceil((float) m * gradient_bar_y.at<float>(i, j));
-
-                    if((LXpos >= 0) && (LXpos < magnitude_image.cols) &&
-                            (LYpos >= 0) && (LYpos < magnitude_image.rows)) {
-                        // Vote for Or image
-                        Or.at<float>(LYpos, LXpos) = Or.at<float>(LYpos, LXpos) - 1.00;
-
-                        // Vote the Br image for X and Y
-                        BrX.at<float>(LYpos, LXpos) = BrX.at<float>(LYpos, LXpos) - gradient_vp_x.at<float>(i, j);
-                        BrY.at<float>(LYpos, LXpos) = BrY.at<float>(LYpos, LXpos) - gradient_vp_y.at<float>(i, j);
-                    }
-                    if((LXneg >= 0) && (LXneg < magnitude_image.cols) &&
-                            (LYneg >= 0) && (LYneg < magnitude_image.rows)) {
-                        // Vote for Or image
-                        Or.at<float>(LYneg, LXneg) = Or.at<float>(LYneg, LXneg) - 1.00;
-
-                        // Vote the Br image for X and Y
-                        BrX.at<float>(LYneg, LXneg) = BrX.at<float>(LYneg, LXneg) - gradient_vp_x.at<float>(i, j);
-                        BrY.at<float>(LYneg, LXneg) = BrY.at<float>(LYneg, LXneg) - gradient_vp_y.at<float>(i, j);
-                    }
-                }
-
-                // Second negative votes
-                for (int m = (W + 1); m <= (2 * W); m++) {
-                    int LXpos = (int) pos_vote_x.at<float>(i, j) + (int) ceil((float) m * gradient_bar_x.at<float>(i, j));
-                    int LYpos = (int) pos_vote_y.at<float>(i, j) + (int) ceil((float) m * gradient_bar_y.at<float>(i, j));
-
-                    int LXneg = (int) neg_vote_x.at<float>(i, j) + (int) ceil((float) m * gradient_bar_x.at<float>(i, j));
-                    int LYneg = (int) neg_vote_y.at<float>(i, j) + (int) ceil((float) m * gradient_bar_y.at<float>(i, j));
-
-                    if((LXpos >= 0) && (LXpos < magnitude_image.cols) &&
-                            (LYpos >= 0) && (LYpos < magnitude_image.rows)) {
-                        // Vote for Or image
-                        Or.at<float>(LYpos, LXpos) = Or.at<float>(LYpos, LXpos) - 1.00;
-
-                        // Vote the Br image for X and Y
-                        BrX.at<float>(LYpos, LXpos) = BrX.at<float>(LYpos, LXpos) - gradient_vp_x.at<float>(i, j);
-                        BrY.at<float>(LYpos, LXpos) = BrY.at<float>(LYpos, LXpos) - gradient_vp_y.at<float>(i, j);
-                    }
-                    if((LXneg >= 0) && (LXneg < magnitude_image.cols) &&
-                            (LYneg >= 0) && (LYneg < magnitude_image.rows)) {
-                        // Vote for Or image
-                        Or.at<float>(LYneg, LXneg) = Or.at<float>(LYneg, LXneg) - 1.00;
-
-                        // Vote the Br image for X and Y
-                        BrX.at<float>(LYneg, LXneg) = BrX.at<float>(LYneg, LXneg) - gradient_vp_x.at<float>(i, j);
-                        BrY.at<float>(LYneg, LXneg) = BrY.at<float>(LYneg, LXneg) - gradient_vp_y.at<float>(i, j);
-                    }
-                }
-            }
-        }
-    }
+    cv::Mat Or, BrX, BrY;
+    edges_voting(edges, magnitude_image.size(), radius, W, Or, BrX, BrY);
+
+    return center_from_votes(Or, BrX, BrY, radius, W, edges_number);
+}
+
+// Function to determine the mass centers of several radii by voting -- the edges are traversed once
+void mass_center_by_voting(const cv::Mat& magnitude_image, const cv::Mat& gradient_x, const cv::Mat& gradient_y, const cv::Mat& gradient_bar_x, const cv::Mat& gradient_bar_y, const cv::Mat& gradient_vp_x, const cv::Mat& gradient_vp_y, const std::vector< float >& radii, const int& edges_number, std::vector< cv::Point2f >& mass_centers) {
+
+    // Only the edges vote
+    EdgeList edges;
+    edge_list_extraction(magnitude_image, gradient_x, gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, edges);
+
+    // Calculate W, the unit length of the vote lines in pixel
+    std::vector< int > Ws(radii.size());
+    for (size_t r = 0; r < radii.size(); r++)
+        Ws[r] = (int) ceil(radii[r] * std::tan(M_PI / (float) edges_number));
+
+    //Compute Votes
+    std::vector< cv::Mat > Or, BrX, BrY;
+    edges_voting(edges, magnitude_image.size(), radii, Ws, Or, BrX, BrY);
+
+    mass_centers.resize(radii.size());
+    for (size_t r = 0; r < radii.size(); r++)
+        mass_centers[r] = center_from_votes(Or[r], BrX[r], BrY[r], radii[r], Ws[r], edges_number);
+}
+
+// Function to determine the mass center from the votes -- the borders of Or are cleared
+cv::Point2f center_from_votes(cv::Mat& Or, const cv::Mat& BrX, const cv::Mat& BrY, const float& radius, const int& W, const int& edges_number) {
 
     // Compute Br
+    cv::Mat Br;
     cv::magnitude(BrX, BrY, Br);
 
     // To avoid edge effect - remove 2 pixels of the image
     int border = 5;
     // For left border
     for (int j = 0; j < border; j++) {
-        for (int i = 0; i < magnitude_image.rows; i++) {
+        for (int i = 0; i < Or.rows; i++) {
             Or.at<float>(i, j) = 0.00;
             Br.at<float>(i, j) = 0.00;
         }
     }
     // For top border
     for (int i = 0; i < border; i++) {
-        for (int j = 0; j < magnitude_image.cols; j++) {
+        for (int j = 0; j < Or.cols; j++) {
             Or.at<float>(i, j) = 0.00;
             Br.at<float>(i, j) = 0.00;
         }
     }
     // For bottom border
-    for (int i = magnitude_image.rows - 1; i <= magnitude_image.rows - border; i++) {
-        for (int j = 0; j < magnitude_image.cols; j++) {
+    for (int i = Or.rows - 1; i <= Or.rows - border; i++) {
+        for (int j = 0; j < Or.cols; j++) {
             Or.at<float>(i, j) = 0.00;
             Br.at<float>(i, j) = 0.00;
         }
     }
     // For the right border
-    for (int j = magnitude_image.cols - 1; j <= magnitude_image.cols - border; j++) {
-        for (int i = 0; i < magnitude_image.rows; i++) {
+    for (int j = Or.cols - 1; j <= Or.cols - border; j++) {
+        for (int i = 0; i < Or.rows; i++) {
             Or.at<float>(i, j) = 0.00;
             Br.at<float>(i, j) = 0.00;
         }
@@ -540,14 +619,14 @@ cv::Point2f mass_center_by_voting(const cv::Mat& magnitude_image, const cv::Mat&
 
     // Allocate the image for the output
     cv::Mat Sr;
-    cv::Mat S = cv::Mat::zeros(gradient_x.size(), CV_32F);
+    cv::Mat S = cv::Mat::zeros(Or.size(), CV_32F);
 
     if (edges_number == 12)
         cv::multiply(Or, Or, Sr);
     else
         cv::multiply(Or, Br, Sr);
 
-    cv::divide(Sr, cv::Mat::ones(magnitude_image.size(), CV_32F) * pow(2.00 * (float) W * radius, 2.00), Sr);
+    cv::divide(Sr, cv::Mat::ones(Or.size(), CV_32F) * pow(2.00 * (float) W * radius, 2.00), Sr);
 
     double sigma = 0.2 * radius;
     int mask_size = (int) ceil(6 * sigma);
@@ -587,8 +666,8 @@ cv::Point2f mass_center_by_voting(const cv::Mat& magnitude_image, const cv::Mat&
     return(cv::Point2f(ceil(sumX / normalization), ceil(sumY / normalization)));
 }
 
-// Function to discover the mass center using the radial symmetry detector
-cv::Point2f radial_symmetry_detector(const cv::Mat& roi_image, const int& radius, const int& edges_number) {
+// Function to compute the gradients of a ROI used by the radial symmetry detector
+void roi_gradients(const cv::Mat& roi_image, RoiGradients& gradients) {
 
     /*
      * Conversion to write data type
@@ -611,70 +690,96 @@ cv::Point2f radial_symmetry_detector(const cv::Mat& roi_image, const int& radius
     cv::Mat kernel_y = cv::Mat(5, 5, CV_32F, derivative_y);
 
     // Filter the image to compute the gradient
-    cv::Mat gradient_x, gradient_y;
-    cv::filter2D(blurred_image, gradient_x, CV_32F, - kernel_x);
-    cv::filter2D(blurred_image, gradient_y, CV_32F, - kernel_y);
+    cv::filter2D(blurred_image, gradients.gradient_x, CV_32F, - kernel_x);
+    cv::filter2D(blurred_image, gradients.gradient_y, CV_32F, - kernel_y);
 
     // Compute the magnitude
-    cv::Mat magnitude_image;
-    cv::magnitude(gradient_x, gradient_y, magnitude_image);
+    cv::magnitude(gradients.gradient_x, gradients.gradient_y, gradients.magnitude_image);
 
     // Normalise the gradient image using the magnitude
-    cv::divide(gradient_x, magnitude_image, gradient_x);
-    cv::divide(gradient_y, magnitude_image, gradient_y);
+    cv::divide(gradients.gradient_x, gradients.magnitude_image, gradients.gradient_x);
+    cv::divide(gradients.gradient_y, gradients.magnitude_image, gradients.gradient_y);
 
     /*
      * Gradients filtering
      */
 
-    gradient_thresh(magnitude_image, gradient_x, gradient_y);
+    gradient_thresh(gradients.magnitude_image, gradients.gradient_x, gradients.gradient_y);
+
+    // The angle of the gradient does not depend on the number of edges either
+    gradient_angle_degree(gradients.gradient_x, gradients.gradient_y, gradients.gradient_gp_degree);
+}
+
+// Function to discover the mass center using the radial symmetry detector
+cv::Point2f radial_symmetry_detector(const cv::Mat& roi_image, const int& radius, const int& edges_number) {
+
+    RoiGradients gradients;
+    roi_gradients(roi_image, gradients);
+
+    return radial_symmetry_detector(gradients, radius, edges_number);
+}
+
+// Function to discover the mass center using the radial symmetry detector and the gradients of the ROI
+cv::Point2f radial_symmetry_detector(const RoiGradients& gradients, const int& radius, const int& edges_number) {
 
     /*
      * Orientation computation
      */
 
     cv::Mat gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y;
-    orientations_from_gradient(gradient_x, gradient_y, edges_number, gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y);
+    orientations_from_gradient(gradients.gradient_x, gradients.gradient_y, gradients.gradient_gp_degree, edges_number, gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y);
 
     float radius_float = (float) radius;
-    return mass_center_by_voting(magnitude_image, gradient_x, gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, radius_float, edges_number);
+    return mass_center_by_voting(gradients.magnitude_image, gradients.gradient_x, gradients.gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, radius_float, edges_number);
 }
 
-// Function to discover an approximation of the mass center for each contour using a voting method for a given contour
-cv::Point2f mass_center_discovery(const cv::Mat& original_image, const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix, const std::vector< cv::Point2f >& contour, const double& factor, const int& type_traffic_sign) {
+// Function to discover the mass centers of several radii using the radial symmetry detector and the gradients of the ROI
+void radial_symmetry_detector(const RoiGradients& gradients, const std::vector< int >& radii, const int& edges_number, std::vector< cv::Point2f >& mass_centers) {
 
-    // Compute the transformation necessary to warp the original image
-    cv::Mat transform_warping = translation_matrix.inv() * rotation_matrix * scaling_matrix * translation_matrix;
+    /*
+     * Orientation computation
+     */
+
+    cv::Mat gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y;
+    orientations_from_gradient(gradients.gradient_x, gradients.gradient_y, gradients.gradient_gp_degree, edges_number, gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y);
 
-    // Warp the original image
-    cv::Mat warp_image;
-    cv::warpPerspective(original_image, warp_image, transform_warping, original_image.size(), cv::INTER_CUBIC, cv::BORDER_REPLICATE);
+    std::vector< float > radii_float(radii.begin(), radii.end());
+    mass_center_by_voting(gradients.magnitude_image, gradients.gradient_x, gradients.gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, radii_float, edges_number, mass_centers);
+}
+
+// Function to extract the warped ROI around a contour -- it does not depend on the type of traffic sign
+void mass_center_roi(const cv::Mat& original_image, const imageprocessing::AffineTransform2f& translation, const imageprocessing::AffineTransform2f& correction, const std::vector< cv::Point2f >& contour, const double& factor, cv::Mat& roi_image, cv::Rect& roi_dimension, int& radius_contour) {
+
+    // Compute the transformation necessary to warp the original image
+    const imageprocessing::AffineTransform2f transform_warping = translation.inv() * correction;
 
     // We need to denormalise the contour using the normalisation factor
     std::vector< cv::Point2f > denormalised_contour;
     denormalise_contour(contour, denormalised_contour, factor);
 
     // Estimate the radius given a contour
-    int radius_contour = radius_estimation(denormalised_contour);
+    radius_contour = radius_estimation(denormalised_contour);
 
-    // We need to inverse the translation
-    std::vector< cv::Point2f > denormalised_contour_no_translation;
-    imageprocessing::inverse_transformation_contour(denormalised_contour, denormalised_contour_no_translation, translation_matrix);
+    // We need to inverse the translation -- in place
+    translation.inverse(denormalised_contour);
 
     // Find the minimum coordinate around the supposed target
     double min_y, min_x, max_y, max_x;
-    extract_min_max(denormalised_contour_no_translation, min_y, min_x, max_x, max_y);
+    extract_min_max(denormalised_contour, min_y, min_x, max_x, max_y);
 
     // Define a ROI around the supposed target
-    cv::Rect roi_dimension;
     roi_dimension_definition(min_y, min_x, max_x, max_y, 1.5, roi_dimension);
 
-    // ROI extraction
-    cv::Mat roi_image;
-    roi_extraction(warp_image, roi_dimension, roi_image);
+    // Warp the ROI only
+    warp_roi_extraction(original_image, transform_warping.matrix(), roi_dimension, roi_image);
+}
+
+// Function to give the number of edges and the radius used by the radial symmetry detector for a type of traffic sign
+void traffic_sign_shape(const int& type_traffic_sign, const int& radius_contour, int& edges_number, int& radius) {
 
     // The main function needs to know how many edges each traffic sign has
-    int edges_number = 0;
+    edges_number = 0;
+    radius = radius_contour;
     switch (type_traffic_sign) {
     case 0:
         edges_number = 3;
@@ -690,11 +795,15 @@ cv::Point2f mass_center_discovery(const cv::Mat& original_image, const cv::Mat&
         break;
     case 4:
         edges_number = 3;
-        radius_contour = (int) ceil((float) radius_contour / 2.00);
+        radius = (int) ceil((float) radius_contour / 2.00);
         break;
     }
+}
+
+// Function to go back from a center in the ROI to the normalised frame of the contour
+static cv::Point2f normalise_roi_center(const cv::Point2f& roi_center, const cv::Rect& roi_dimension, const imageprocessing::AffineTransform2f& translation, const double& factor) {
 
-    cv::Point2f mass_center = radial_symmetry_detector(roi_image, radius_contour, edges_number);
+    cv::Point2f mass_center = roi_center;
     cv::Point2f roi_offset(roi_dimension.x, roi_dimension.y);
     mass_center += roi_offset;
 
@@ -702,12 +811,51 @@ cv::Point2f mass_center_discovery(const cv::Mat& original_image, const cv::Mat&
     // Apply the translation matrix back
 
     // We need to inverse the translation
-    cv::Point2f mass_center_no_translation;
-    imageprocessing::forward_transformation_point(mass_center, mass_center_no_translation, translation_matrix);
+    cv::Point2f mass_center_no_translation = translation.forward(mass_center);
 
     // Normalise the center and return it
     return normalise_point_fixed_factor(mass_center_no_translation, factor);
+}
+
+// Function to discover the mass center of a type of traffic sign inside the warped ROI of its contour
+cv::Point2f mass_center_discovery(const RoiGradients& gradients, const cv::Rect& roi_dimension, const imageprocessing::AffineTransform2f& translation, const int& radius_contour, const double& factor, const int& type_traffic_sign) {
+
+    int edges_number, radius;
+    traffic_sign_shape(type_traffic_sign, radius_contour, edges_number, radius);
+
+    return normalise_roi_center(radial_symmetry_detector(gradients, radius, edges_number), roi_dimension, translation, factor);
+}
+
+// Function to discover the mass centers of several types of traffic sign with the same number of edges -- one pass of the radial symmetry detector
+void mass_center_discovery(const RoiGradients& gradients, const cv::Rect& roi_dimension, const imageprocessing::AffineTransform2f& translation, const int& radius_contour, const double& factor, const std::vector< int >& types_traffic_sign, std::vector< cv::Point2f >& mass_centers) {
+
+    int edges_number = 0;
+    std::vector< int > radii(types_traffic_sign.size());
+    for (size_t t = 0; t < types_traffic_sign.size(); t++) {
+        int type_edges_number;
+        traffic_sign_shape(types_traffic_sign[t], radius_contour, type_edges_number, radii[t]);
+        CV_Assert(t == 0 || type_edges_number == edges_number);
+        edges_number = type_edges_number;
+    }
+
+    radial_symmetry_detector(gradients, radii, edges_number, mass_centers);
+    for (size_t t = 0; t < mass_centers.size(); t++)
+        mass_centers[t] = normalise_roi_center(mass_centers[t], roi_dimension, translation, factor);
+}
+
+// Function to discover an approximation of the mass center for each contour using a voting method for a given contour
+cv::Point2f mass_center_discovery(const cv::Mat& original_image, const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix, const std::vector< cv::Point2f >& contour, const double& factor, const int& type_traffic_sign) {
+
+    cv::Mat roi_image;
+    cv::Rect roi_dimension;
+    int radius_contour;
+    const imageprocessing::AffineTransform2f translation(translation_matrix);
+    mass_center_roi(original_image, translation, imageprocessing::AffineTransform2f(translation_matrix, rotation_matrix, scaling_matrix), contour, factor, roi_image, roi_dimension, radius_contour);
+
+    RoiGradients gradients;
+    roi_gradients(roi_image, gradients);
 
+    return mass_center_discovery(gradients, roi_dimension, translation, radius_contour, factor, type_traffic_sign);
 }
 
 // Function to denormalize a contour
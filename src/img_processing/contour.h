@@ -45,6 +45,7 @@ the use of this software, even if advised of the possibility of such damage.
 
 // own library
 #include <common/math_utils.h>
+#include <img_processing/imageProcessing.h>
 
 // OpenCV library
 #include <opencv2/opencv.hpp>
@@ -57,6 +58,32 @@ the use of this software, even if advised of the possibility of such damage.
 
 namespace initopt {
 
+// Gradients of a ROI -- shared by the radial symmetry detector of every type of traffic sign
+struct RoiGradients {
+    // Magnitude of the gradient, zero below THRESH_GRAD_RAD_DET of the maximum
+    cv::Mat magnitude_image;
+    // Gradient normalised by its magnitude
+    cv::Mat gradient_x;
+    cv::Mat gradient_y;
+    // Angle of the gradient in degree
+    cv::Mat gradient_gp_degree;
+};
+
+// Pixels of a ROI with a non-zero gradient magnitude -- one array per attribute
+struct EdgeList {
+    void clear() { x.clear(); y.clear(); gradient_x.clear(); gradient_y.clear(); gradient_bar_x.clear(); gradient_bar_y.clear(); gradient_vp_x.clear(); gradient_vp_y.clear(); }
+    size_t size() const { return x.size(); }
+
+    std::vector< int > x;
+    std::vector< int > y;
+    std::vector< float > gradient_x;
+    std::vector< float > gradient_y;
+    std::vector< float > gradient_bar_x;
+    std::vector< float > gradient_bar_y;
+    std::vector< float > gradient_vp_x;
+    std::vector< float > gradient_vp_y;
+};
+
 // Function to find normalisation factor
 double find_normalisation_factor(const std::vector < cv::Point2f >& contour);
 
@@ -81,9 +108,16 @@ void denormalise_all_contours(const std::vector< std::vector < cv::Point2f > >&
 // Function to estimate the radius for a contour
 int radius_estimation(const std::vector< cv::Point2f >& contour);
 
+// Function to find the part of a ROI inside an image and the padding needed around it
+void roi_padding(const cv::Size& image_size, const cv::Rect& roi, cv::Rect& within_roi, int& top, int& bottom, int& left, int& right);
+
 // Function to extract a ROI from one image with border copy if the ROI is too large
 void roi_extraction(const cv::Mat& original_image, const cv::Rect& roi, cv::Mat& output_image);
 
+// Function to warp a ROI of an image -- same output as roi_extraction of the whole warped image, up to the rounding
+// of the interpolation coordinates (a few gray levels), so the mass centers found in it may move slightly
+void warp_roi_extraction(const cv::Mat& original_image, const cv::Mat& transform_warping, const cv::Rect& roi, cv::Mat& output_image);
+
 // Function to return max and min in x and y of contours
 void extract_min_max(const std::vector< cv::Point2f >& contour, double &min_y, double &min_x, double &max_x, double &max_y);
 
@@ -99,16 +133,59 @@ void gradient_thresh(cv::Mat &magnitude_image, cv::Mat &gradient_x, cv::Mat& gra
 // Function to determine the angles from the gradient images
 void orientations_from_gradient(const cv::Mat& gradient_x, const cv::Mat& gradient_y, const int& edges_number, cv::Mat &gradient_vp_x, cv::Mat &gradient_vp_y, cv::Mat &gradient_bar_x, cv::Mat &gradient_bar_y);
 
+// Function to determine the angles from the gradient images and the angle of the gradient given by gradient_angle_degree
+void orientations_from_gradient(const cv::Mat& gradient_x, const cv::Mat& gradient_y, const cv::Mat& gradient_gp_degree, const int& edges_number, cv::Mat &gradient_vp_x, cv::Mat &gradient_vp_y, cv::Mat &gradient_bar_x, cv::Mat &gradient_bar_y);
+
+// Function to determine the angle of the gradient in degree
+void gradient_angle_degree(const cv::Mat& gradient_x, const cv::Mat& gradient_y, cv::Mat& gradient_gp_degree);
+
 // Function to round a matrix
 cv::Mat round_matrix(const cv::Mat& original_matrix);
 
+// Function to compact the pixels with a non-zero magnitude into a list of edges
+void edge_list_extraction(const cv::Mat& magnitude_image, const cv::Mat& gradient_x, const cv::Mat& gradient_y, const cv::Mat& gradient_bar_x, const cv::Mat& gradient_bar_y, const cv::Mat& gradient_vp_x, const cv::Mat& gradient_vp_y, EdgeList& edges);
+
+// Function to cast the votes of a list of edges for a given radius into the Or, BrX and BrY images
+void edges_voting(const EdgeList& edges, const cv::Size& image_size, const float& radius, const int& W, cv::Mat& Or, cv::Mat& BrX, cv::Mat& BrY);
+
+// Function to cast the votes of a list of edges for several radii in a single pass over the edges -- one Or, BrX and BrY image per radius
+void edges_voting(const EdgeList& edges, const cv::Size& image_size, const std::vector< float >& radii, const std::vector< int >& Ws, std::vector< cv::Mat >& Or, std::vector< cv::Mat >& BrX, std::vector< cv::Mat >& BrY);
+
+// Function to determine the mass center from the votes given by edges_voting -- the borders of Or are cleared
+cv::Point2f center_from_votes(cv::Mat& Or, const cv::Mat& BrX, const cv::Mat& BrY, const float& radius, const int& W, const int& edges_number);
+
 // Function to determin mass center by voting
 cv::Point2f mass_center_by_voting(const cv::Mat& magnitude_image, const cv::Mat& gradient_x, const cv::Mat& gradient_y, const cv::Mat& gradient_bar_x, const cv::Mat& gradient_bar_y, const cv::Mat& gradient_vp_x, const cv::Mat& gradient_vp_y, const float& radius, const int& edges_number);
 
+// Function to determine the mass centers of several radii by voting -- the edges are traversed once
+void mass_center_by_voting(const cv::Mat& magnitude_image, const cv::Mat& gradient_x, const cv::Mat& gradient_y, const cv::Mat& gradient_bar_x, const cv::Mat& gradient_bar_y, const cv::Mat& gradient_vp_x, const cv::Mat& gradient_vp_y, const std::vector< float >& radii, const int& edges_number, std::vector< cv::Point2f >& mass_centers);
+
 // Function to discover the mass center using the radial symmetry detector
 // RELATED PAPER - Fast shape-based road sign detection for a driver assistance system - xLoy et al.
 cv::Point2f radial_symmetry_detector(const cv::Mat& roi_image, const int& radius, const int& edges_number);
 
+// Function to compute once the gradients of a ROI used by the radial symmetry detector
+void roi_gradients(const cv::Mat& roi_image, RoiGradients& gradients);
+
+// Function to discover the mass center using the radial symmetry detector and the gradients of the ROI
+cv::Point2f radial_symmetry_detector(const RoiGradients& gradients, const int& radius, const int& edges_number);
+
+// Function to discover the mass centers of several radii using the radial symmetry detector -- one center per radius
+void radial_symmetry_detector(const RoiGradients& gradients, const std::vector< int >& radii, const int& edges_number, std::vector< cv::Point2f >& mass_centers);
+
+// Function to give the number of edges and the radius used by the radial symmetry detector for a type of traffic sign
+void traffic_sign_shape(const int& type_traffic_sign, const int& radius_contour, int& edges_number, int& radius);
+
+// Function to extract the warped ROI around a contour and its radius -- shared by all the types of traffic sign
+// THE CONTOUR NEED TO BE THE NORMALIZED CONTOUR WHICH ARE CORRECTED FOR THE DISTORTION
+void mass_center_roi(const cv::Mat& original_image, const imageprocessing::AffineTransform2f& translation, const imageprocessing::AffineTransform2f& correction, const std::vector< cv::Point2f >& contour, const double& factor, cv::Mat& roi_image, cv::Rect& roi_dimension, int& radius_contour);
+
+// Function to discover the mass center of a type of traffic sign from the gradients of the ROI given by mass_center_roi
+cv::Point2f mass_center_discovery(const RoiGradients& gradients, const cv::Rect& roi_dimension, const imageprocessing::AffineTransform2f& translation, const int& radius_contour, const double& factor, const int& type_traffic_sign);
+
+// Function to discover the mass centers of several types of traffic sign with the same number of edges in one pass of the radial symmetry detector
+void mass_center_discovery(const RoiGradients& gradients, const cv::Rect& roi_dimension, const imageprocessing::AffineTransform2f& translation, const int& radius_contour, const double& factor, const std::vector< int >& types_traffic_sign, std::vector< cv::Point2f >& mass_centers);
+
 // Function to discover an approximation of the mass center for each contour using a voting method for a given contour
 // THE CONTOUR NEED TO BE THE NORMALIZED CONTOUR WHICH ARE CORRECTED FOR THE DISTORTION
 cv::Point2f mass_center_discovery(const cv::Mat& original_image, const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix, const std::vector< cv::Point2f >& contour, const double& factor, const int& type_traffic_sign);
@@ -42,17 +42,19 @@ the use of this software, even if advised of the possibility of such damage.
 */
 
 #include "imageProcessing.h"
+#include <common/parallel.h>
 
 // stl library
 #include <vector>
+#include <algorithm>
 
 namespace imageprocessing {
 
 // Function to filter the image based on median filtering and morpho math
 void filter_image(const cv::Mat& seg_image, cv::Mat& bin_image) {
 
-    // Allocate the output
-    bin_image = seg_image.clone();
+    // Allocate the output -- reuse its buffer if it already has the right size
+    seg_image.copyTo(bin_image);
 
     // Create the structuring element for the erosion and dilation
     cv::Mat struct_elt = cv::getStructuringElement(cv::MORPH_CROSS, cv::Size(4, 4));
@@ -74,11 +76,143 @@ void filter_image(const cv::Mat& seg_image, cv::Mat& bin_image) {
     cv::erode(bin_image, bin_image, struct_elt);
 
     // Noise filtering via median filtering
-    for (int i = 0; i < 5; ++i)
-        cv::medianBlur(bin_image, bin_image, 5);
+    for (int i = 0; i < MEDIAN_FILTER_PASSES; ++i)
+        cv::medianBlur(bin_image, bin_image, MEDIAN_FILTER_SIZE);
 
 }
 
+// Index of a row or a column with a replicated border
+static inline int border_replicate(const int& idx, const int& size) {
+    return std::min(std::max(idx, 0), size - 1);
+}
+
+// Dilation by the 4x4 cross of filter_image followed by the threshold at 254 -- the pixels outside the image are ignored as in cv::dilate
+static void binary_dilation_threshold(const cv::Mat& src, cv::Mat& dst, const int& nb_threads) {
+
+    dst.create(src.size(), CV_8UC1);
+    const int rows = src.rows, cols = src.cols;
+    parallel::for_each_range(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            // The anchor of the cross is (2, 2) -- rows i-2..i+1 and columns j-2..j+1
+            const uchar* rows_data[4];
+            for (int k = 0; k < 4; ++k)
+                rows_data[k] = ((i + k - 2 >= 0) && (i + k - 2 < rows)) ? src.ptr<uchar> (i + k - 2) : NULL;
+            const uchar* src_data = src.ptr<uchar> (i);
+            uchar* dst_data = dst.ptr<uchar> (i);
+            for (int j = 0; j < cols; ++j) {
+                bool hit = false;
+                for (int l = std::max(j - 2, 0); l <= std::min(j + 1, cols - 1); ++l)
+                    hit |= (src_data[l] == 255);
+                for (int k = 0; k < 4; ++k)
+                    hit |= (rows_data[k] != NULL) && (rows_data[k][j] == 255);
+                dst_data[j] = hit ? 255 : 0;
+            }
+        }
+    }, nb_threads);
+}
+
+// Erosion by the 4x4 cross of filter_image -- the pixels outside the image are ignored as in cv::erode
+static void binary_erosion(const cv::Mat& src, cv::Mat& dst, const int& nb_threads) {
+
+    dst.create(src.size(), CV_8UC1);
+    const int rows = src.rows, cols = src.cols;
+    parallel::for_each_range(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            const uchar* rows_data[4];
+            for (int k = 0; k < 4; ++k)
+                rows_data[k] = ((i + k - 2 >= 0) && (i + k - 2 < rows)) ? src.ptr<uchar> (i + k - 2) : NULL;
+            const uchar* src_data = src.ptr<uchar> (i);
+            uchar* dst_data = dst.ptr<uchar> (i);
+            for (int j = 0; j < cols; ++j) {
+                uchar value = 255;
+                for (int l = std::max(j - 2, 0); l <= std::min(j + 1, cols - 1); ++l)
+                    value = std::min(value, src_data[l]);
+                for (int k = 0; k < 4; ++k)
+                    if (rows_data[k] != NULL)
+                        value = std::min(value, rows_data[k][j]);
+                dst_data[j] = value;
+            }
+        }
+    }, nb_threads);
+}
+
+// Median filter of a binary image -- the median of the window is the majority vote, given by running counts
+// of the window with a replicated border as cv::medianBlur. The source and the destination have to be different.
+static void binary_median_blur(const cv::Mat& src, cv::Mat& dst, const int& ksize, const int& nb_threads) {
+
+    dst.create(src.size(), CV_8UC1);
+    const int rows = src.rows, cols = src.cols;
+    const int radius = ksize / 2;
+    const int majority = ksize * ksize / 2 + 1;
+    parallel::for_each_range(cv::Range(0, rows), [&](const cv::Range& range) {
+        // Number of foreground pixels of each column of the window, with the replicated border on both sides
+        std::vector< int > counts(cols + 2 * radius, 0);
+        int* column_counts = &counts[radius];
+        for (int i = range.start; i < range.end; ++i) {
+            if (i == range.start) {
+                for (int k = -radius; k <= radius; ++k) {
+                    const uchar* src_data = src.ptr<uchar> (border_replicate(i + k, rows));
+                    for (int j = 0; j < cols; ++j)
+                        column_counts[j] += (src_data[j] != 0);
+                }
+            }
+            else {
+                // Slide the window down by one row
+                const uchar* added_data = src.ptr<uchar> (border_replicate(i + radius, rows));
+                const uchar* removed_data = src.ptr<uchar> (border_replicate(i - radius - 1, rows));
+                for (int j = 0; j < cols; ++j)
+                    column_counts[j] += (added_data[j] != 0) - (removed_data[j] != 0);
+            }
+            for (int k = 1; k <= radius; ++k) {
+                column_counts[-k] = column_counts[0];
+                column_counts[cols - 1 + k] = column_counts[cols - 1];
+            }
+
+            // Slide the window along the row
+            int count = 0;
+            for (int k = -radius; k <= radius; ++k)
+                count += column_counts[k];
+            uchar* dst_data = dst.ptr<uchar> (i);
+            for (int j = 0; j < cols - 1; ++j) {
+                dst_data[j] = (count >= majority) ? 255 : 0;
+                count += column_counts[j + radius + 1] - column_counts[j - radius];
+            }
+            dst_data[cols - 1] = (count >= majority) ? 255 : 0;
+        }
+    }, nb_threads);
+}
+
+// Function to filter a binary image -- same output as filter_image
+void filter_image_binary(const cv::Mat& seg_image, cv::Mat& bin_image, cv::Mat& work_image, const int& nb_threads) {
+
+    CV_Assert(seg_image.type() == CV_8UC1);
+    // The dilation cannot be done in place
+    const cv::Mat src_image = (seg_image.data == bin_image.data) ? seg_image.clone() : seg_image;
+
+    // Apply the dilation and threshold the image
+    binary_dilation_threshold(src_image, bin_image, nb_threads);
+
+    // Filled the objects -- the contours given by OpenCV define the filled pixels, as in filter_image
+    std::vector< std::vector< cv::Point > > contours;
+    std::vector< cv::Vec4i > hierarchy;
+    cv::findContours(bin_image, contours, hierarchy, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);
+    cv::Scalar color(255, 255, 255);
+    cv::drawContours(bin_image, contours, -1, color, CV_FILLED, 8);
+
+    // Apply some erosion -- the image is binary from now on
+    binary_erosion(bin_image, work_image, nb_threads);
+
+    // Noise filtering via majority votes -- the passes alternate between the two images and end in bin_image
+    cv::Mat* src = &work_image;
+    cv::Mat* dst = &bin_image;
+    for (int i = 0; i < MEDIAN_FILTER_PASSES; ++i) {
+        binary_median_blur(*src, *dst, MEDIAN_FILTER_SIZE, nb_threads);
+        std::swap(src, dst);
+    }
+    if (src != &bin_image)
+        src->copyTo(bin_image);
+}
+
 // Function to remove ill-posed contours
 void removal_elt(std::vector< std::vector< cv::Point > >& contours, const cv::Size size_image, const long int areaRatio, const double lowAspectRatio, const double highAspectRatio) {
 
@@ -197,142 +331,174 @@ void contours_extraction(const cv::Mat& bin_image, std::vector< std::vector< cv:
     contours_thresholding(hull_contours, contours, final_contours);
 }
 
-// Function to make forward transformation -- INPUT CV::POINT
-void forward_transformation_contour(const std::vector < cv::Point >& contour, std::vector< cv::Point2f >& output_contour, const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix) {
+// rotation_matrix * scaling_matrix * translation_matrix
+AffineTransform2f::AffineTransform2f(const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix) {
+    *this = AffineTransform2f(rotation_matrix) * AffineTransform2f(scaling_matrix) * AffineTransform2f(translation_matrix);
+}
 
-    // Convert the contour into cv::Point2f
-    std::vector< cv::Point2f > contour2f(contour.size());
-    auto it_contour = contour.begin();
-    for (auto it = contour2f.begin(); it != contour2f.end(); ++it, ++it_contour) {
-        (*it).x = static_cast<float> ((*it_contour).x);
-        (*it).y = static_cast<float> ((*it_contour).y);
-    }
+// Identity
+void AffineTransform2f::set_identity() {
+    const double identity[6] = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0 };
+    set_coefficients(identity);
+}
 
-    // Call the overloaded function for float point
-    forward_transformation_contour(contour2f, output_contour, translation_matrix, rotation_matrix, scaling_matrix);
+// From the two first rows of a CV_32F matrix
+void AffineTransform2f::set_matrix(const cv::Mat& matrix) {
+    CV_Assert(matrix.type() == CV_32F && matrix.cols == 3 && (matrix.rows == 2 || matrix.rows == 3));
+    const double coefficients[6] = { matrix.at<float>(0, 0), matrix.at<float>(0, 1), matrix.at<float>(0, 2),
+                                     matrix.at<float>(1, 0), matrix.at<float>(1, 1), matrix.at<float>(1, 2) };
+    set_coefficients(coefficients);
+}
 
+// First row then second row
+void AffineTransform2f::set_coefficients(const double coefficients[6]) {
+    for (int k = 0; k < 6; k++)
+        m_forward[k] = (float) coefficients[k];
+    update_inverse();
 }
 
-// Function to make forward transformation -- INPUT CV::POINT2F
-void forward_transformation_contour(const std::vector < cv::Point2f >& contour, std::vector< cv::Point2f >& output_contour, const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix) {
+// Composition -- the product is rounded to float as the product of CV_32F matrices
+AffineTransform2f AffineTransform2f::operator*(const AffineTransform2f& other) const {
+    const double* a = m_forward;
+    const double* b = other.m_forward;
+    const double coefficients[6] = { a[0] * b[0] + a[1] * b[3], a[0] * b[1] + a[1] * b[4], a[0] * b[2] + a[1] * b[5] + a[2],
+                                     a[3] * b[0] + a[4] * b[3], a[3] * b[1] + a[4] * b[4], a[3] * b[2] + a[4] * b[5] + a[5] };
+    AffineTransform2f product;
+    product.set_coefficients(coefficients);
+    return product;
+}
 
-    // Calculate the affine transformation using the rotation, scaling and translation matrices
-    cv::Mat transform_matrix;
-    transform_matrix = rotation_matrix * scaling_matrix * translation_matrix;
+// Inverse transformation
+AffineTransform2f AffineTransform2f::inv() const {
+    AffineTransform2f inverse;
+    inverse.set_coefficients(m_inverse);
+    return inverse;
+}
 
-    // Convert the input contour into homogenous coordinates
-    std::vector< cv::Point3f > homogeneous_contour;
-    cv::convertPointsToHomogeneous(contour, homogeneous_contour);
+// Closed form inverse of the affine transformation
+void AffineTransform2f::update_inverse() {
+    const double* m = m_forward;
+    const double det = m[0] * m[4] - m[1] * m[3];
+    const double inv_det = (det != 0.0) ? 1.0 / det : 0.0;
+    const double a00 = m[4] * inv_det, a01 = - m[1] * inv_det;
+    const double a10 = - m[3] * inv_det, a11 = m[0] * inv_det;
+    m_inverse[0] = (float) a00;
+    m_inverse[1] = (float) a01;
+    m_inverse[2] = (float) (- a00 * m[2] - a01 * m[5]);
+    m_inverse[3] = (float) a10;
+    m_inverse[4] = (float) a11;
+    m_inverse[5] = (float) (- a10 * m[2] - a11 * m[5]);
+}
 
-    // Apply the transformation
-    cv::Mat tmp_transformed_contour;
-    tmp_transformed_contour = transform_matrix * cv::Mat(homogeneous_contour).reshape(1).t();
+// 3x3 matrix of the forward transformation
+cv::Mat AffineTransform2f::matrix() const {
+    cv::Mat matrix = cv::Mat::eye(3, 3, CV_64F);
+    for (int k = 0; k < 6; k++)
+        matrix.at<double>(k / 3, k % 3) = m_forward[k];
+    return matrix;
+}
 
-    // Convert back the point into Euclidean space
-    cv::Mat output_matrix;
-    cv::convertPointsFromHomogeneous(tmp_transformed_contour.t(), output_matrix);
+// Function to make forward transformation -- INPUT CV::POINT
+void forward_transformation_contour(const std::vector < cv::Point >& contour, std::vector< cv::Point2f >& output_contour, const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix) {
 
-    // Convert back into a vector
-    if (!output_contour.empty()) {
-        output_contour.erase(output_contour.begin(), output_contour.end());
-        output_matrix.copyTo(output_contour);
-    }
-    else
-        output_matrix.copyTo(output_contour);
+    AffineTransform2f(translation_matrix, rotation_matrix, scaling_matrix).forward(contour, output_contour);
+}
 
+// Function to make forward transformation -- INPUT CV::POINT2F
+void forward_transformation_contour(const std::vector < cv::Point2f >& contour, std::vector< cv::Point2f >& output_contour, const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix) {
+
+    AffineTransform2f(translation_matrix, rotation_matrix, scaling_matrix).forward(contour, output_contour);
 }
 
 // Function to make forward transformation -- INPUT CV::POINT
 void forward_transformation_point(const cv::Point2f& point, cv::Point2f& output_point, const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix) {
 
-    // Calculate the affine transformation using the rotation, scaling and translation matrices
-    cv::Mat transform_matrix;
-    transform_matrix = rotation_matrix * scaling_matrix * translation_matrix;
-
-    // Convert the input contour into homogenous coordinates
-    cv::Point3f homogeneous_point(point.x, point.y, 1.0f);
-
-    // Apply the transformation
-    cv::Mat tmp_transformed_contour;
-    tmp_transformed_contour = transform_matrix * cv::Mat(homogeneous_point).reshape(1);
-
-    // Convert back the point into Euclidean space
-    auto it = tmp_transformed_contour.begin<cv::Vec3f>();
-    output_point = cv::Point2f((*it)[0], (*it)[1]);
+    output_point = AffineTransform2f(translation_matrix, rotation_matrix, scaling_matrix).forward(point);
 }
 
 // Function to make inverse transformation -- INPUT CV::POINT
 void inverse_transformation_contour(const std::vector < cv::Point >& contour, std::vector< cv::Point2f >& output_contour, const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix) {
 
-    // Convert the contour into cv::Point2f
-    std::vector< cv::Point2f > contour2f(contour.size());
-    auto it_contour = contour.begin();
-    for (auto it = contour2f.begin(); it != contour2f.end(); ++it, ++it_contour) {
-        (*it).x = static_cast<float> ((*it_contour).x);
-        (*it).y = static_cast<float> ((*it_contour).y);
-    }
-
-    inverse_transformation_contour(contour2f, output_contour, translation_matrix, rotation_matrix, scaling_matrix);
-
+    AffineTransform2f(translation_matrix, rotation_matrix, scaling_matrix).inverse(contour, output_contour);
 }
 
 // Function to make inverse transformation -- INPUT CV::POINT2F
 void inverse_transformation_contour(const std::vector < cv::Point2f >& contour, std::vector< cv::Point2f >& output_contour, const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix) {
 
-    // Calculate the affine transformation using the rotation, scaling and translation matrices
-    cv::Mat transform_matrix;
-    transform_matrix = rotation_matrix * scaling_matrix * translation_matrix;
-    transform_matrix = transform_matrix.inv();
+    AffineTransform2f(translation_matrix, rotation_matrix, scaling_matrix).inverse(contour, output_contour);
+}
 
-    // Convert the input contour into homogenous coordinates
-    std::vector< cv::Point3f > homogeneous_contour;
-    cv::convertPointsToHomogeneous(contour, homogeneous_contour);
+// Allocation of the transformations of the contours
+void ContourTransforms::resize(const size_t& nb_contours) {
+    centroid_x.resize(nb_contours);
+    centroid_y.resize(nb_contours);
+    orientation.resize(nb_contours);
+    scale_x.resize(nb_contours);
+    scale_y.resize(nb_contours);
+    factor.resize(nb_contours);
+}
 
-    // Apply the transformation
-    cv::Mat tmp_transformed_contour;
-    tmp_transformed_contour = transform_matrix * cv::Mat(homogeneous_contour).reshape(1).t();
+// Translation of the mass center to the origin
+AffineTransform2f ContourTransforms::translation(const size_t& contour_idx) const {
+    const double coefficients[6] = { 1.0, 0.0, - centroid_x[contour_idx],
+                                     0.0, 1.0, - centroid_y[contour_idx] };
+    AffineTransform2f transform;
+    transform.set_coefficients(coefficients);
+    return transform;
+}
 
-    // Convert back the point into Euclidean space
-    cv::Mat output_matrix;
-    cv::convertPointsFromHomogeneous(tmp_transformed_contour.t(), output_matrix);
+// Correction of the distortion -- rotation * scaling * translation, each rounded to float as the CV_32F matrices
+AffineTransform2f ContourTransforms::correction(const size_t& contour_idx) const {
+    const double cos_orientation = std::cos(orientation[contour_idx]);
+    const double sin_orientation = std::sin(orientation[contour_idx]);
+    const double rotation_coefficients[6] = { cos_orientation, - sin_orientation, 0.0,
+                                              sin_orientation, cos_orientation, 0.0 };
+    const double scaling_coefficients[6] = { scale_x[contour_idx], 0.0, 0.0,
+                                             0.0, scale_y[contour_idx], 0.0 };
+    AffineTransform2f rotation, scaling;
+    rotation.set_coefficients(rotation_coefficients);
+    scaling.set_coefficients(scaling_coefficients);
+    return rotation * scaling * translation(contour_idx);
+}
 
-    // Convert back into a vector
-    if (!output_contour.empty()) {
-        output_contour.erase(output_contour.begin(), output_contour.end());
-        output_matrix.copyTo(output_contour);
-    }
-    else
-        output_matrix.copyTo(output_contour);
+// 3x3 CV_32F translation, rotation and scaling matrices
+void ContourTransforms::matrices(const size_t& contour_idx, cv::Mat& translation_matrix, cv::Mat& rotation_matrix, cv::Mat& scaling_matrix) const {
+    translation_matrix.create(3, 3, CV_32F);
+    rotation_matrix.create(3, 3, CV_32F);
+    scaling_matrix.create(3, 3, CV_32F);
+    cv::setIdentity(translation_matrix);
+    cv::setIdentity(rotation_matrix);
+    cv::setIdentity(scaling_matrix);
+
+    translation_matrix.at<float>(0, 2) = - centroid_x[contour_idx];
+    translation_matrix.at<float>(1, 2) = - centroid_y[contour_idx];
+    rotation_matrix.at<float>(0, 0) = std::cos(orientation[contour_idx]);
+    rotation_matrix.at<float>(0, 1) = - std::sin(orientation[contour_idx]);
+    rotation_matrix.at<float>(1, 0) = std::sin(orientation[contour_idx]);
+    rotation_matrix.at<float>(1, 1) = std::cos(orientation[contour_idx]);
+    scaling_matrix.at<float>(0, 0) = scale_x[contour_idx];
+    scaling_matrix.at<float>(1, 1) = scale_y[contour_idx];
 }
 
 // Function to correct the distortion of the contours
-void correction_distortion (const std::vector< std::vector < cv::Point > >& contours, std::vector< std::vector < cv::Point2f > >& output_contours, std::vector< cv::Mat >& translation_matrix, std::vector< cv::Mat >& rotation_matrix, std::vector< cv::Mat >& scaling_matrix) {
+void correction_distortion (const std::vector< std::vector < cv::Point > >& contours, std::vector< std::vector < cv::Point2f > >& output_contours, ContourTransforms& transforms) {
 
-    // Allocation of the ouput -- The type is not anymore integer but float
-    if(!output_contours.empty()) {
-        output_contours.erase(output_contours.begin(), output_contours.end());
-        output_contours.resize(contours.size());
-    }
-    else
-        output_contours.resize(contours.size());
-
-    // Conversion into float point
-    auto it_output_contour = output_contours.begin();
-    for (auto it_contour = contours.begin(); it_contour != contours.end(); ++it_output_contour, ++it_contour) {
-        for (auto it_contour_point = (*it_contour).begin(); it_contour_point != (*it_contour).end(); ++it_contour_point) {
-            (*it_output_contour).push_back(cv::Point2f((*it_contour_point).x, (*it_contour_point).y));
-        }
-    }
+    // Allocation of the ouput -- the memory of the previous contours is reused
+    output_contours.resize(contours.size());
+    transforms.resize(contours.size());
 
     // Correct the distortion for each contour
-    auto it_contour = contours.begin();
-    auto it_translation_matrix = translation_matrix.begin();
-    auto it_rotation_matrix = rotation_matrix.begin();
-    auto it_scaling_matrix = scaling_matrix.begin();
-    for (auto it_output_contour = output_contours.begin(); it_output_contour != output_contours.end(); it_contour++, it_output_contour++, ++it_translation_matrix, ++it_rotation_matrix, ++it_scaling_matrix) {
+    for (size_t contour_idx = 0; contour_idx < contours.size(); contour_idx++) {
+
+        // Conversion into float point
+        const std::vector< cv::Point >& contour = contours[contour_idx];
+        std::vector< cv::Point2f >& output_contour = output_contours[contour_idx];
+        output_contour.resize(contour.size());
+        for (size_t i = 0; i < contour.size(); i++)
+            output_contour[i] = cv::Point2f(contour[i].x, contour[i].y);
 
         // Compute the moments of each contour
-        cv::Moments contour_moments = cv::moments((*it_output_contour));
+        cv::Moments contour_moments = cv::moments(output_contour);
 
         // Compute the mass center
         const float xbar = contour_moments.m10 / contour_moments.m00;
@@ -350,39 +516,43 @@ void correction_distortion (const std::vector< std::vector < cv::Point > >& cont
         else
             contour_orientation = 0.0;
 
-        // Compute the covariance matrix in order to determine scaling matrix
-        cv::Mat covariance_matrix = cv::Mat::zeros(2, 2, CV_32F);
-        covariance_matrix.at<float>(0, 0) = mu20p;
-        covariance_matrix.at<float>(0, 1) = mu11p;
-        covariance_matrix.at<float>(1, 0) = mu11p;
-        covariance_matrix.at<float>(1, 1) = mu02p;
-        // Compute eigenvalues and eigenvector
-        cv::Mat eigen_value_matrix, eigen_vector_matrix;
-        cv::eigen(covariance_matrix, eigen_value_matrix, eigen_vector_matrix);
-
-        // Create the rotation matrix
-        (*it_rotation_matrix).at<float>(0, 0) = std::cos(contour_orientation);
-        (*it_rotation_matrix).at<float>(0, 1) = - std::sin(contour_orientation);
-        (*it_rotation_matrix).at<float>(1, 0) = std::sin(contour_orientation);
-        (*it_rotation_matrix).at<float>(1, 1) = std::cos(contour_orientation);
-
-        // Create the scaling matrix
+        // Eigen values of the covariance matrix in order to determine the scaling -- closed form of the symmetric 2x2 matrix, in descending order
+        const double half_trace = 0.5 * ((double) mu20p + (double) mu02p);
+        const double half_gap = 0.5 * ((double) mu20p - (double) mu02p);
+        const double delta = std::sqrt(half_gap * half_gap + (double) mu11p * (double) mu11p);
+        const float eigen_value_0 = (float) (half_trace + delta);
+        const float eigen_value_1 = (float) (half_trace - delta);
+
+        // Scaling along each axis
+        const double scale_factor = std::pow(eigen_value_0 * eigen_value_1, 0.25);
         if (contour_moments.mu20 > contour_moments.mu02) {
-            (*it_scaling_matrix).at<float>(0, 0) = std::pow(eigen_value_matrix.at<float>(0, 0) * eigen_value_matrix.at<float>(1, 0), 0.25) / std::sqrt(eigen_value_matrix.at<float>(0, 0));
-            (*it_scaling_matrix).at<float>(1, 1) = std::pow(eigen_value_matrix.at<float>(0, 0) * eigen_value_matrix.at<float>(1, 0), 0.25) / std::sqrt(eigen_value_matrix.at<float>(1, 0));
+            transforms.scale_x[contour_idx] = scale_factor / std::sqrt(eigen_value_0);
+            transforms.scale_y[contour_idx] = scale_factor / std::sqrt(eigen_value_1);
         }
         else {
-            (*it_scaling_matrix).at<float>(0, 0) = std::pow(eigen_value_matrix.at<float>(0, 0) * eigen_value_matrix.at<float>(1, 0), 0.25) / std::sqrt(eigen_value_matrix.at<float>(1, 0));
-            (*it_scaling_matrix).at<float>(1, 1) = std::pow(eigen_value_matrix.at<float>(0, 0) * eigen_value_matrix.at<float>(1, 0), 0.25) / std::sqrt(eigen_value_matrix.at<float>(0, 0));
+            transforms.scale_x[contour_idx] = scale_factor / std::sqrt(eigen_value_1);
+            transforms.scale_y[contour_idx] = scale_factor / std::sqrt(eigen_value_0);
         }
+        transforms.orientation[contour_idx] = contour_orientation;
+        transforms.centroid_x[contour_idx] = xbar;
+        transforms.centroid_y[contour_idx] = ybar;
 
-        // Create the translation matrix
-        (*it_translation_matrix).at<float>(0, 2) = - xbar;
-        (*it_translation_matrix).at<float>(1, 2) = - ybar;
-
-        // Transform the contour using the previous found transformation
-        forward_transformation_contour((*it_contour), (*it_output_contour), (*it_translation_matrix), (*it_rotation_matrix), (*it_scaling_matrix));
+        // Transform the contour using the previous found transformation -- in place
+        transforms.correction(contour_idx).forward(output_contour);
     }
 }
 
+// Function to correct the distortion of the contours -- the transformations as 3x3 CV_32F matrices
+void correction_distortion (const std::vector< std::vector < cv::Point > >& contours, std::vector< std::vector < cv::Point2f > >& output_contours, std::vector< cv::Mat >& translation_matrix, std::vector< cv::Mat >& rotation_matrix, std::vector< cv::Mat >& scaling_matrix) {
+
+    ContourTransforms transforms;
+    correction_distortion(contours, output_contours, transforms);
+
+    translation_matrix.resize(contours.size());
+    rotation_matrix.resize(contours.size());
+    scaling_matrix.resize(contours.size());
+    for (size_t contour_idx = 0; contour_idx < contours.size(); contour_idx++)
+        transforms.matrices(contour_idx, translation_matrix[contour_idx], rotation_matrix[contour_idx], scaling_matrix[contour_idx]);
+}
+
 }
@@ -45,11 +45,75 @@ the use of this software, even if advised of the possibility of such damage.
 // OpenCV library
 #include <opencv2/opencv.hpp>
 
+// Size of the median filter and number of passes of filter_image
+#define MEDIAN_FILTER_SIZE 5
+#define MEDIAN_FILTER_PASSES 5
+
 namespace imageprocessing {
 
+// 2D affine transformation p' = A p + t of the contours -- the composed matrix and its inverse are cached, nothing is allocated
+class AffineTransform2f {
+public:
+    // Identity
+    AffineTransform2f() { set_identity(); }
+    // From a 3x3 (or 2x3) CV_32F matrix
+    explicit AffineTransform2f(const cv::Mat& matrix) { set_matrix(matrix); }
+    // rotation_matrix * scaling_matrix * translation_matrix, with 3x3 CV_32F matrices
+    AffineTransform2f(const cv::Mat& translation_matrix, const cv::Mat& rotation_matrix, const cv::Mat& scaling_matrix);
+
+    void set_identity();
+    void set_matrix(const cv::Mat& matrix);
+    // First row (a00, a01, t0) then second row (a10, a11, t1)
+    void set_coefficients(const double coefficients[6]);
+
+    // Composition -- (*this * other) applies other first
+    AffineTransform2f operator*(const AffineTransform2f& other) const;
+    // Inverse transformation
+    AffineTransform2f inv() const;
+
+    // Transformation of a point
+    cv::Point2f forward(const cv::Point2f& point) const { return apply(m_forward, point); }
+    cv::Point2f inverse(const cv::Point2f& point) const { return apply(m_inverse, point); }
+
+    // Transformation of a contour -- in place, or into an output contour whose memory is reused
+    void forward(std::vector< cv::Point2f >& contour) const { apply(m_forward, contour, contour); }
+    void inverse(std::vector< cv::Point2f >& contour) const { apply(m_inverse, contour, contour); }
+    void forward(const std::vector< cv::Point2f >& contour, std::vector< cv::Point2f >& output_contour) const { apply(m_forward, contour, output_contour); }
+    void inverse(const std::vector< cv::Point2f >& contour, std::vector< cv::Point2f >& output_contour) const { apply(m_inverse, contour, output_contour); }
+    void forward(const std::vector< cv::Point >& contour, std::vector< cv::Point2f >& output_contour) const { apply(m_forward, contour, output_contour); }
+    void inverse(const std::vector< cv::Point >& contour, std::vector< cv::Point2f >& output_contour) const { apply(m_inverse, contour, output_contour); }
+
+    // 3x3 CV_64F matrix of the forward transformation -- e.g. for cv::warpPerspective
+    cv::Mat matrix() const;
+
+private:
+    static cv::Point2f apply(const double m[6], const cv::Point2f& point) {
+        return cv::Point2f((float) (m[0] * point.x + m[1] * point.y + m[2]), (float) (m[3] * point.x + m[4] * point.y + m[5]));
+    }
+    template< typename _Tp > static void apply(const double m[6], const std::vector< cv::Point_<_Tp> >& contour, std::vector< cv::Point2f >& output_contour);
+    void update_inverse();
+
+    // Rows of the forward and inverse transformations, rounded to float as the CV_32F matrices they come from
+    double m_forward[6];
+    double m_inverse[6];
+};
+
+template< typename _Tp > void AffineTransform2f::apply(const double m[6], const std::vector< cv::Point_<_Tp> >& contour, std::vector< cv::Point2f >& output_contour) {
+    output_contour.resize(contour.size());
+    for (size_t i = 0; i < contour.size(); i++) {
+        const double x = contour[i].x, y = contour[i].y;
+        output_contour[i].x = (float) (m[0] * x + m[1] * y + m[2]);
+        output_contour[i].y = (float) (m[3] * x + m[4] * y + m[5]);
+    }
+}
+
 // Filter the binary image using morpho math and median filtering
 void filter_image(const cv::Mat& seg_image, cv::Mat& bin_image);
 
+// Same output as filter_image, specialised for binary images -- the median filters are majority votes given by running counts
+// work_image is a buffer reused from one call to the next
+void filter_image_binary(const cv::Mat& seg_image, cv::Mat& bin_image, cv::Mat& work_image, const int& nb_threads = 1);
+
 // Elimination of objects based on inconsistent aspects ratio and areas
 void removal_elt(std::vector< std::vector< cv::Point > >& contours, const cv::Size size_image, const long int areaRatio = 1500, const double lowAspectRatio = 0.5, const double highAspectRatio = 1.3);
 
@@ -77,7 +141,34 @@ void inverse_transformation_contour(const std::vector < cv::Point >& contour, st
 // Function to make inverse transformation -- INPUT CV::POINT2F
 void inverse_transformation_contour(const std::vector < cv::Point2f >& contour, std::vector< cv::Point2f >& output_contour, const cv::Mat& translation_matrix = cv::Mat::eye(3, 3, CV_32F), const cv::Mat& rotation_matrix = cv::Mat::eye(3, 3, CV_32F), const cv::Mat& scaling_matrix = cv::Mat::eye(3, 3, CV_32F));
 
+// Transformations correcting the distortion of the contours -- struct of arrays with one entry per contour
+struct ContourTransforms {
+    // Mass center of the contour
+    std::vector< float > centroid_x;
+    std::vector< float > centroid_y;
+    // Orientation of the principal axis of the contour
+    std::vector< float > orientation;
+    // Scaling along the two axes given by the eigen values of the covariance
+    std::vector< float > scale_x;
+    std::vector< float > scale_y;
+    // Normalisation factor of the undistorted contour
+    std::vector< double > factor;
+
+    void resize(const size_t& nb_contours);
+    size_t size() const { return centroid_x.size(); }
+
+    // Translation of the mass center to the origin
+    AffineTransform2f translation(const size_t& contour_idx) const;
+    // Correction of the distortion -- rotation * scaling * translation
+    AffineTransform2f correction(const size_t& contour_idx) const;
+    // 3x3 CV_32F translation, rotation and scaling matrices
+    void matrices(const size_t& contour_idx, cv::Mat& translation_matrix, cv::Mat& rotation_matrix, cv::Mat& scaling_matrix) const;
+};
+
 // Fuction to remove the distortion of each contour
+void correction_distortion (const std::vector< std::vector < cv::Point > >& contours, std::vector< std::vector < cv::Point2f > >& output_contours, ContourTransforms& transforms);
+
+// Fuction to remove the distortion of each contour -- the transformations as 3x3 CV_32F matrices
 void correction_distortion (const std::vector< std::vector < cv::Point > >& contours, std::vector< std::vector < cv::Point2f > >& output_contours, std::vector< cv::Mat >& translation_matrix, std::vector< cv::Mat >& rotation_matrix, std::vector< cv::Mat >& scaling_matrix);
 
 }
@@ -42,13 +42,94 @@ the use of this software, even if advised of the possibility of such damage.
 */
 
 #include "segmentation.h"
+#include "colorConversion.h"
+#include <common/parallel.h>
+
+// stl library
+#include <algorithm>
+
+/* Log chromatic ratio table */
+// Bits of a cell of the table
+#define LOG_RATIO_RED 1  // MINLOGRG < log(x / g) < MAXLOGRG
+#define LOG_RATIO_BLUE 2 // MINLOGBG < log(x / g) < MAXLOGBG
+
+// Table indexed by (g << 8) | x -- the thresholds are tested with the same expressions than rgb_to_log_rb followed by seg_log_chromatic
+static std::vector< uchar > build_log_ratio_table() {
+
+    std::vector< uchar > table(256 * 256);
+    for (int g = 0; g < 256; ++g) {
+        // Do not divide by zero
+        const float division = 1.0f / static_cast<float> (g == 0 ? g + 1 : g);
+        for (int x = 0; x < 256; ++x) {
+            const float log_x = std::log(static_cast<float> (x) * division);
+            uchar bits = 0;
+            if ((log_x > MINLOGRG) && (log_x < MAXLOGRG))
+                bits |= LOG_RATIO_RED;
+            if ((log_x > MINLOGBG) && (log_x < MAXLOGBG))
+                bits |= LOG_RATIO_BLUE;
+            table[(g << 8) | x] = bits;
+        }
+    }
+    return table;
+}
+
+// The table is built on the first call -- the initialisation of a local static is thread safe
+static const uchar* log_ratio_table() {
+    static const std::vector< uchar > table = build_log_ratio_table();
+    return table.data();
+}
+
+// Log chromatic condition of a pixel -- two look-ups in the ratio table
+static inline bool log_chromatic_condition(const uchar* table, const uchar& b, const uchar& g, const uchar& r) {
+    const uchar* row = table + (g << 8);
+    return (row[r] & LOG_RATIO_RED) && (row[b] & LOG_RATIO_BLUE);
+}
+
+// Labels of every BGR colour computed with the analytic path -- the colours are visited one (r, g) row of 256 blue values at a time
+template < typename Func >
+static void for_each_colour_labels(const segmentation::SegmentationLut& lut, Func func) {
+
+    uchar rgb_row[3 * 256];
+    uchar ihls_row[3 * 256];
+    const uchar* table = log_ratio_table();
+    for (int r = 0; r < 256; ++r) {
+        for (int g = 0; g < 256; ++g) {
+            for (int b = 0; b < 256; ++b) {
+                rgb_row[3 * b] = static_cast<uchar> (b);
+                rgb_row[3 * b + 1] = static_cast<uchar> (g);
+                rgb_row[3 * b + 2] = static_cast<uchar> (r);
+            }
+            // Same quantisation than convert_rgb_to_ihls
+            colorconversion::convert_row_rgb_to_ihls(rgb_row, ihls_row, 256);
+
+            for (int b = 0; b < 256; ++b) {
+                const uchar s = ihls_row[3 * b];
+                const uchar h = ihls_row[3 * b + 2];
+                uchar labels = 0;
+                if ((h < lut.r_hue_max || h > lut.r_hue_min) && s > lut.r_sat_min)
+                    labels |= SEG_LABEL_RED;
+                if ((h < lut.b_hue_max && h > lut.b_hue_min) && s > lut.b_sat_min)
+                    labels |= SEG_LABEL_BLUE;
+                if (log_chromatic_condition(table, static_cast<uchar> (b), static_cast<uchar> (g), static_cast<uchar> (r)))
+                    labels |= SEG_LABEL_LOG;
+                func(r, g, b, labels);
+            }
+        }
+    }
+}
+
+// Index of the cell of a colour
+static inline int seg_lut_index(const int& r, const int& g, const int& b, const int& bits) {
+    const int shift = 8 - bits;
+    return ((r >> shift) << (2 * bits)) | ((g >> shift) << bits) | (b >> shift);
+}
 
 namespace segmentation {
 
 /*
    * Segmentation of logarithmic chromatic image
    */
-void seg_log_chromatic(const std::vector< cv::Mat >& log_image, cv::Mat& log_image_seg) {
+void seg_log_chromatic(const std::vector< cv::Mat >& log_image, cv::Mat& log_image_seg, const int& nb_threads) {
 
     // Segment the image using the pre-defined threshold in the header of this file
     // Allocation of the original image
@@ -59,21 +140,45 @@ void seg_log_chromatic(const std::vector< cv::Mat >& log_image, cv::Mat& log_ima
     }
 
     // Make the segmentation by simple threholding
-    for (int i = 0 ; i < log_image_seg.rows ; i++) {
-        for (int j = 0 ; j < log_image_seg.cols ; j++) {
-            const bool condR = (log_image[0].at<float>(i, j) > MINLOGRG)&&(log_image[0].at<float>(i, j) < MAXLOGRG);
-            const bool condB = (log_image[1].at<float>(i, j) > MINLOGBG)&&(log_image[1].at<float>(i, j) < MAXLOGBG);
-            /*----------- Red detection ----------*/
-            log_image_seg.at<uchar>(i, j) = (condR && condB) ? 255 : 0;
-            /*----------- Have to be done for blue too ------------*/
+    parallel::for_each_range(cv::Range(0, log_image_seg.rows), [&](const cv::Range& rows) {
+        for (int i = rows.start; i < rows.end; ++i) {
+            for (int j = 0 ; j < log_image_seg.cols ; j++) {
+                const bool condR = (log_image[0].at<float>(i, j) > MINLOGRG)&&(log_image[0].at<float>(i, j) < MAXLOGRG);
+                const bool condB = (log_image[1].at<float>(i, j) > MINLOGBG)&&(log_image[1].at<float>(i, j) < MAXLOGBG);
+                /*----------- Red detection ----------*/
+                // The blue traffic signs are given by the normalised hue only -- see seg_norm_hue_labels
+                log_image_seg.at<uchar>(i, j) = (condR && condB) ? 255 : 0;
+            }
         }
-    }
+    }, nb_threads);
+}
+
+/*
+   * Segmentation of logarithmic chromatic condition from an RGB image
+   */
+void seg_log_chromatic_rgb(const cv::Mat& rgb_image, cv::Mat& log_image_seg, const int& nb_threads) {
+
+    // Check that the image has three channels
+    CV_Assert(rgb_image.type() == CV_8UC3);
+
+    // Create the ouput the image
+    log_image_seg.create(rgb_image.size(), CV_8UC1);
+
+    const uchar* table = log_ratio_table();
+    parallel::for_each_range(cv::Range(0, rgb_image.rows), [&](const cv::Range& rows) {
+        for (int i = rows.start; i < rows.end; ++i) {
+            const uchar *rgb_data = rgb_image.ptr<uchar> (i);
+            uchar *seg_data = log_image_seg.ptr<uchar> (i);
+            for (int j = 0; j < rgb_image.cols; ++j, rgb_data += 3)
+                *seg_data++ = log_chromatic_condition(table, rgb_data[0], rgb_data[1], rgb_data[2]) ? 255 : 0;
+        }
+    }, nb_threads);
 }
 
 /*
    * Segmentation of IHLS image
    */
-void seg_norm_hue(const cv::Mat& ihls_image, cv::Mat& nhs_image, const int& colour, int hue_max, int hue_min, int sat_min) {
+void seg_norm_hue(const cv::Mat& ihls_image, cv::Mat& nhs_image, const int& colour, int hue_max, int hue_min, int sat_min, const int& nb_threads) {
 
     // Define the different thresholds
     if (colour == 2) {
@@ -105,34 +210,300 @@ void seg_norm_hue(const cv::Mat& ihls_image, cv::Mat& nhs_image, const int& colo
     // Nicer implementation could be to separate these two for loops in
     // two different functions, one for red and one for blue.
     if (colour == 1) {
-        for (int i = 0; i < ihls_image.rows; ++i) {
-            const uchar *ihls_data = ihls_image.ptr<uchar> (i);
-            uchar *nhs_data = nhs_image.ptr<uchar> (i);
-            for (int j = 0; j < ihls_image.cols; ++j) {
-                uchar s = *ihls_data++;
-                // Although l is not being used and we could have
-                // replaced the next line with ihls_data++
-                // but for the sake of readability, we left it as it it.
-                uchar l = *ihls_data++;
-                uchar h = *ihls_data++;
-                *nhs_data++ = (B_CONDITION) ? 255 : 0;
+        parallel::for_each_range(cv::Range(0, ihls_image.rows), [&](const cv::Range& rows) {
+            for (int i = rows.start; i < rows.end; ++i) {
+                const uchar *ihls_data = ihls_image.ptr<uchar> (i);
+                uchar *nhs_data = nhs_image.ptr<uchar> (i);
+                for (int j = 0; j < ihls_image.cols; ++j) {
+                    uchar s = *ihls_data++;
+                    // Although l is not being used and we could have
+                    // replaced the next line with ihls_data++
+                    // but for the sake of readability, we left it as it it.
+                    uchar l = *ihls_data++;
+                    uchar h = *ihls_data++;
+                    *nhs_data++ = (B_CONDITION) ? 255 : 0;
+                }
             }
-        }
+        }, nb_threads);
     }
     else {
-        for (int i = 0; i < ihls_image.rows; ++i) {
+        parallel::for_each_range(cv::Range(0, ihls_image.rows), [&](const cv::Range& rows) {
+            for (int i = rows.start; i < rows.end; ++i) {
+                const uchar *ihls_data = ihls_image.ptr<uchar> (i);
+                uchar *nhs_data = nhs_image.ptr<uchar> (i);
+                for (int j = 0; j < ihls_image.cols; ++j) {
+                    uchar s = *ihls_data++;
+                    // Although l is not being used and we could have
+                    // replaced the next line with ihls_data++
+                    // but for the sake of readability, we left it as it it.
+                    uchar l = *ihls_data++;
+                    uchar h = *ihls_data++;
+                    *nhs_data++ = (R_CONDITION) ? 255 : 0;
+                }
+            }
+        }, nb_threads);
+    }
+}
+
+/*
+   * Segmentation of IHLS image for both colours
+   */
+void seg_norm_hue_labels(const cv::Mat& ihls_image, cv::Mat& label_image, const int& nb_threads) {
+
+    // Check that the image has three channels
+    CV_Assert(ihls_image.type() == CV_8UC3);
+
+    // Create the ouput the image
+    label_image.create(ihls_image.size(), CV_8UC1);
+
+    // The smallest saturation threshold discards the pixels which cannot get any label
+    const int sat_min = std::min(R_SAT_MIN, B_SAT_MIN);
+
+    parallel::for_each_range(cv::Range(0, ihls_image.rows), [&](const cv::Range& rows) {
+        for (int i = rows.start; i < rows.end; ++i) {
             const uchar *ihls_data = ihls_image.ptr<uchar> (i);
-            uchar *nhs_data = nhs_image.ptr<uchar> (i);
-            for (int j = 0; j < ihls_image.cols; ++j) {
-                uchar s = *ihls_data++;
-                // Although l is not being used and we could have
-                // replaced the next line with ihls_data++
-                // but for the sake of readability, we left it as it it.
-                uchar l = *ihls_data++;
-                uchar h = *ihls_data++;
-                *nhs_data++ = (R_CONDITION) ? 255 : 0;
+            uchar *label_data = label_image.ptr<uchar> (i);
+            for (int j = 0; j < ihls_image.cols; ++j, ihls_data += 3) {
+                const uchar s = ihls_data[0];
+                const uchar h = ihls_data[2];
+                uchar labels = 0;
+                if (s > sat_min) {
+                    if ((h < R_HUE_MAX || h > R_HUE_MIN) && s > R_SAT_MIN)
+                        labels |= SEG_LABEL_RED;
+                    if ((h < B_HUE_MAX && h > B_HUE_MIN) && s > B_SAT_MIN)
+                        labels |= SEG_LABEL_BLUE;
+                }
+                *label_data++ = labels;
+            }
+        }
+    }, nb_threads);
+}
+
+/*
+   * Fused conversion and segmentation of an RGB image
+   */
+void seg_fused(const cv::Mat& rgb_image, cv::Mat& seg_image, const int& nb_threads) {
+
+    // Check that the image has three channels
+    CV_Assert(rgb_image.type() == CV_8UC3);
+
+    // Create the ouput the image
+    seg_image.create(rgb_image.size(), CV_8UC1);
+
+    // Thresholds used by R_CONDITION
+    const int hue_max = R_HUE_MAX;
+    const int hue_min = R_HUE_MIN;
+    const int sat_min = R_SAT_MIN;
+    const uchar* table = log_ratio_table();
+
+    parallel::for_each_range(cv::Range(0, rgb_image.rows), [&](const cv::Range& rows) {
+        for (int i = rows.start; i < rows.end; ++i) {
+            const uchar *rgb_data = rgb_image.ptr<uchar> (i);
+            uchar *seg_data = seg_image.ptr<uchar> (i);
+            for (int j = 0; j < rgb_image.cols; ++j, rgb_data += 3) {
+                // The image in opencv are encoded in BGR and not RGB
+                const float b = static_cast<float> (rgb_data[0]);
+                const float g = static_cast<float> (rgb_data[1]);
+                const float r = static_cast<float> (rgb_data[2]);
+
+                // The hue is only needed when the saturation is high enough -- the quantisation is the same than convert_rgb_to_ihls
+                bool is_sign = false;
+                const uchar s = static_cast<uchar> (colorconversion::retrieve_saturation(r, g, b));
+                if (s > sat_min) {
+                    const uchar h = static_cast<uchar> (colorconversion::retrieve_normalised_hue(r, g, b));
+                    is_sign = R_CONDITION;
+                }
+
+                // The log chromatic segmentation is only needed if the pixel has not been selected yet
+                if (!is_sign)
+                    is_sign = log_chromatic_condition(table, rgb_data[0], rgb_data[1], rgb_data[2]);
+
+                *seg_data++ = is_sign ? 255 : 0;
+            }
+        }
+    }, nb_threads);
+}
+
+/*
+   * Fused conversion and labelling of an RGB image
+   */
+void seg_fused_labels(const cv::Mat& rgb_image, cv::Mat& label_image, const int& nb_threads) {
+
+    // Check that the image has three channels
+    CV_Assert(rgb_image.type() == CV_8UC3);
+
+    // Create the ouput the image
+    label_image.create(rgb_image.size(), CV_8UC1);
+
+    // The smallest saturation threshold discards the pixels which cannot get any hue label
+    const int sat_min = std::min(R_SAT_MIN, B_SAT_MIN);
+    const uchar* table = log_ratio_table();
+
+    parallel::for_each_range(cv::Range(0, rgb_image.rows), [&](const cv::Range& rows) {
+        for (int i = rows.start; i < rows.end; ++i) {
+            const uchar *rgb_data = rgb_image.ptr<uchar> (i);
+            uchar *label_data = label_image.ptr<uchar> (i);
+            for (int j = 0; j < rgb_image.cols; ++j, rgb_data += 3) {
+                // The image in opencv are encoded in BGR and not RGB
+                const float b = static_cast<float> (rgb_data[0]);
+                const float g = static_cast<float> (rgb_data[1]);
+                const float r = static_cast<float> (rgb_data[2]);
+
+                // The hue is computed once for both colours -- the quantisation is the same than convert_rgb_to_ihls
+                uchar labels = 0;
+                const uchar s = static_cast<uchar> (colorconversion::retrieve_saturation(r, g, b));
+                if (s > sat_min) {
+                    const uchar h = static_cast<uchar> (colorconversion::retrieve_normalised_hue(r, g, b));
+                    if ((h < R_HUE_MAX || h > R_HUE_MIN) && s > R_SAT_MIN)
+                        labels |= SEG_LABEL_RED;
+                    if ((h < B_HUE_MAX && h > B_HUE_MIN) && s > B_SAT_MIN)
+                        labels |= SEG_LABEL_BLUE;
+                }
+
+                if (log_chromatic_condition(table, rgb_data[0], rgb_data[1], rgb_data[2]))
+                    labels |= SEG_LABEL_LOG;
+
+                *label_data++ = labels;
             }
         }
+    }, nb_threads);
+}
+
+/*
+   * Binary mask of a label image
+   */
+void labels_to_mask(const cv::Mat& label_image, cv::Mat& mask, const uchar& labels) {
+
+    CV_Assert(label_image.type() == CV_8UC1);
+
+    // Create the ouput the image
+    mask.create(label_image.size(), CV_8UC1);
+
+    for (int i = 0; i < label_image.rows; ++i) {
+        const uchar *label_data = label_image.ptr<uchar> (i);
+        uchar *mask_data = mask.ptr<uchar> (i);
+        for (int j = 0; j < label_image.cols; ++j)
+            mask_data[j] = (label_data[j] & labels) ? 255 : 0;
+    }
+}
+
+/*
+   * Construction of the segmentation look-up table
+   */
+void build_seg_lut(SegmentationLut& lut, const int& bits,
+                   const int& r_hue_max, const int& r_hue_min, const int& r_sat_min,
+                   const int& b_hue_max, const int& b_hue_min, const int& b_sat_min) {
+
+    CV_Assert(bits > 0 && bits <= 8);
+
+    lut.bits = bits;
+    lut.r_hue_max = r_hue_max;
+    lut.r_hue_min = r_hue_min;
+    lut.r_sat_min = r_sat_min;
+    lut.b_hue_max = b_hue_max;
+    lut.b_hue_min = b_hue_min;
+    lut.b_sat_min = b_sat_min;
+
+    // Count the colours of each cell holding each label
+    const int nb_cells = 1 << (3 * bits);
+    const int cell_size = 1 << (3 * (8 - bits));
+    std::vector< int > count_red(nb_cells, 0), count_blue(nb_cells, 0), count_log(nb_cells, 0);
+    for_each_colour_labels(lut, [&](const int& r, const int& g, const int& b, const uchar& labels) {
+        const int idx = seg_lut_index(r, g, b, bits);
+        count_red[idx] += (labels & SEG_LABEL_RED) ? 1 : 0;
+        count_blue[idx] += (labels & SEG_LABEL_BLUE) ? 1 : 0;
+        count_log[idx] += (labels & SEG_LABEL_LOG) ? 1 : 0;
+    });
+
+    // Keep the majority label of each cell
+    lut.table.assign(nb_cells, 0);
+    for (int idx = 0; idx < nb_cells; ++idx) {
+        uchar labels = 0;
+        if (2 * count_red[idx] > cell_size)
+            labels |= SEG_LABEL_RED;
+        if (2 * count_blue[idx] > cell_size)
+            labels |= SEG_LABEL_BLUE;
+        if (2 * count_log[idx] > cell_size)
+            labels |= SEG_LABEL_LOG;
+        lut.table[idx] = labels;
+    }
+}
+
+/*
+   * Bit-exactness report of a segmentation look-up table
+   */
+SegmentationLutReport seg_lut_report(const SegmentationLut& lut) {
+
+    CV_Assert(lut.bits > 0 && lut.bits <= 8 && lut.table.size() == static_cast<size_t> (1 << (3 * lut.bits)));
+
+    SegmentationLutReport report;
+    report.nb_cells = static_cast<long> (lut.table.size());
+
+    // A cell is mixed as soon as one of its colours disagrees with the table
+    std::vector< bool > mixed(lut.table.size(), false);
+    for_each_colour_labels(lut, [&](const int& r, const int& g, const int& b, const uchar& labels) {
+        const int idx = seg_lut_index(r, g, b, lut.bits);
+        const uchar diff = labels ^ lut.table[idx];
+        report.nb_colours++;
+        report.nb_mismatch_red += (diff & SEG_LABEL_RED) ? 1 : 0;
+        report.nb_mismatch_blue += (diff & SEG_LABEL_BLUE) ? 1 : 0;
+        report.nb_mismatch_log += (diff & SEG_LABEL_LOG) ? 1 : 0;
+        if (diff)
+            mixed[idx] = true;
+    });
+
+    for (size_t idx = 0; idx < mixed.size(); ++idx)
+        report.nb_mixed_cells += mixed[idx] ? 1 : 0;
+
+    return report;
+}
+
+/*
+   * Segmentation of an RGB image with a look-up table
+   */
+void seg_lut(const cv::Mat& rgb_image, cv::Mat& seg_image, const SegmentationLut& lut, const uchar& labels) {
+
+    // Check that the image has three channels and that the table has been built
+    CV_Assert(rgb_image.type() == CV_8UC3);
+    CV_Assert(lut.bits > 0 && lut.bits <= 8 && lut.table.size() == static_cast<size_t> (1 << (3 * lut.bits)));
+
+    // Create the ouput the image
+    seg_image.create(rgb_image.size(), CV_8UC1);
+
+    const int shift = 8 - lut.bits;
+    const int bits = lut.bits;
+    const uchar* table = lut.table.data();
+    for (int i = 0; i < rgb_image.rows; ++i) {
+        const uchar *rgb_data = rgb_image.ptr<uchar> (i);
+        uchar *seg_data = seg_image.ptr<uchar> (i);
+        for (int j = 0; j < rgb_image.cols; ++j, rgb_data += 3) {
+            // The image in opencv are encoded in BGR and not RGB
+            const int idx = ((rgb_data[2] >> shift) << (2 * bits)) | ((rgb_data[1] >> shift) << bits) | (rgb_data[0] >> shift);
+            *seg_data++ = (table[idx] & labels) ? 255 : 0;
+        }
+    }
+}
+
+/*
+   * Labelling of an RGB image with a look-up table
+   */
+void seg_lut_labels(const cv::Mat& rgb_image, cv::Mat& label_image, const SegmentationLut& lut) {
+
+    // Check that the image has three channels and that the table has been built
+    CV_Assert(rgb_image.type() == CV_8UC3);
+    CV_Assert(lut.bits > 0 && lut.bits <= 8 && lut.table.size() == static_cast<size_t> (1 << (3 * lut.bits)));
+
+    // Create the ouput the image
+    label_image.create(rgb_image.size(), CV_8UC1);
+
+    const int shift = 8 - lut.bits;
+    const int bits = lut.bits;
+    const uchar* table = lut.table.data();
+    for (int i = 0; i < rgb_image.rows; ++i) {
+        const uchar *rgb_data = rgb_image.ptr<uchar> (i);
+        uchar *label_data = label_image.ptr<uchar> (i);
+        for (int j = 0; j < rgb_image.cols; ++j, rgb_data += 3)
+            *label_data++ = table[((rgb_data[2] >> shift) << (2 * bits)) | ((rgb_data[1] >> shift) << bits) | (rgb_data[0] >> shift)];
     }
 }
 
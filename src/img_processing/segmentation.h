@@ -69,12 +69,88 @@ the use of this software, even if advised of the possibility of such damage.
 #define B_SAT_MIN 39 // B_SAT_MIN 20
 #define B_CONDITION (h < hue_max && h > hue_min) && s > sat_min
 
+/* Definition of the segmentation labels -- bits of a CV_8UC1 label image */
+#define SEG_LABEL_RED 1  // normalised hue segmentation of the red traffic signs
+#define SEG_LABEL_BLUE 2 // normalised hue segmentation of the blue traffic signs
+#define SEG_LABEL_LOG 4  // log chromatic segmentation (red traffic signs)
+// Masks of the traffic signs
+#define SEG_MASK_RED (SEG_LABEL_RED | SEG_LABEL_LOG)
+#define SEG_MASK_BLUE SEG_LABEL_BLUE
+#define SEG_MASK_ALL (SEG_LABEL_RED | SEG_LABEL_BLUE | SEG_LABEL_LOG)
+
+/* Definition for look-up table segmentation */
+// Number of bits kept per channel -- 8 bits gives an exact table of 16 MB, 6 bits a table of 256 KB
+#define SEG_LUT_BITS 6
+
 namespace segmentation {
 
+// Quantised BGR -> labels look-up table
+struct SegmentationLut {
+    SegmentationLut() : bits(0), r_hue_max(R_HUE_MAX), r_hue_min(R_HUE_MIN), r_sat_min(R_SAT_MIN),
+        b_hue_max(B_HUE_MAX), b_hue_min(B_HUE_MIN), b_sat_min(B_SAT_MIN) {}
+
+    // Number of bits kept per channel
+    int bits;
+    // Thresholds of the normalised hue segmentation used to build the table
+    int r_hue_max, r_hue_min, r_sat_min;
+    int b_hue_max, b_hue_min, b_sat_min;
+    // One cell per quantised colour, indexed by (r << 2 * bits) | (g << bits) | b -- each cell holds the majority labels of its colours
+    std::vector< uchar > table;
+};
+
+// Agreement between a look-up table and the analytic segmentation over the 2^24 BGR colours
+struct SegmentationLutReport {
+    SegmentationLutReport() : nb_colours(0), nb_mismatch_red(0), nb_mismatch_blue(0), nb_mismatch_log(0), nb_cells(0), nb_mixed_cells(0) {}
+
+    bool exact() const { return nb_mismatch_red == 0 && nb_mismatch_blue == 0 && nb_mismatch_log == 0; }
+
+    long nb_colours;
+    // Number of colours for which the table gives another label than the analytic path
+    long nb_mismatch_red;
+    long nb_mismatch_blue;
+    long nb_mismatch_log;
+    // Number of cells whose colours do not all share the same labels
+    long nb_cells;
+    long nb_mixed_cells;
+};
+
+// The rows of the pixel loops are shared between nb_threads threads -- 1 runs serially, 0 uses every core
+
 // Segmentation of logarithmic chromatic images
-void seg_log_chromatic(const std::vector< cv::Mat >& log_image, cv::Mat& log_image_seg);
+void seg_log_chromatic(const std::vector< cv::Mat >& log_image, cv::Mat& log_image_seg, const int& nb_threads = 1);
+
+// Segmentation of the log chromatic condition straight from an RGB image -- integer look-ups in a 256 x 256 ratio table,
+// same mask than rgb_to_log_rb followed by seg_log_chromatic without any logarithm nor float plane
+void seg_log_chromatic_rgb(const cv::Mat& rgb_image, cv::Mat& log_image_seg, const int& nb_threads = 1);
 
 // Segmentation of normalised hue
-void seg_norm_hue(const cv::Mat& ihls_image, cv::Mat& nhs_image, const int& colour = 0, int hue_max = R_HUE_MAX, int hue_min = R_HUE_MIN, int sat_min = R_SAT_MIN);
+void seg_norm_hue(const cv::Mat& ihls_image, cv::Mat& nhs_image, const int& colour = 0, int hue_max = R_HUE_MAX, int hue_min = R_HUE_MIN, int sat_min = R_SAT_MIN,
+                  const int& nb_threads = 1);
+
+// Segmentation of normalised hue for the red and the blue traffic signs in a single pass -- SEG_LABEL_RED and SEG_LABEL_BLUE labels
+void seg_norm_hue_labels(const cv::Mat& ihls_image, cv::Mat& label_image, const int& nb_threads = 1);
+
+// Fused conversion and segmentation -- equivalent to seg_norm_hue (red) OR seg_log_chromatic computed in a single pass over the RGB image
+void seg_fused(const cv::Mat& rgb_image, cv::Mat& seg_image, const int& nb_threads = 1);
+
+// Fused conversion and segmentation of the red and blue traffic signs -- SEG_LABEL_RED, SEG_LABEL_BLUE and SEG_LABEL_LOG labels in a single pass over the RGB image
+void seg_fused_labels(const cv::Mat& rgb_image, cv::Mat& label_image, const int& nb_threads = 1);
+
+// Binary mask of the pixels holding at least one of the requested labels
+void labels_to_mask(const cv::Mat& label_image, cv::Mat& mask, const uchar& labels);
+
+// Build the look-up table of a colour configuration -- the thresholds are the ones of seg_norm_hue
+void build_seg_lut(SegmentationLut& lut, const int& bits = SEG_LUT_BITS,
+                   const int& r_hue_max = R_HUE_MAX, const int& r_hue_min = R_HUE_MIN, const int& r_sat_min = R_SAT_MIN,
+                   const int& b_hue_max = B_HUE_MAX, const int& b_hue_min = B_HUE_MIN, const int& b_sat_min = B_SAT_MIN);
+
+// Compare a look-up table with the analytic segmentation on every BGR colour
+SegmentationLutReport seg_lut_report(const SegmentationLut& lut);
+
+// Segmentation of an RGB image with a look-up table -- a pixel is set to 255 if its cell holds one of the requested labels
+void seg_lut(const cv::Mat& rgb_image, cv::Mat& seg_image, const SegmentationLut& lut, const uchar& labels = SEG_MASK_RED);
+
+// Labels of an RGB image read in a look-up table
+void seg_lut_labels(const cv::Mat& rgb_image, cv::Mat& label_image, const SegmentationLut& lut);
 
 }
@@ -133,202 +133,176 @@ double RationalSuperShape2D :: radius ( const double angle ){
 // std::cout << std::endl;
 // }
 //Potential fields
+//values and partial derivatives of the q intersections of an implicit function
+//stored on the stack unless q is larger than IMPLICIT_MAX_INTERSECTIONS
+struct IntersectionBuffer {
+    explicit IntersectionBuffer(double q) : size(q > 0 ? static_cast<int>(ceil(q)) : 0) {
+        f = f_fixed; Df = Df_fixed;
+        if (size > IMPLICIT_MAX_INTERSECTIONS) {
+            f_heap.resize(size); Df_heap.resize(size);
+            f = &f_heap[0]; Df = &Df_heap[0];
+        }
+    }
+    int size;
+    double *f;
+    Vector3d *Df;
+    double f_fixed[IMPLICIT_MAX_INTERSECTIONS];
+    Vector3d Df_fixed[IMPLICIT_MAX_INTERSECTIONS];
+    std::vector<double> f_heap;
+    std::vector<Vector3d> Df_heap;
+};
+//sort the intersections by decreasing values then combine them as (...((F1 v F2) v F3 ) v F4) v ...)
+static double RpUnionIntersections(IntersectionBuffer &buffer, Vector3d &Dffinal)
+{
+    double *f = buffer.f;
+    Vector3d *Df = buffer.Df;
+    //bubble sort, not really efficient but acceptable for such small arrays
+    for(int i=0; i<buffer.size-1; i++)
+        for (int j=i+1; j<buffer.size; j++)
+            if (f[i]<f[j])
+            {
+                std::swap(f[i],f[j]);
+                std::swap(Df[i],Df[j]);
+            }
+    //iterative evaluation of the resulting R-function and of the associated partial derivatives
+    double f1 (f[0]);
+    Dffinal = Df[0];
+    for(int i=1; i<buffer.size; i++)
+        RpUnion(f1, f[i], Dffinal, Df[i], f1, Dffinal);
+    return f1;
+}
+//radius and dr/dtheta of the first intersection of the implicit functions, theta in [0, 2Pi)
+static double FirstIntersectionRadius(RationalSuperShape2D &shape, const Vector2d &P, double &drdth)
+{
+    double drda, drdb, drdn1, drdn2, drdn3;
+    drdth = 0;
+    if ( P[0] == 0 && P[1] == 0) return 0;
+    double tht (atan2(P[1],P[0]));
+    if (tht<0) tht += 2.*M_PI;
+    return shape.RadiusAndDerivatives(tht, drda, drdb, drdn1, drdn2, drdn3, drdth);
+}
 double RationalSuperShape2D :: ImplicitFunction1( const Vector2d P, std::vector<double> &Dffinal) {
-    Dffinal.clear();
+    Vector3d Df;
+    const double f (ImplicitFunction1(P, Df));
+    Dffinal.assign(Df.data(), Df.data() + 3);
+    return f;
+}
+double RationalSuperShape2D :: ImplicitFunction2( const Vector2d P, std::vector<double> &Dffinal) {
+    Vector3d Df;
+    const double f (ImplicitFunction2(P, Df));
+    Dffinal.assign(Df.data(), Df.data() + 3);
+    return f;
+}
+double RationalSuperShape2D :: ImplicitFunction3( const Vector2d P, std::vector<double> &Dffinal) {
+    Vector3d Df;
+    const double f (ImplicitFunction3(P, Df));
+    Dffinal.assign(Df.data(), Df.data() + 3);
+    return f;
+}
+double RationalSuperShape2D :: ImplicitFunction1( const Vector2d &P, Vector3d &Dffinal) {
+    double drdth0;
+    const double R0 (FirstIntersectionRadius(*this, P, drdth0));
+    return ImplicitFunction1(P, Dffinal, R0, drdth0);
+}
+double RationalSuperShape2D :: ImplicitFunction1( const Vector2d &P, Vector3d &Dffinal, double R0, double drdth0) {
     // nothing computable, return zero values, zero partial derivatives
     // the point will have no effect on the ongoing computations
     if ( P[0] == 0 && P[1] == 0)
     {
         // Df/Dx, Df/Dy, Df/Dr set to zero...
-        for (int i=0; i<3; i++) Dffinal.push_back(0);
+        Dffinal.setZero();
         return 0;
     }
-    std::vector<double> f, Ddum;
-    double x(P[0]), y(P[1]), PSL(P.squaredNorm()), PL(sqrt(PSL)), dthtdx (-y/PSL), dthtdy (x/PSL), R,drdth;
-    std::vector< std::vector<double> > Df;
+    IntersectionBuffer buffer(Get_q());
+    double x(P[0]), y(P[1]), PSL(P.squaredNorm()), PL(sqrt(PSL)), dthtdx (-y/PSL), dthtdy (x/PSL), R,drdth, drda,drdb,drdn1,drdn2,drdn3;
     //assert angular values between [0, 2q*Pi]
     double tht (atan2(y,x)), thtbase(tht);
     if (tht<0) thtbase += 2.*M_PI;
     //compute all intersections and associated partial derivatives
-    for (int i=0; i<Get_q(); i++)
+    for (int i=0; i<buffer.size; i++)
     {
         tht = thtbase + i*2.*M_PI;
-        R = radius(tht);
-        f.push_back(R - PL); //store function
+        if (i == 0) {
+            R = R0; drdth = drdth0;
+        }
+        else R = RadiusAndDerivatives(tht, drda, drdb, drdn1, drdn2, drdn3, drdth);
+        buffer.f[i] = R - PL; //store function
         // store partial derivatives
-        std::vector<double> rowi;
-        drdth = DrDtheta(tht);
-        rowi.push_back( drdth*dthtdx - cos(tht)); //df/dx
-        rowi.push_back( drdth*dthtdy - sin(tht)); //df/dy
-        rowi.push_back( 1. ); //df/dr
-        Df.push_back(rowi);
+        buffer.Df[i] << drdth*dthtdx - cos(tht), //df/dx
+                        drdth*dthtdy - sin(tht), //df/dy
+                        1.; //df/dr
     }
-    //bubble sort, not really efficient but acceptable for such small arrays
-    for(int i=0; i<Get_q()-1; i++)
-        for (int j=i+1; j<Get_q(); j++)
-            if (f[i]<f[j])
-            {
-                //std::swap values of f[i] and f[j]
-                std::swap(f[i],f[j]);
-                //std::swap rows Df[i] and Df[j]
-                Df[i].swap(Df[j]);
-            }
-    //Compute resulting Rfunction
-    std::vector<double> Df1; //std::vectorfor df/dxi
-    //iterative evaluation of:
-    // -the resulting R-functions
-    // -the associated partial derivatives
-    double f1,fdum;
-    f1 = f[0]; // first value of f
-    Df1 = Df[0]; // first associated row with partial derivatives
-    //combine functions as (...((F1 v F2) v F3 ) v F4) v ...)
-    for(int i=1; i<Get_q(); i++) // for all intersections
-    {
-        //compute R-function, sets all partial derivatives
-        //fdum and Ddum temporary results of the union from F1 to Fi
-        RpUnion(f1, f[i], Df1, Df[i], fdum, Ddum);
-        //update results in f1 and Df1, and iterate
-        f1 = fdum;
-        Df1 = Ddum;
-    }
-    //final partial derivatives df/dxi after R-functions
-    Dffinal = Df1;
-    //clear arrays
-    f.clear(); Df.clear(); Ddum.clear(); Df1.clear();
-    //return results
-    return f1;
+    return RpUnionIntersections(buffer, Dffinal);
+}
+double RationalSuperShape2D :: ImplicitFunction2( const Vector2d &P, Vector3d &Dffinal) {
+    double drdth0;
+    const double R0 (FirstIntersectionRadius(*this, P, drdth0));
+    return ImplicitFunction2(P, Dffinal, R0, drdth0);
 }
-double RationalSuperShape2D :: ImplicitFunction2( const Vector2d P, std::vector<double> &Dffinal){
-    Dffinal.clear();
+double RationalSuperShape2D :: ImplicitFunction2( const Vector2d &P, Vector3d &Dffinal, double R0, double drdth0){
     // nothing computable, return zero values, zero partial derivatives
     // the point will have no effect on the ongoing computations
     if ( P[0] == 0 && P[1] == 0)
     {
         // Df/Dx, Df/Dy, Df/Dr set to zero...
-        for (int i=0; i<3; i++) Dffinal.push_back(0);
+        Dffinal.setZero();
         return 0;
     }
-    std::vector<double> f, Ddum;
-    double x(P[0]), y(P[1]), PSL(P.squaredNorm()), PL(sqrt(PSL)), dthtdx (-y/PSL), dthtdy (x/PSL), R,drdth;
-    std::vector<std::vector<double> > Df;
+    IntersectionBuffer buffer(Get_q());
+    double x(P[0]), y(P[1]), PSL(P.squaredNorm()), PL(sqrt(PSL)), dthtdx (-y/PSL), dthtdy (x/PSL), R,drdth, drda,drdb,drdn1,drdn2,drdn3;
     //assert angular values between [0, 2q*Pi]
     double tht (atan2(y,x)), thtbase(tht);
     if (tht<0) thtbase += 2.*M_PI;
     //compute all intersections and associated gradient values
-    for (int i=0; i<Get_q(); i++)
+    for (int i=0; i<buffer.size; i++)
     {
         tht = thtbase + i*2.*M_PI;
-        R = radius(tht);
-        drdth = DrDtheta(tht);
-        f.push_back(1. - PL/R); //store function
+        if (i == 0) {
+            R = R0; drdth = drdth0;
+        }
+        else R = RadiusAndDerivatives(tht, drda, drdb, drdn1, drdn2, drdn3, drdth);
+        buffer.f[i] = 1. - PL/R; //store function
         // store partial derivatives
-        std::vector<double> rowi;
-        drdth = DrDtheta(tht);
-        rowi.push_back( - ( x*R/PL - drdth*dthtdx*PL )/(R*R) ); //df/dx
-        rowi.push_back( - ( y*R/PL - drdth*dthtdy*PL )/(R*R) ); //df/dy
-        rowi.push_back( PL/(R*R) ); //df/dr
-        Df.push_back(rowi);
-    }
-    //bubble sort, not really efficient but acceptable for such small arrays
-    for(int i=0; i<Get_q()-1; i++)
-        for (int j=i+1; j<Get_q(); j++)
-            if (f[i]<f[j])
-            {
-                //std::swap values of f[i] and f[j]
-                std::swap(f[i],f[j]);
-                //std::swap rows Df[i] and Df[j]
-                Df[i].swap(Df[j]);
-            }
-    //Compute resulting Rfunction
-    std::vector<double> Df1; //std::vectorfor df/dxi
-    //iterative evaluation of:
-    // -the resulting R-functions
-    // -the associated partial derivatives
-    double f1,fdum;
-    f1 = f[0]; // first value of f
-    Df1 = Df[0]; // first associated row with partial derivatives
-    //combine functions as (...((F1 v F2) v F3 ) v F4) v ...)
-    for(int i=1; i<Get_q(); i++) // for all intersections
-    {
-        //compute R-function, sets all partial derivatives
-        //fdum and Ddum temporary results of the union from F1 to Fi
-        RpUnion(f1, f[i], Df1, Df[i], fdum, Ddum);
-        //update results in f1 and Df1, and iterate
-        f1 = fdum;
-        Df1 = Ddum;
+        buffer.Df[i] << - ( x*R/PL - drdth*dthtdx*PL )/(R*R), //df/dx
+                        - ( y*R/PL - drdth*dthtdy*PL )/(R*R), //df/dy
+                        PL/(R*R); //df/dr
     }
-    //final partial derivatives df/dxi after R-functions
-    Dffinal = Df1;
-    //clear arrays
-    f.clear(); Df.clear(); Ddum.clear(); Df1.clear();
-    //return results
-    return f1;
+    return RpUnionIntersections(buffer, Dffinal);
+}
+double RationalSuperShape2D :: ImplicitFunction3( const Vector2d &P, Vector3d &Dffinal) {
+    double drdth0;
+    const double R0 (FirstIntersectionRadius(*this, P, drdth0));
+    return ImplicitFunction3(P, Dffinal, R0, drdth0);
 }
-double RationalSuperShape2D :: ImplicitFunction3( const Vector2d P, std::vector<double> &Dffinal){
-    Dffinal.clear();
+double RationalSuperShape2D :: ImplicitFunction3( const Vector2d &P, Vector3d &Dffinal, double R0, double drdth0){
     // nothing computable, return zero values, zero partial derivatives
     // the point will have no effect on the ongoing computations
     if ( P[0] == 0 && P[1] == 0)
     {
         // Df/Dx, Df/Dy, Df/Dr set to zero...
-        for (int i=0; i<3; i++) Dffinal.push_back(0);
+        Dffinal.setZero();
         return 0;
     }
-    std::vector<double> f, Ddum;
-    double x(P[0]), y(P[1]), PSL(P.squaredNorm()), dthtdx (-y/PSL), dthtdy (x/PSL), R,drdth;
-    std::vector< std::vector<double> > Df;
+    IntersectionBuffer buffer(Get_q());
+    double x(P[0]), y(P[1]), PSL(P.squaredNorm()), dthtdx (-y/PSL), dthtdy (x/PSL), R,drdth, drda,drdb,drdn1,drdn2,drdn3;
     //assert angular values between [0, 2q*Pi]
     double tht (atan2(y,x)), thtbase(tht);
     if (tht<0) thtbase += 2.*M_PI;
     //compute all intersections and associated gradient values
-    for (int i=0; i<Get_q(); i++)
+    for (int i=0; i<buffer.size; i++)
     {
         tht = thtbase + i*2.*M_PI;
-        R = radius(tht);
-        drdth = DrDtheta(tht);
-        f.push_back( log( R*R / PSL)); //store function
+        if (i == 0) {
+            R = R0; drdth = drdth0;
+        }
+        else R = RadiusAndDerivatives(tht, drda, drdb, drdn1, drdn2, drdn3, drdth);
+        buffer.f[i] = log( R*R / PSL); //store function
         // store partial derivatives
-        drdth = DrDtheta(tht);
-        std::vector<double> rowi;
-        rowi.push_back( -2.*(x*R - PSL * drdth*dthtdx)/(R*PSL) ); //df/dx
-        rowi.push_back( -2.*(y*R - PSL * drdth*dthtdy)/(R*PSL) ); //df/dy
-        rowi.push_back( 2./R ); //df/dr
-        Df.push_back(rowi);
+        buffer.Df[i] << -2.*(x*R - PSL * drdth*dthtdx)/(R*PSL), //df/dx
+                        -2.*(y*R - PSL * drdth*dthtdy)/(R*PSL), //df/dy
+                        2./R; //df/dr
     }
-    //bubble sort, not really efficient but acceptable for such small arrays
-    for(int i=0; i<Get_q()-1; i++)
-        for (int j=i+1; j<Get_q(); j++)
-            if (f[i]<f[j])
-            {
-                //std::swap values of f[i] and f[j]
-                std::swap(f[i],f[j]);
-                //std::swap rows Df[i] and Df[j]
-                Df[i].swap(Df[j]);
-            }
-    //Compute resulting Rfunction
-    std::vector<double> Df1; //std::vectorfor df/dxi
-    //iterative evaluation of:
-    // -the resulting R-functions
-    // -the associated partial derivatives
-    double f1,fdum;
-    f1 = f[0]; // first value of f
-    Df1 = Df[0]; // first associated row with partial derivatives
-    //combine functions as (...((F1 v F2) v F3 ) v F4) v ...)
-    for(int i=1; i<Get_q(); i++) // for all intersections
-    {
-        //compute R-function, sets all partial derivatives
-        //fdum and Ddum temporary results of the union from F1 to Fi
-        RpUnion(f1, f[i], Df1, Df[i], fdum, Ddum);
-        //update results in f1 and Df1, and iterate
-        f1 = fdum;
-        Df1 = Ddum;
-    }
-    //final partial derivatives df/dxi after R-functions
-    Dffinal = Df1;
-    //clear arrays
-    f.clear(); Df.clear(); Ddum.clear(); Df1.clear();
-    //return results
-    return f1;
+    return RpUnionIntersections(buffer, Dffinal);
 }
 double RationalSuperShape2D :: DrDtheta(double tht)
 {
@@ -361,6 +335,39 @@ pow( pow(C,n2) / a + pow(S,n3)/b , -1./n1 - 1.)*
                 );
     return V.sum() / (12.*delta);
 }
+double RationalSuperShape2D :: RadiusAndDerivatives(const double tht, double &DrDa, double &DrDb, double &DrDn1, double &DrDn2, double &DrDn3, double &DrDtht)
+{
+    // r = U^(-1/n1) with U = A + B, A = |cos(k*tht)|^n2 / a, B = |sin(k*tht)|^n3 / b and k = p / 4q
+    double a(Get_a()), b(Get_b()), n1(Get_n1()), n2(Get_n2()), n3(Get_n3()), k(Get_p() * 0.25 / Get_q());
+    double c ( cos(k*tht) ), s ( sin(k*tht) ), C ( fabs(c) ), S ( fabs(s) );
+    double logC ( C > 0 ? log(C) : 0 ), logS ( S > 0 ? log(S) : 0 );
+    double A ( (C > 0 ? exp(n2*logC) : pow(C, n2)) / a );
+    double B ( (S > 0 ? exp(n3*logS) : pow(S, n3)) / b );
+    double U ( A + B );
+    if( U == 0 ) {
+        std::cout<<"ERROR RADIUS NULL"<<std::endl;
+        DrDa = DrDb = DrDn1 = DrDn2 = DrDn3 = DrDtht = 0;
+        return 0;
+    }
+    double logU ( log(U) ), r ( exp(-logU / n1) ), rn1U ( r / (n1*U) );
+    DrDa = rn1U * A / a;
+    DrDb = rn1U * B / b;
+    DrDn1 = r * logU / (n1*n1);
+    // A*log(C) and B*log(S) vanish with C and S
+    DrDn2 = - rn1U * A * logC;
+    DrDn3 = - rn1U * B * logS;
+    // dU/dtht, the term of a vanishing cosine or sine is not differentiable for n2 or n3 below 1 and is dropped
+    double dUdtht(0);
+    if( C > EPSILON ) dUdtht -= n2 * A * s / c;
+    if( S > EPSILON ) dUdtht += n3 * B * c / s;
+    DrDtht = - rn1U * k * dUdtht;
+    return r;
+}
+void RationalSuperShape2D :: GetPartialDerivatives(double tht, double &DrDa, double &DrDb, double &DrDn1, double &DrDn2, double &DrDn3)
+{
+    double DrDtht;
+    RadiusAndDerivatives(tht, DrDa, DrDb, DrDn1, DrDn2, DrDn3, DrDtht);
+}
 double RationalSuperShape2D :: DrDa(const double tht)
 {
     //analytic version
@@ -507,19 +514,21 @@ log(S)*bSn3 / Get_n1();
                 );
     return V.sum() / (12.*delta);
 }
-void RpUnion(double f1, double f2, std::vector<double> Df1, std::vector<double> Df2, double &f, std::vector<double> &Df)
+void RpUnion(double f1, double f2, const std::vector<double> &Df1, const std::vector<double> &Df2, double &f, std::vector<double> &Df)
 {
     assert(Df1.size() == Df2.size());
-    Df.clear();
-    f = f1+f2+sqrt(f1*f1+f2*f2);
+    //element-wise, so that Df may be Df1 or Df2
+    const double norm (sqrt(f1*f1+f2*f2));
+    Df.resize(Df1.size());
+    f = f1+f2+norm;
     if(f1 != 0 || f2 != 0) // function differentiable
-        for(unsigned int i=0; i<Df1.size(); i++)
-            Df.push_back( Df1[i] + Df2[i] + (f1*Df1[i]+f2*Df2[i])/sqrt(f1*f1+f2*f2) );
+        for(unsigned int i=0; i<Df.size(); i++)
+            Df[i] = Df1[i] + Df2[i] + (f1*Df1[i]+f2*Df2[i])/norm;
     else //function not differentiable, set everything to zero
-        for(unsigned int i=0; i<Df1.size(); i++)
-            Df.push_back( 0 );
+        for(unsigned int i=0; i<Df.size(); i++)
+            Df[i] = 0;
 }
-void RpIntersection(double f1, double f2, std::vector<double> Df1, std::vector<double> Df2, double &f, std::vector<double> &Df)
+void RpIntersection(double f1, double f2, const std::vector<double> &Df1, const std::vector<double> &Df2, double &f, std::vector<double> &Df)
 {
     assert(Df1.size() == Df2.size());
     Df.clear();
@@ -531,92 +540,115 @@ void RpIntersection(double f1, double f2, std::vector<double> Df1, std::vector<d
         for(unsigned int i=0; i<Df1.size(); i++)
             Df.push_back( 0 );
 }
-void RationalSuperShape2D :: Optimize5D(
-        std::string outfilename,
-        std::vector< Vector2d, aligned_allocator< Vector2d> > Data,
+template < int Dim, ImplicitFunctionPtr ImplicitFn >
+bool LevenbergMarquardt< Dim, ImplicitFn > :: Optimize(
+        const PointSpan &Data,
         double &err ,
-        int functionused
+        double abortbound,
+        int *nbiterations,
+        std::ostream *logfile,
+        int *nbevaluations,
+        int *nbsavedevaluations,
+        double *checkpointerr
         )
 {
     double NewChiSquare, ChiSquare(1e15), OldChiSquare(1e15);
-    std::ofstream logfile;
-    logfile.open(outfilename.c_str());
     bool STOP(false);
-    double oldparams[] ={0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}; //dj[16];
-    double LAMBDA_INCR(10), lambda(pow(LAMBDA_INCR, -6));
-    MatrixXd alpha, alpha2;
-    alpha = MatrixXd::Zero(5,5);
-    alpha2 = MatrixXd::Zero(5,5);
-    VectorXd beta, beta2, dj, oldbeta, sigma;
-    beta = VectorXd::Zero(5);
-    beta2 = VectorXd::Zero(5);
-    dj = VectorXd::Zero(5);
-    oldbeta = VectorXd::Zero(5);
-    // trial = VectorXd::Zero(5);
-    // sigma = VectorXd::Zero(5);
-    logfile << *this;
+    std::vector<double> oldparams(m_shape.Parameters);
+    double LAMBDA_INCR(10);
+    double lambda(pow(LAMBDA_INCR, -6));
+    HessianType alpha, alpha2, system;
+    GradientType beta, beta2, step;
+    const int nb_evaluations_start(m_nb_evaluations);
+    int nb_saved(0);
 
-    std::vector<double> Df;
+    if (logfile != NULL) *logfile << m_shape;
+    //chi square, hessian approximation and gradient of the current parameters
+    //they are only evaluated once: the trial evaluation of an accepted step provides the ones of the next iteration
+    double CurrentChiSquare = XiSquare(Data,
+                                       alpha,
+                                       beta,
+                                       true); //update vectors
     int itnum = 0;
+    bool aborted(false);
     for(itnum=0; itnum<1000 && STOP==false; itnum++) {
         //store oldparams
-        for(size_t i=0; i<Parameters.size(); i++) oldparams[i] = Parameters[i];
-        alpha.setZero();
-        beta.setZero();
-        alpha2.setZero();
-        beta2.setZero();
-        //std::cout <<"TRIAL:"<<*this<<std::endl;
+        oldparams = m_shape.Parameters;
         bool outofbounds(false);
-        //std::cout <<"Norm on in Opt2 : "<<Normalization<<std::endl;
-        ChiSquare = XiSquare5D(Data,
-                               alpha,
-                               beta,
-                               functionused, //implicit function1
-                               true); //update vectors
+        ChiSquare = CurrentChiSquare;
+        //the hessian and gradient of the current parameters are known ==> no evaluation
+        if (itnum > 0) nb_saved += static_cast<int>(Data.size());
+        if (itnum <= OPTIMIZE_ABORT_MIN_ITERATIONS && checkpointerr != NULL) *checkpointerr = ChiSquare;
+        // another fit was better after the same number of iterations ==> give up
+        if (itnum == OPTIMIZE_ABORT_MIN_ITERATIONS && ChiSquare > abortbound)
+        {
+            aborted = true;
+            break;
+        }
         //
         // add Lambda to diagonla elements and solve the matrix
         //
         //Linearization of Hessian, cf Numerical Recepies
-        for(int k=0; k<5; k++)
+        system = alpha;
+        step = beta;
+        for(int k=0; k<Dim; k++)
         {
-            alpha(k,k) *= 1. + lambda; //multiplicative factor to make diagonal dominant
-            alpha(k,k) += lambda; //additive factor to avoid rank deficient matrix
+            system(k,k) *= 1. + lambda; //multiplicative factor to make diagonal dominant
+            system(k,k) += lambda; //additive factor to avoid rank deficient matrix
         }
-        //solve system
-        alpha.ldlt().solveInPlace(beta);
-        //coefficients a and b in [0.01, 100] to preserve numerical accuracy
-        outofbounds = Parameters[0] + beta[0] < 0.01 || Parameters[0] + beta[0] > 1000 ||
-                Parameters[1] + beta[1] < 0.01 || Parameters[1] + beta[1] > 1000 ||
-                Parameters[2] + beta[2] < 0.1 || Parameters[2] + beta[2]> 1000 ||
-                Parameters[3] + beta[3] < 0.1 || Parameters[3] + beta[3]> 1000 ||
-                Parameters[4] + beta[4] < 0.1 || Parameters[4] + beta[4]> 1000;
-        if( !outofbounds )
-        {
-            Set_a(Parameters[0] + beta[0]);
-            Set_b(Parameters[1] + beta[1]);
+        //solve system, the decomposition only reads the lower triangle
+        system.ldlt().solveInPlace(step);
+        //coefficients a and b in [0.01, 100]
+        const std::vector<double> &Parameters = m_shape.Parameters;
+        outofbounds = Parameters[0] + step[0] < 0.01 || Parameters[0] + step[0] > 1000 ||
+                Parameters[1] + step[1] < 0.01 || Parameters[1] + step[1] > 1000 ||
+                Parameters[2] + step[2] < 0.1 || Parameters[2] + step[2]> 1000 ||
+                Parameters[3] + step[3] < 0.1 || Parameters[3] + step[3]> 1000 ||
+                Parameters[4] + step[4] < 0.1 || Parameters[4] + step[4]> 1000;
+        if( !outofbounds ) {
+            m_shape.Set_a( Parameters[0] + step[0]);
+            m_shape.Set_b( Parameters[1] + step[1]);
             // coefficients n1 in [1., 1000]
             // setting n1<1. leads to strong numerical instabilities
-            Set_n1( Parameters[2] + beta[2] );
+            m_shape.Set_n1( Parameters[2] + step[2] );
             // coefficients n2,n3 in [0.001, 1000]
-            Set_n2( Parameters[3] + beta[3]);
-            Set_n3( Parameters[4] + beta[4]);
+            m_shape.Set_n2( Parameters[3] + step[3]);
+            m_shape.Set_n3( Parameters[4] + step[4]);
+            if (Dim > 5) {
+                // coefficients x0 and y0
+                //truncate translation to avoid huge gaps
+                step[5] = std::min(0.05, std::max(-0.05, step[5]));
+                step[6] = std::min(0.05, std::max(-0.05, step[6]));
+                m_shape.Parameters[9] += step[5];
+                m_shape.Parameters[10] += step[6];
+            }
+            if (Dim > 7) {
+                //same for rotational offset tht0
+                step[7] = std::min(M_PI/50., std::max(-M_PI/50., step[7]));
+                m_shape.Parameters[7] += step[7];
+            }
         }
         //
-        // Evaluate chisquare with new values
+        // Evaluate chisquare with new values, with the hessian and gradient in the same pass
         //
-        OldChiSquare=ChiSquare;
-        NewChiSquare=XiSquare5D(Data,
+        OldChiSquare = ChiSquare;
+        // the evaluation stops as soon as the step is known to be rejected
+        // the bound never goes below the convergence threshold, so that a truncated sum still tells if NewChiSquare < 1e-5
+        const int nb_evaluations_trial(m_nb_evaluations);
+        NewChiSquare = XiSquare(Data,
                                 alpha2,
                                 beta2,
-                                functionused, //implicit function
-                                false); // update alpha and beta or not
+                                true,
+                                std::max(0.999*OldChiSquare, 1e-5));
+        //the points after the truncation are not evaluated
+        nb_saved += static_cast<int>(Data.size()) - (m_nb_evaluations - nb_evaluations_trial);
         //
         // check if better result
         //
         if( NewChiSquare>0.999*OldChiSquare ) // new result sucks-->restore old params and try with lambda 10 times bigger
         {
             lambda *=LAMBDA_INCR;
-            for(size_t i=0; i<Parameters.size(); i++) Parameters[i]=oldparams[i];
+            m_shape.Parameters = oldparams;
         }
         else //successful iteration
         {
@@ -629,582 +661,215 @@ void RationalSuperShape2D :: Optimize5D(
             if (NewChiSquare <= 0.01*OldChiSquare) //99% improvement, impossible
             {
                 lambda *=LAMBDA_INCR; // reduce the step within the search direction
-                for(size_t i=0; i<Parameters.size(); i++) Parameters[i]=oldparams[i]; // restore old parameters
+                m_shape.Parameters = oldparams; // restore old parameters
             }
             else
             {
                 //correct and realistic improvement
-                logfile << *this;
+                if (logfile != NULL) *logfile << m_shape;
                 lambda /=LAMBDA_INCR;
+                //the new parameters become the current ones
+                CurrentChiSquare = NewChiSquare;
+                alpha = alpha2;
+                beta = beta2;
             }
         }
         STOP = lambda > 1e15 || NewChiSquare < 1e-5; // very small displacement ==> local convergence
     } //end for(...
     err = ChiSquare;
-    logfile << *this;
-    logfile.close();
+    if (nbiterations != NULL) *nbiterations = itnum;
+    if (nbevaluations != NULL) *nbevaluations = m_nb_evaluations - nb_evaluations_start;
+    if (nbsavedevaluations != NULL) *nbsavedevaluations = nb_saved;
+    if (logfile != NULL) *logfile << m_shape;
+    return !aborted;
 }
-double RationalSuperShape2D :: XiSquare5D(
-        const std::vector< Vector2d, aligned_allocator< Vector2d> > Data,
-        MatrixXd &alpha,
-        VectorXd &beta,
-        int functionused,
-        bool update) {
-    //five dimensional optimization: a, b, n1, n2, n3 are optimized
-    VectorXd dj; dj = VectorXd::Zero(5);
-    Matrix3d Tr,Rot;
-    //functions pointer
-    double (RationalSuperShape2D ::*pt2ConstMember)(const Vector2d P, std::vector<double> &Dffinal) = NULL;
-    switch (functionused){
-    case 1 :{ pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction1; }break;
-    case 2 :{ pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction2; }break;
-    case 3 :{ pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction3; }break;
-    default : pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction1;
-    }
-    std::vector<double> Df;
-    double x, y, tht, ChiSquare(1e15), f(0),
-            x0(Get_xoffset()),y0(Get_yoffset()),tht0(Get_thtoffset());
+template < int Dim, ImplicitFunctionPtr ImplicitFn >
+double LevenbergMarquardt< Dim, ImplicitFn > :: XiSquare(
+        const PointSpan &Data,
+        HessianType &alpha,
+        GradientType &beta,
+        bool update,
+        double bound) {
+    GradientType dj;
+    Vector3d Df;
+    double tht, drda, drdb, drdn1, drdn2, drdn3, drdth, f(0),
+            x0(m_shape.Get_xoffset()),y0(m_shape.Get_yoffset()),tht0(m_shape.Get_thtoffset());
+    //inverse rotation, i.e. transposed rotation
+    const double cos0(cos(tht0)), sin0(sin(tht0));
     //clean memory
-    if ( update ) {
+    if(update)
+    {
         alpha.setZero();
         beta.setZero();
     }
     //evaluate ChiSquare, components for the beta and matrix alpha
-    ChiSquare=0;
-    //First define inverse translation T-1
-    Tr.setZero();
-    Rot.setZero();
-    Tr << 1 , 0 , -x0 ,
-            0 , 1 , -y0 ,
-            0 , 0 , 1;
-    //Then define inverse rotation, i.e. transposed rotation
-    Rot << cos(tht0) , sin(tht0) , 0 ,
-            -sin(tht0) , cos(tht0) , 0 ,
-            0 , 0 , 1;
-    //summation of squared potentials
-    for(size_t i=0; i<Data.size(); i++ ){
-        double DfDr;
+    double ChiSquare(0);
+    for(size_t i=0; i<Data.size(); i++){
+        m_nb_evaluations++;
         //global inverse transform is T * R
-        Vector2d dum(Data[i]);
-        Vector3d dum2(dum[0],dum[1],1);
-        //apply inverse transform
-        Vector3d dum3 ( Rot * (Tr * dum2));
-        Vector2d P( dum3[0], dum3[1]); //2D point in canonical referential
-        //get partial derivatives for canonical point
-        x = P[0]; y = P[1];
+        const Vector2d dum(Data[i]);
+        const double dx(dum[0] - x0), dy(dum[1] - y0);
+        const Vector2d P(cos0 * dx + sin0 * dy, -sin0 * dx + cos0 * dy); //2D point in canonical referential
         // avoid division by 0 ==> numerical stability
         if (P.norm()<EPSILON) continue; // avoids division by zero
-        tht = atan2(y,x); if( tht<0) tht+=2.*M_PI;
-        //theta = Arctan(Y/X)
-
-        //avoid non differentiable cases
-        f = (*this.*pt2ConstMember)(P, Df); // call to the implicit function
+        tht = atan2(P[1],P[0]); if( tht<0) tht+=2.*M_PI;
+        //radius derivatives regarding the parameters and theta, the radius and dr/dtheta are reused for the first intersection of the implicit function
+        const double R (m_shape.RadiusAndDerivatives(tht, drda, drdb, drdn1, drdn2, drdn3, drdth));
+        f = (m_shape.*ImplicitFn)(P, Df, R, drdth); // call to the implicit function, inlined
         //
         //compute elements beta[i][0] and alpha[i][j]
         //
         //==> requires partial derivatives!!
-        DfDr = Df[2]; //Df/Dr stored at index 2 in array Df during the call to ImplicitFunction1-2-3
+        const double DfDr(Df[2]); //Df/Dr stored at index 2 in array Df during the call to ImplicitFunction1-2-3
         // F1 = R-PL ==> DfDr = 1. ;
         // F2 = 1-PL/R ==> DfDr = PL/R\B2 ;
         // F3 = log ( R\B2/PSL) ==> DfDr = 2/R
-        dj.setZero();
         //df/da = df/dr * dr/da
-        dj[0] = DfDr * DrDa(tht) ;
+        dj[0] = DfDr * drda ;
         //df/db = df/dr * dr/db
-        dj[1] = DfDr * DrDb(tht) ;
+        dj[1] = DfDr * drdb ;
         //df/dn1 = df/dr * dr/dn1
-        dj[2] = DfDr * DrDn1(tht);
+        dj[2] = DfDr * drdn1;
         //df/dn2 = df/dr * dr/dn2
-        dj[3] = DfDr * DrDn2(tht);
+        dj[3] = DfDr * drdn2;
         //df/dn3 = df/dr * dr/dn3
-        dj[4] = DfDr * DrDn3(tht);
-        ChiSquare += f*f;
-        if(update){
-            //gradient beta
-            for(int k=0;k<5; k++)
-            {
-                beta[k] -= f * dj[k];
+        dj[4] = DfDr * drdn3;
+        if (Dim > 5) {
+            //theta = Arctan(Y/X)
+            const double dthtdx(-sin(tht)), dthtdy(cos(tht));
+            //partial derivatives of theta regarding x offset and y offset, with dP/dx0 = (-cos0, sin0) and dP/dy0 = (-sin0, -cos0)
+            const double dthtdx0(dthtdx * -cos0 + dthtdy * sin0);
+            const double dthtdy0(dthtdx * -sin0 + dthtdy * -cos0);
+            //df/dx0 = df/dr * dr/dtht *dtht/dx0
+            dj[5]= DfDr * drdth*dthtdx0;
+            //df/dy0 = df/dr * dr/dtht *dtht/dy0
+            dj[6]= DfDr * drdth*dthtdy0;
+            if (Dim > 7) {
+                //partial derivative of theta regarding angular offset, with dP/dtht0 = (P[1], -P[0])
+                const double dthtdtht0(dthtdx * P[1] + dthtdy * -P[0]);
+                //df/dth0 = dfdr * dr/dtht * dtht/dtht0
+                dj[7]= DfDr * drdth*dthtdtht0;
             }
-            //compute approximation of Hessian matrix
-            for(int k=0; k<5; k++)
-                for(int j=0; j<5; j++)
+        }
+        ChiSquare += f*f;
+        // the sum can only grow ==> the rest of the points is useless
+        if( ChiSquare > bound ) break;
+        if( update ){
+            beta -= f*dj;
+            //compute approximation of Hessian matrix, the lower triangle is enough for the LDLT solve
+            for(int k=0; k<Dim; k++)
+                for(int j=0; j<=k; j++)
                     alpha(k,j) += dj[k]*dj[j];
         }
     }//for all vertices
     return ChiSquare;
 }
+
+template class LevenbergMarquardt< 5, &RationalSuperShape2D :: ImplicitFunction1 >;
+template class LevenbergMarquardt< 5, &RationalSuperShape2D :: ImplicitFunction2 >;
+template class LevenbergMarquardt< 5, &RationalSuperShape2D :: ImplicitFunction3 >;
+template class LevenbergMarquardt< 7, &RationalSuperShape2D :: ImplicitFunction1 >;
+template class LevenbergMarquardt< 7, &RationalSuperShape2D :: ImplicitFunction2 >;
+template class LevenbergMarquardt< 7, &RationalSuperShape2D :: ImplicitFunction3 >;
+template class LevenbergMarquardt< 8, &RationalSuperShape2D :: ImplicitFunction1 >;
+template class LevenbergMarquardt< 8, &RationalSuperShape2D :: ImplicitFunction2 >;
+template class LevenbergMarquardt< 8, &RationalSuperShape2D :: ImplicitFunction3 >;
+
+//fit with the implicit function 1, 2 or 3 selected at run time
+template < int Dim >
+static bool OptimizeShape(RationalSuperShape2D &shape, const PointSpan &Data, double &err, int functionused,
+                          double abortbound, int *nbiterations, std::ostream *logfile,
+                          int *nbevaluations = NULL, int *nbsavedevaluations = NULL, double *checkpointerr = NULL)
+{
+    switch (functionused){
+    case 2 : return LevenbergMarquardt< Dim, &RationalSuperShape2D :: ImplicitFunction2 >(shape).Optimize(Data, err, abortbound, nbiterations, logfile, nbevaluations, nbsavedevaluations, checkpointerr);
+    case 3 : return LevenbergMarquardt< Dim, &RationalSuperShape2D :: ImplicitFunction3 >(shape).Optimize(Data, err, abortbound, nbiterations, logfile, nbevaluations, nbsavedevaluations, checkpointerr);
+    default : return LevenbergMarquardt< Dim, &RationalSuperShape2D :: ImplicitFunction1 >(shape).Optimize(Data, err, abortbound, nbiterations, logfile, nbevaluations, nbsavedevaluations, checkpointerr);
+    }
+}
+//chi square with the implicit function 1, 2 or 3 selected at run time, the hessian is returned as a full symmetric matrix
+template < int Dim >
+static double XiSquareShape(RationalSuperShape2D &shape, const PointSpan &Data, MatrixXd &alpha, VectorXd &beta,
+                            int functionused, bool update, double bound)
+{
+    Matrix< double, Dim, Dim > fixed_alpha;
+    Matrix< double, Dim, 1 > fixed_beta;
+    double ChiSquare;
+    switch (functionused){
+    case 2 : ChiSquare = LevenbergMarquardt< Dim, &RationalSuperShape2D :: ImplicitFunction2 >(shape).XiSquare(Data, fixed_alpha, fixed_beta, update, bound); break;
+    case 3 : ChiSquare = LevenbergMarquardt< Dim, &RationalSuperShape2D :: ImplicitFunction3 >(shape).XiSquare(Data, fixed_alpha, fixed_beta, update, bound); break;
+    default : ChiSquare = LevenbergMarquardt< Dim, &RationalSuperShape2D :: ImplicitFunction1 >(shape).XiSquare(Data, fixed_alpha, fixed_beta, update, bound);
+    }
+    if (update) {
+        alpha = fixed_alpha.template selfadjointView< Lower >();
+        beta = fixed_beta;
+    }
+    return ChiSquare;
+}
+void RationalSuperShape2D :: Optimize5D(
+        std::string outfilename,
+        const PointSpan &Data,
+        double &err ,
+        int functionused
+        )
+{
+    std::ofstream logfile;
+    logfile.open(outfilename.c_str());
+    //never abandoned
+    OptimizeShape< 5 >(*this, Data, err, functionused, std::numeric_limits< double >::infinity(), NULL, &logfile);
+    logfile.close();
+}
+double RationalSuperShape2D :: XiSquare5D(
+        const PointSpan &Data,
+        MatrixXd &alpha,
+        VectorXd &beta,
+        int functionused,
+        bool update) {
+    return XiSquareShape< 5 >(*this, Data, alpha, beta, functionused, update, std::numeric_limits< double >::infinity());
+}
 void RationalSuperShape2D :: Optimize7D(
         std::string outfilename,
-        std::vector< Vector2d, aligned_allocator< Vector2d> > Data,
+        const PointSpan &Data,
         double &err ,
         int functionused
         )
 {
-    double NewChiSquare, ChiSquare(1e15), OldChiSquare(1e15);
     std::ofstream logfile;
     logfile.open(outfilename.c_str());
-    bool STOP(false);
-    double oldparams[] ={0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};//, dj[16];
-    double LAMBDA_INCR(10), lambda(pow(LAMBDA_INCR, -6));
-    MatrixXd alpha, alpha2;
-    alpha = MatrixXd::Zero(7,7);
-    alpha2 = MatrixXd::Zero(7,7);
-    VectorXd beta, beta2, dj, oldbeta, trial, sigma;
-    beta = VectorXd::Zero(7);
-    beta2 = VectorXd::Zero(7);
-    dj = VectorXd::Zero(7);
-    oldbeta = VectorXd::Zero(7);
-    trial = VectorXd::Zero(7);
-    sigma = VectorXd::Zero(7);
-    logfile << *this;
-
-    int itnum = 0;
-    for(itnum=0; itnum<1000 && STOP==false; itnum++) {
-        //store oldparams
-        for(size_t i=0; i<Parameters.size(); i++) oldparams[i]=Parameters[i];
-        alpha.setZero();
-        beta.setZero();
-        alpha2.setZero();
-        beta2.setZero();
-        //std::cout <<"TRIAL:"<<*this<<std::endl;
-        bool outofbounds(false);
-        //std::cout <<"Norm on in Opt2 : "<<Normalization<<std::endl;
-        ChiSquare = XiSquare7D(Data,
-                               alpha,
-                               beta,
-                               functionused, //implicitf cuntion1
-                               true); //update vectors
-        //
-        // add Lambda to diagonla elements and solve the matrix
-        //
-        //Linearization of Hessian, cf Numerical Recepies
-
-        for(int k=0; k<7; k++)
-        {
-            alpha(k,k) *= 1. + lambda; //multiplicative factor to make diagonal dominant
-            alpha(k,k) += lambda; //additive factor to avoid rank deficient matrix
-        }
-        //std::cout << alpha << std::endl<<std::endl;
-        //std::cout << beta << std::endl<<std::endl;
-        //solve system
-        alpha.ldlt().solveInPlace(beta);
-        //coefficients a and b in [0.01, 100]
-        outofbounds = Parameters[0] + beta[0] < 0.01 || Parameters[0] + beta[0] > 1000 ||
-                Parameters[1] + beta[1] < 0.01 || Parameters[1] + beta[1] > 1000 ||
-                Parameters[2] + beta[2] < 0.1 || Parameters[2] + beta[2]> 1000 ||
-                Parameters[3] + beta[3] < 0.1 || Parameters[3] + beta[3]> 1000 ||
-                Parameters[4] + beta[4] < 0.1 || Parameters[4] + beta[4]> 1000;
-        if( !outofbounds )
-        {
-            Set_a( Parameters[0] + beta[0]);
-            Set_b( Parameters[1] + beta[1]);
-            // coefficients n1 in [1., 1000]
-            // setting n1<1. leads to strong numerical instabilities
-            Set_n1( Parameters[2] + beta[2] );
-            // coefficients n2,n3 in [0.001, 1000]
-            Set_n2( Parameters[3] + beta[3]);
-            Set_n3( Parameters[4] + beta[4]);
-            // coefficients x0 and y0
-            //truncate translation to avoid huge gaps
-            beta[5] = std::min(0.05, std::max(-0.05, beta[5]));
-            beta[6] = std::min(0.05, std::max(-0.05, beta[6]));
-            Parameters[9] += beta[5];
-            Parameters[10] += beta[6];
-        }
-        //
-        // Evaluate chisquare with new values
-        //
-        OldChiSquare = ChiSquare;
-        NewChiSquare = XiSquare7D(Data,
-                                  alpha2,
-                                  beta2,
-                                  functionused, //implicitf cuntion1
-                                  false);
-        if( NewChiSquare>0.999*OldChiSquare ) // new result sucks-->restore old params and try with lambda 10 times bigger
-        {
-            lambda *= LAMBDA_INCR;
-            for(size_t i=0; i<Parameters.size(); i++) Parameters[i]=oldparams[i];
-        }
-        else //successful iteration
-        {
-            // huge improvement, something may have been wrong
-            // this may arise during the first iterations
-            // n1 may literally explode, or tend to 0...
-            // in such case, the next iteration is successful but leads to a local minimum
-            // ==> it is better to verify the result with a smaller step
-            // if indeed it was a correct iteration, then it will pass the next time
-            if (NewChiSquare <= 0.01*OldChiSquare) //99% improvement, impossible
-            {
-                lambda *= LAMBDA_INCR; // reduce the step within the search direction
-                for(size_t i=0; i<Parameters.size(); i++) Parameters[i]=oldparams[i]; // restore old parameters
-            }
-            else
-            {
-                //correct and realistic improvement
-                logfile << *this;
-                lambda /=LAMBDA_INCR;
-            }
-        }
-        STOP = lambda > 1e15 || NewChiSquare < 1e-5;
-    } //end for(...
-    err = ChiSquare;
-    logfile << *this;
+    //never abandoned
+    OptimizeShape< 7 >(*this, Data, err, functionused, std::numeric_limits< double >::infinity(), NULL, &logfile);
     logfile.close();
 }
 double RationalSuperShape2D :: XiSquare7D(
-        const std::vector< Vector2d, aligned_allocator< Vector2d> > Data,
+        const PointSpan &Data,
         MatrixXd &alpha,
         VectorXd &beta,
         int functionused,
         bool update) {
-    VectorXd dj; dj = VectorXd::Zero(7);
-    Matrix3d Tr,Rot, dTrdx0, dTrdy0;
-    //functions pointer
-    double (RationalSuperShape2D ::*pt2ConstMember)(const Vector2d P, std::vector<double> &Dffinal) = NULL;
-    switch (functionused){
-    case 1 :{ pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction1; }break;
-    case 2 :{ pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction2; }break;
-    case 3 :{ pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction3; }break;
-    default : pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction1;
-    }
-    std::vector<double> Df;
-    double x, y, tht, dthtdx, dthtdy,dthtdx0, dthtdy0, drdth,
-            ChiSquare(1e15),
-            f(0),
-            x0(Get_xoffset()),y0(Get_yoffset()),tht0(Get_thtoffset()),
-            dxdx0,dxdy0, dydx0,dydy0;
-    //clean memory
-    if(update) {
-        alpha.setZero();
-        beta.setZero();
-    }
-    //evaluate ChiSquare, components for the beta and matrix alpha
-    ChiSquare=0;
-    //First define inverse translation T-1
-    Tr.setZero();
-    Rot.setZero();
-    Tr << 1 , 0 , -x0 ,
-            0 , 1 , -y0 ,
-            0 , 0 , 1;
-    //derivatives of translation matrix are constant and can be computed once for all
-    dTrdx0 << 0 , 0 , -1 , 0 , 0 , 0 , 0 , 0 , 1;
-    dTrdy0 << 0 , 0 , 0 , 0 , 0 , -1 , 0 , 0 , 1;
-    //Then define inverse rotation, i.e. transposed rotation
-    Rot << cos(tht0) , sin(tht0) , 0 ,
-            -sin(tht0) , cos(tht0) , 0 ,
-            0 , 0 , 1;
-    for(size_t i=0; i<Data.size(); i++){
-        double DfDr;
-        //global inverse transform is T * R
-        Vector2d dum(Data[i]);
-        Vector3d dum2(dum[0],dum[1],1);
-        //apply inverse transform
-        Vector3d dum3 ( Rot * (Tr * dum2));
-        Vector2d P(dum3[0],dum3[1]); //2D point in canonical ref
-        //get partial derivatives for canonical point
-        Vector3d dPdx0 ( Rot * (dTrdx0 * dum2) );
-        Vector3d dPdy0 ( Rot * (dTrdy0 * dum2) );
-        //simplify notations
-        dxdx0 = dPdx0[0];
-        dxdy0 = dPdy0[0];
-        dydx0 = dPdx0[1];
-        dydy0 = dPdy0[1];
-        x = P[0]; y = P[1];
-        // avoid division by 0 ==> numerical stability
-        if (P.norm()<EPSILON) continue; // avoids division by zero
-        tht = atan2(y,x); if( tht < 0 ) tht+=2.*M_PI;
-
-        //theta = Arctan(Y/X)
-        dthtdx = -sin(tht) ;//-y / (x*x+y*y);
-        dthtdy = cos(tht); //x / (x*x+y*y);
-        //partial derivatives of theta regarding x offset, y offset, and angular offset
-        dthtdx0 = dthtdx * dxdx0 + dthtdy * dydx0;
-        dthtdy0 = dthtdx * dxdy0 + dthtdy * dydy0;
-        //avoid non differentiable cases
-        drdth = DrDtheta(tht);
-        f = (*this.*pt2ConstMember)(P, Df); // call to the implicit function
-        //
-        //compute elements beta[i][0] and alpha[i][j]
-        //
-        //==> requires partial derivatives!!
-        DfDr = Df[2]; //Df/Dr stored at index 2 in array Df during the call to ImplicitFunction1-2-3
-        // F1 = R-PL ==> DfDr = 1. ;
-        // F2 = 1-PL/R ==> DfDr = PL/R\B2 ;
-        // F3 = log ( R\B2/PSL) ==> DfDr = 2/R
-        dj.setZero();
-        //df/da = df/dr * dr/da
-        dj[0] = DfDr * DrDa(tht) ;
-        //df/db = df/dr * dr/db
-        dj[1] = DfDr * DrDb(tht) ;
-        //df/dn1 = df/dr * dr/dn1
-        dj[2] = DfDr * DrDn1(tht);
-        //df/dn2 = df/dr * dr/dn2
-        dj[3] = DfDr * DrDn2(tht);
-        //df/dn3 = df/dr * dr/dn3
-        dj[4] = DfDr * DrDn3(tht);
-        //df/dx0 = df/dr * dr/dtht *dtht/dx0
-        dj[5]= DfDr * drdth*dthtdx0;
-        //df/dy0 = df/dr * dr/dtht *dtht/dy0
-        dj[6]= DfDr * drdth*dthtdy0;
-        //squared summation
-        ChiSquare += f*f;
-        if(update){
-            for(int k=0; k<7; k++)
-            {
-                beta[k] -= f*dj[k];
-            }
-            //compute approximation of Hessian matrix
-            for(int k=0; k<7; k++)
-                for(int j=0; j<7; j++)
-                    alpha(k,j) += dj[k]*dj[j];
-        }
-    }//for all vertices
-    return ChiSquare;
+    return XiSquareShape< 7 >(*this, Data, alpha, beta, functionused, update, std::numeric_limits< double >::infinity());
 }
-void RationalSuperShape2D :: Optimize8D(
-        std::vector< Vector2d, aligned_allocator< Vector2d> > Data,
+bool RationalSuperShape2D :: Optimize8D(
+        const PointSpan &Data,
         double &err ,
-        int functionused
+        int functionused,
+        double abortbound,
+        int *nbiterations,
+        int *nbevaluations,
+        int *nbsavedevaluations,
+        double *checkpointerr
         )
 {
-    double NewChiSquare, ChiSquare(1e15), OldChiSquare(1e15);
-    // ofstream logfile;
-    // logfile.open(outfilename.c_str());
-    bool STOP(false);
-    double oldparams[] ={0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};//, dj[16];
-    double LAMBDA_INCR(10);
-    double lambda(pow(LAMBDA_INCR, -6));
-    MatrixXd alpha, alpha2;
-    alpha = MatrixXd::Zero(8,8);
-    alpha2 = MatrixXd::Zero(8,8);
-    VectorXd beta, beta2, dj, oldbeta, trial, sigma;
-    beta = VectorXd::Zero(8);
-    beta2 = VectorXd::Zero(8);
-    dj = VectorXd::Zero(8);
-    oldbeta = VectorXd::Zero(8);
-    trial = VectorXd::Zero(8);
-    sigma = VectorXd::Zero(8);
-
-    // logfile << *this;
-    int itnum = 0;
-    for(itnum=0; itnum<1000 && STOP==false; itnum++) {
-        //store oldparams
-        for(size_t i=0; i<Parameters.size(); i++) oldparams[i]=Parameters[i];
-        alpha.setZero();
-        beta.setZero();
-        alpha2.setZero();
-        beta2.setZero();
-        //std::cout <<"TRIAL:"<<*this<<std::endl;
-        bool outofbounds(false);
-        //std::cout <<"Norm on in Opt2 : "<<Normalization<<std::endl;
-        ChiSquare = XiSquare8D(Data,
-                               alpha,
-                               beta,
-                               functionused, //implicitf cuntion1
-                               true); //update vectors
-        //
-        // add Lambda to diagonla elements and solve the matrix
-        //
-        //Linearization of Hessian, cf Numerical Recepies
-        for(int k=0; k<8; k++)
-        {
-            alpha(k,k) *= 1. + lambda; //multiplicative factor to make diagonal dominant
-            alpha(k,k) += lambda; //additive factor to avoid rank deficient matrix
-        }
-        //solve system
-        alpha.ldlt().solveInPlace(beta);
-        //coefficients a and b in [0.01, 100]
-        outofbounds = Parameters[0] + beta[0] < 0.01 || Parameters[0] + beta[0] > 1000 ||
-                Parameters[1] + beta[1] < 0.01 || Parameters[1] + beta[1] > 1000 ||
-                Parameters[2] + beta[2] < 0.1 || Parameters[2] + beta[2]> 1000 ||
-                Parameters[3] + beta[3] < 0.1 || Parameters[3] + beta[3]> 1000 ||
-                Parameters[4] + beta[4] < 0.1 || Parameters[4] + beta[4]> 1000;
-        if( !outofbounds ) {
-            Set_a( Parameters[0] + beta[0]);
-            Set_b( Parameters[1] + beta[1]);
-            // coefficients n1 in [1., 1000]
-            // setting n1<1. leads to strong numerical instabilities
-            Set_n1( Parameters[2] + beta[2] );
-            // coefficients n2,n3 in [0.001, 1000]
-            Set_n2( Parameters[3] + beta[3]);
-            Set_n3( Parameters[4] + beta[4]);
-            // coefficients x0 and y0
-            //truncate translation to avoid huge gaps
-            beta[5] = std::min(0.05, std::max(-0.05, beta[5]));
-            beta[6] = std::min(0.05, std::max(-0.05, beta[6]));
-            Parameters[9] += beta[5];
-            Parameters[10] += beta[6];
-            //same for rotational offset tht0
-            beta[7] = std::min(M_PI/50., std::max(-M_PI/50., beta[7]));
-            Parameters[7] += beta[7];
-        }
-        //
-        // Evaluate chisquare with new values
-        //
-        OldChiSquare = ChiSquare;
-        NewChiSquare=XiSquare8D(Data,
-                                alpha2,
-                                beta2,
-                                functionused, //implicitf cuntion1
-                                false);
-        //
-        // check if better result
-        //
-        if( NewChiSquare>0.999*OldChiSquare ) // new result sucks-->restore old params and try with lambda 10 times bigger
-        {
-            lambda *=LAMBDA_INCR;
-            for(size_t i=0; i<Parameters.size(); i++) Parameters[i]=oldparams[i];
-        }
-        else //successful iteration
-        {
-            // huge improvement, something may have been wrong
-            // this may arise during the first iterations
-            // n1 may literally explode, or tend to 0...
-            // in such case, the next iteration is successful but leads to a local minimum
-            // ==> it is better to verify the result with a smaller step
-            // if indeed it was a correct iteration, then it will pass the next time
-            if (NewChiSquare <= 0.01*OldChiSquare) //99% improvement, impossible
-            {
-                lambda *=LAMBDA_INCR; // reduce the step within the search direction
-                for(size_t i=0; i<Parameters.size(); i++) Parameters[i]=oldparams[i]; // restore old parameters
-            }
-            else
-            {
-                //correct and realistic improvement
-                // logfile << *this;
-                lambda /=LAMBDA_INCR;
-            }
-        }
-        STOP = lambda > 1e15 || NewChiSquare < 1e-5; // very small displacement ==> local convergence
-    } //end for(...
-    err = ChiSquare;
-    // logfile << *this;
-    // logfile.close();
+    return OptimizeShape< 8 >(*this, Data, err, functionused, abortbound, nbiterations, NULL, nbevaluations, nbsavedevaluations, checkpointerr);
 }
 double RationalSuperShape2D :: XiSquare8D(
-        const std::vector< Vector2d, aligned_allocator< Vector2d> > Data,
+        const PointSpan &Data,
         MatrixXd &alpha,
         VectorXd &beta,
         int functionused,
-        bool update) {
-    VectorXd dj; dj = VectorXd::Zero(8);
-    Matrix3d Tr,Rot, dTrdx0, dTrdy0, dRotdtht0;
-    //functions pointer
-    double (RationalSuperShape2D ::*pt2ConstMember)(const Vector2d P, std::vector<double> &Dffinal) = NULL;
-    switch (functionused){
-    case 1 :{ pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction1; }break;
-    case 2 :{ pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction2; }break;
-    case 3 :{ pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction3; }break;
-    default : pt2ConstMember = &RationalSuperShape2D :: ImplicitFunction1;
-    }
-    std::vector<double> Df;
-    double  x, y, tht, dthtdx, dthtdy,dthtdx0, dthtdy0, drdth,
-            ChiSquare(1e15),
-            f(0),
-            x0(Get_xoffset()),y0(Get_yoffset()),tht0(Get_thtoffset()),
-            dxdx0,dxdy0,dxdtht0, dydx0,dydy0,dydtht0, dthtdtht0;
-    //clean memory
-    if(update)
-    {
-        alpha.setZero();
-        beta.setZero();
-    }
-    //evaluate ChiSquare, components for the beta and matrix alpha
-    ChiSquare=0;
-    //First define inverse translation T-1
-    Tr.setZero();
-    Rot.setZero();
-    dRotdtht0.setZero();
-    Tr << 1 , 0 , -x0 ,
-            0 , 1 , -y0 ,
-            0 , 0 , 1;
-    //derivatives of translation matrix are constant and can be computed once for all
-    dTrdx0 << 0 , 0 , -1 , 0 , 0 , 0 , 0 , 0 , 1;
-    dTrdy0 << 0 , 0 , 0 , 0 , 0 , -1 , 0 , 0 , 1;
-    //Then define inverse rotation, i.e. transposed rotation
-    Rot << cos(tht0) , sin(tht0) , 0 ,
-            -sin(tht0) , cos(tht0) , 0 ,
-            0 , 0 , 1;
-    //get partial derivatives
-    dRotdtht0 << -sin(tht0) , cos(tht0) , 0 ,
-            -cos(tht0) , -sin(tht0) , 0 ,
-            0 , 0 , 1;
-    for(size_t i=0; i<Data.size(); i++){
-        double DfDr;
-        //global inverse transform is T * R
-        Vector2d dum(Data[i]);
-        Vector3d dum2(dum[0],dum[1],1);
-        //apply inverse transform
-        Vector3d dum3 ( Rot * (Tr * dum2));
-        //get partial derivatives for canonical point
-        Vector3d dPdx0 ( Rot * (dTrdx0 * dum2) );
-        Vector3d dPdy0 ( Rot * (dTrdy0 * dum2) );
-        Vector3d dPdtht0 (dRotdtht0 * (Tr *dum2) );
-        Vector2d P(dum3[0],dum3[1]);
-        //simplify notations
-        dxdx0 = dPdx0[0];
-        dxdy0 = dPdy0[0];
-        dxdtht0 = dPdtht0[0];
-        dydx0 = dPdx0[1];
-        dydy0 = dPdy0[1];
-        dydtht0 = dPdtht0[1];
-        x = P[0]; y = P[1];
-        // avoid division by 0 ==> numerical stability
-        if (P.norm()<EPSILON) continue; // avoids division by zero
-        tht = atan2(y,x); if( tht<0) tht+=2.*M_PI;
-
-        //theta = Arctan(Y/X)
-        dthtdx = -sin(tht) ;//-y / (x*x+y*y);
-        dthtdy = cos(tht); //x / (x*x+y*y);
-        //partial derivatives of theta regarding x offset, y offset, and angular offset
-        dthtdx0 = dthtdx * dxdx0 + dthtdy * dydx0;
-        dthtdy0 = dthtdx * dxdy0 + dthtdy * dydy0;
-        dthtdtht0 = dthtdx * dxdtht0+ dthtdy * dydtht0;
-        //avoid non differentiable cases
-        drdth = DrDtheta(tht);
-        f = (*this.*pt2ConstMember)(P, Df); // call to the implicit function
-        //
-        //compute elements beta[i][0] and alpha[i][j]
-        //
-        //==> requires partial derivatives!!
-        DfDr = Df[2]; //Df/Dr stored at index 2 in array Df during the call to ImplicitFunction1-2-3
-        // F1 = R-PL ==> DfDr = 1. ;
-        // F2 = 1-PL/R ==> DfDr = PL/R\B2 ;
-        // F3 = log ( R\B2/PSL) ==> DfDr = 2/R
-        //GetPartialDerivatives(tht, DrDa, DrDb, DrDn1, DrDn2, DrDn3);
-        //for(int toto=0; toto<8; toto++) dj[toto]=0;
-        dj.setZero();
-        //df/da = df/dr * dr/da
-        dj[0] = DfDr * DrDa(tht) ;
-        //df/db = df/dr * dr/db
-        dj[1] = DfDr * DrDb(tht) ;
-        //df/dn1 = df/dr * dr/dn1
-        dj[2] = DfDr * DrDn1(tht);
-        //df/dn2 = df/dr * dr/dn2
-        dj[3] = DfDr * DrDn2(tht);
-        //df/dn3 = df/dr * dr/dn3
-        dj[4] = DfDr * DrDn3(tht);
-        //df/dx0 = df/dr * dr/dtht *dtht/dx0
-        dj[5]= DfDr * drdth*dthtdx0;
-        //df/dy0 = df/dr * dr/dtht *dtht/dy0
-        dj[6]= DfDr * drdth*dthtdy0;
-        //df/dth0 = dfdr * dr/dtht * dtht/dtht0
-        dj[7]= DfDr * drdth*dthtdtht0;
-        ChiSquare += f*f;
-        if( update ){
-
-            for(int k=0; k<8; k++)
-            {
-                beta[k] -= f*dj[k];
-            }
-            //compute approximation of Hessian matrix
-
-            for(int k=0; k<8; k++)
-                for(int j=0; j<8; j++)
-                    alpha(k,j) += dj[k]*dj[j];
-        }
-    }//for all vertices
-    return ChiSquare;
+        bool update,
+        double bound) {
+    //the bound only applies without update
+    return XiSquareShape< 8 >(*this, Data, alpha, beta, functionused, update, update ? std::numeric_limits< double >::infinity() : bound);
 }
 Vector2d RationalSuperShape2D :: ClosestPoint( Vector2d P, int itmax){
     // P is supposed to be expressed in canonical referential
@@ -1242,7 +907,7 @@ Vector2d RationalSuperShape2D :: ClosestPoint( Vector2d P, int itmax){
 // logfile << std::endl;
 // logfile.close();
 // }
-bool RationalSuperShape2D :: ErrorMetric (std::vector< Vector2d, aligned_allocator< Vector2d> > Data, Vector4d &Mean, Vector4d &Var)
+bool RationalSuperShape2D :: ErrorMetric (const PointSpan &Data, Vector4d &Mean, Vector4d &Var)
 {
     //Bring back data into canonical referential
     double x0(Get_xoffset()), y0(Get_yoffset()), tht0(Get_thtoffset());
@@ -1260,6 +925,7 @@ bool RationalSuperShape2D :: ErrorMetric (std::vector< Vector2d, aligned_allocat
             0 , 0 , 1;
     //now process all the data and store the point in a local array
     std::vector< Vector2d, aligned_allocator< Vector2d> > CanonicalData;
+    CanonicalData.reserve(Data.size());
     // use 1 array of std::vector4d to reduce computational load
     std::vector< Vector4d, aligned_allocator< Vector4d> > dumarray;
     for( size_t i=0; i<Data.size(); i++ ){
@@ -1283,7 +949,7 @@ glEnd();
     //Init Mean and Var
     Mean = Vector4d(0,0,0,0);
     Var = Mean;
-    std::vector<double> Dffinal;//dummy local variable to store partial derivatives, unused in this function
+    Vector3d Dffinal;//dummy local variable to store partial derivatives, unused in this function
     //compute Mean
     /*
 glColor3f(1,0,0);
@@ -47,6 +47,7 @@ the use of this software, even if advised of the possibility of such damage.
 
 #include <cassert>
 #include <cstring>
+#include <limits>
 
 #include <Eigen/Core>
 #include <Eigen/StdVector>
@@ -55,6 +56,45 @@ the use of this software, even if advised of the possibility of such damage.
 //USING_PART_OF_NAMESPACE_EIGEN
 using namespace Eigen;
 
+// Number of iterations of Optimize8D after which a fit can be abandoned -- fits are only compared after the same number of iterations
+#define OPTIMIZE_ABORT_MIN_ITERATIONS 10
+
+// Number of intersections (i.e. q) of the implicit functions stored on the stack -- larger q are stored on the heap
+#define IMPLICIT_MAX_INTERSECTIONS 16
+
+// Read-only view on a contiguous array of 2D points, stored either as double or as float (e.g. cv::Point2f)
+// Nothing is copied: the points are converted to double when they are read
+class PointSpan{
+
+public:
+
+    PointSpan() : m_double(NULL), m_float(NULL), m_size(0) {}
+    PointSpan(const std::vector< Vector2d, aligned_allocator< Vector2d> > &points)
+        : m_double(points.empty() ? NULL : points[0].data()), m_float(NULL), m_size(points.size()) {}
+    PointSpan(const Map< const Matrix< double, 2, Dynamic > > &points)
+        : m_double(points.data()), m_float(NULL), m_size(points.cols()) {}
+    PointSpan(const Map< const Matrix< float, 2, Dynamic > > &points)
+        : m_double(NULL), m_float(points.data()), m_size(points.cols()) {}
+    // xy holds the coordinates interleaved as x0 y0 x1 y1 ...
+    PointSpan(const double *xy, size_t size) : m_double(xy), m_float(NULL), m_size(size) {}
+    PointSpan(const float *xy, size_t size) : m_double(NULL), m_float(xy), m_size(size) {}
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    inline Vector2d operator[](size_t i) const {
+        assert(i < m_size);
+        if (m_float) return Vector2d((double) m_float[2 * i], (double) m_float[2 * i + 1]);
+        return Vector2d(m_double[2 * i], m_double[2 * i + 1]);
+    }
+
+private:
+
+    const double *m_double;
+    const float *m_float;
+    size_t m_size;
+};
+
 class RationalSuperShape2D{
 
 public:
@@ -96,6 +136,14 @@ public:
     double ImplicitFunction1( const Vector2d P, std::vector <double> &Dffinal );
     double ImplicitFunction2( const Vector2d P, std::vector <double> &Dffinal );
     double ImplicitFunction3( const Vector2d P, std::vector <double> &Dffinal );
+    //same functions without allocation, Df/Dx, Df/Dy, Df/Dr stored in Dffinal
+    double ImplicitFunction1( const Vector2d &P, Vector3d &Dffinal );
+    double ImplicitFunction2( const Vector2d &P, Vector3d &Dffinal );
+    double ImplicitFunction3( const Vector2d &P, Vector3d &Dffinal );
+    //same functions given the radius R0 and dr/dtheta drdth0 of the first intersection, theta in [0, 2Pi), already computed by the caller
+    double ImplicitFunction1( const Vector2d &P, Vector3d &Dffinal, double R0, double drdth0 );
+    double ImplicitFunction2( const Vector2d &P, Vector3d &Dffinal, double R0, double drdth0 );
+    double ImplicitFunction3( const Vector2d &P, Vector3d &Dffinal, double R0, double drdth0 );
 
     double DrDa(const double);
     double DrDb(const double);
@@ -104,48 +152,58 @@ public:
     double DrDn3(const double);
 
     void GetPartialDerivatives(double tht, double &DrDa, double &DrDb, double &DrDn1, double &DrDn2, double &DrDn3);
+    //radius and its analytic partial derivatives regarding a, b, n1, n2, n3 and theta
+    //a single cos, sin, log and exp per term instead of the finite differences of DrDa ... DrDn3 and DrDtheta
+    double RadiusAndDerivatives(const double tht, double &DrDa, double &DrDb, double &DrDn1, double &DrDn2, double &DrDn3, double &DrDtht);
 
     void Optimize5D(
             std::string outfilename, //file to store the evolution of the best fitted curve though iterations
-            const std::vector< Vector2d, aligned_allocator< Vector2d> >, // array of 2D points
+            const PointSpan &, // array of 2D points
             double & ,         //error of fit
             int functionused = 1 //index of the implicit function used:1,2,or 3
             );
 
     void Optimize7D(
             std::string outfilename, //file to store the evolution of the best fitted curve though iterations
-            const std::vector< Vector2d, aligned_allocator< Vector2d> >, // array of 2D points
+            const PointSpan &, // array of 2D points
             double & ,         //error of fit
             int functionused = 1 //index of the implicit function used:1,2,or 3
             );
 
-    void Optimize8D(
-            const std::vector< Vector2d, aligned_allocator< Vector2d> >, // array of 2D points
+    //returns false when the fit is abandoned because its error is above abortbound after OPTIMIZE_ABORT_MIN_ITERATIONS iterations
+    bool Optimize8D(
+            const PointSpan &, // array of 2D points
             double & ,         //error of fit
-            int functionused = 1 //index of the implicit function used:1,2,or 3
+            int functionused = 1, //index of the implicit function used:1,2,or 3
+            double abortbound = std::numeric_limits< double >::infinity(), //error of fit above which the fit is abandoned
+            int *nbiterations = NULL, //number of iterations performed
+            int *nbevaluations = NULL, //number of points evaluated
+            int *nbsavedevaluations = NULL, //number of point evaluations saved by reusing the hessian and gradient of the current parameters, and by stopping the evaluation of rejected steps
+            double *checkpointerr = NULL //error of fit after OPTIMIZE_ABORT_MIN_ITERATIONS iterations, or the final one if the fit stops before
             );
 
     //sub function used in the baove function to compute hessian approx and gradient
     double XiSquare5D(
-            const std::vector < Vector2d, aligned_allocator< Vector2d> > Data,    //array of 2D points
+            const PointSpan &Data,    //array of 2D points
             MatrixXd &alpha,      //hessian approximation
             VectorXd &beta,       //gradient approximation
             int function_used = 1,    //index of the implicit function used
             bool udpate = false); //boolean if hessian and gradient have to be updated or not
 
     double XiSquare7D(
-            const std::vector < Vector2d, aligned_allocator< Vector2d> > Data,    //array of 2D points
+            const PointSpan &Data,    //array of 2D points
             MatrixXd &alpha,      //hessian approximation
             VectorXd &beta,       //gradient approximation
             int function_used = 1,    //index of the implicit function used
             bool udpate = false); //boolean if hessian and gradient have to be updated or not
 
     double XiSquare8D(
-            const std::vector < Vector2d, aligned_allocator< Vector2d> > Data,    //array of 2D points
+            const PointSpan &Data,    //array of 2D points
             MatrixXd &alpha,      //hessian approximation
             VectorXd &beta,       //gradient approximation
             int function_used = 1,    //index of the implicit function used
-            bool udpate = false); //boolean if hessian and gradient have to be updated or not
+            bool udpate = false, //boolean if hessian and gradient have to be updated or not
+            double bound = std::numeric_limits< double >::infinity()); //without update, the evaluation stops as soon as the partial sum exceeds bound
 
     double radius ( const double angle );
 
@@ -241,7 +299,7 @@ public:
     Vector2d ClosestPoint( Vector2d P, int itmax = 10);
 
     //computation of the four cost functions for a given data set, returns Mean and Var for each cost function
-    bool ErrorMetric (std::vector < Vector2d, aligned_allocator< Vector2d> > Data, Vector4d &Mean, Vector4d &Var);
+    bool ErrorMetric (const PointSpan &Data, Vector4d &Mean, Vector4d &Var);
 };
 
 inline std::ostream& operator<<(std::ostream& os, const RationalSuperShape2D& RS2D)
@@ -251,7 +309,68 @@ inline std::ostream& operator<<(std::ostream& os, const RationalSuperShape2D& RS
     return os;
 };
 
+//implicit function used for the fit, e.g. &RationalSuperShape2D::ImplicitFunction1
+typedef double (RationalSuperShape2D ::*ImplicitFunctionPtr)(const Vector2d &P, Vector3d &Dffinal, double R0, double drdth0);
+
+// Levenberg-Marquardt fit of a rational supershape, specialised at compile time on the number of parameters and the implicit function
+// Dim = 5 : a, b, n1, n2, n3
+// Dim = 7 : a, b, n1, n2, n3, x offset, y offset
+// Dim = 8 : a, b, n1, n2, n3, x offset, y offset, theta offset
+// The members are instantiated in SuperFormula.cpp, next to the implicit functions they inline
+template < int Dim, ImplicitFunctionPtr ImplicitFn >
+class LevenbergMarquardt{
+
+    static_assert(Dim == 5 || Dim == 7 || Dim == 8, "LevenbergMarquardt optimises 5, 7 or 8 parameters");
+
+public:
+
+    typedef Matrix< double, Dim, Dim > HessianType;
+    typedef Matrix< double, Dim, 1 > GradientType;
+
+    explicit LevenbergMarquardt(RationalSuperShape2D &shape) : m_shape(shape), m_nb_evaluations(0) {}
+
+    //returns false when the fit is abandoned because its error is above abortbound after OPTIMIZE_ABORT_MIN_ITERATIONS iterations
+    bool Optimize(
+            const PointSpan &Data, // array of 2D points
+            double &err,         //error of fit
+            double abortbound = std::numeric_limits< double >::infinity(), //error of fit above which the fit is abandoned
+            int *nbiterations = NULL, //number of iterations performed
+            std::ostream *logfile = NULL, //stream to store the evolution of the best fitted curve though iterations
+            int *nbevaluations = NULL, //number of points evaluated
+            int *nbsavedevaluations = NULL, //number of point evaluations saved by reusing the hessian and gradient of the current parameters, and by stopping the evaluation of rejected steps
+            double *checkpointerr = NULL //error of fit after OPTIMIZE_ABORT_MIN_ITERATIONS iterations, or the final one if the fit stops before
+            );
+
+    //sub function used in the above function to compute hessian approx and gradient
+    double XiSquare(
+            const PointSpan &Data,    //array of 2D points
+            HessianType &alpha,   //hessian approximation, only the lower triangle is filled
+            GradientType &beta,   //gradient approximation
+            bool update = false, //boolean if hessian and gradient have to be updated or not
+            double bound = std::numeric_limits< double >::infinity()); //the evaluation stops as soon as the partial sum exceeds bound, alpha and beta are then incomplete
+
+    //number of points evaluated by XiSquare since the construction
+    int nb_evaluations() const { return m_nb_evaluations; }
+
+private:
+
+    RationalSuperShape2D &m_shape;
+    int m_nb_evaluations;
+};
+
 //Rfunction for self intersecting curves
-void RpUnion(double f1, double f2, std::vector<double> Df1, std::vector<double> Df2, double &f, std::vector<double> &Df);
-void RpIntersection(double f1, double f2, std::vector<double> Df1, std::vector<double> Df2, double &f, std::vector<double> &Df);
+void RpUnion(double f1, double f2, const std::vector<double> &Df1, const std::vector<double> &Df2, double &f, std::vector<double> &Df);
+void RpIntersection(double f1, double f2, const std::vector<double> &Df1, const std::vector<double> &Df2, double &f, std::vector<double> &Df);
+
+//Rfunction union with the partial derivatives Df/Dx, Df/Dy, Df/Dr -- Df may be Df1 or Df2
+inline void RpUnion(double f1, double f2, const Vector3d &Df1, const Vector3d &Df2, double &f, Vector3d &Df)
+{
+    const double norm (sqrt(f1*f1+f2*f2));
+    f = f1+f2+norm;
+    if(f1 != 0 || f2 != 0) // function differentiable
+        for(int i=0; i<3; i++)
+            Df[i] = Df1[i] + Df2[i] + (f1*Df1[i]+f2*Df2[i])/norm;
+    else //function not differentiable, set everything to zero
+        Df.setZero();
+}
 
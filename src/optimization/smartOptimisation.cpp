@@ -52,10 +52,15 @@ namespace optimisation {
 // Function to make the optimisation
 void gielis_optimisation(const std::vector< cv::Point2f >& contour, ConfigStruct2d& config_shape, Eigen::Vector4d& mean_err, Eigen::Vector4d& std_err) {
 
-    // Convert the data into Eigen type for further optimisation
-    std::vector < Eigen::Vector2d, Eigen::aligned_allocator< Eigen::Vector2d> > Data;
-    for (unsigned int contour_point_idx = 0; contour_point_idx < contour.size(); contour_point_idx++)
-        Data.push_back(Eigen::Vector2d((double) contour[contour_point_idx].x, (double) contour[contour_point_idx].y));
+    FitControl control;
+    gielis_optimisation(contour, config_shape, mean_err, std_err, control);
+}
+
+// Function to make the optimisation which gives up when the fit is worse than control.abort_chi_square after OPTIMIZE_ABORT_MIN_ITERATIONS iterations
+void gielis_optimisation(const std::vector< cv::Point2f >& contour, ConfigStruct2d& config_shape, Eigen::Vector4d& mean_err, Eigen::Vector4d& std_err, FitControl& control) {
+
+    // View the contour in place -- cv::Point2f stores x and y contiguously as floats
+    const PointSpan Data(contour.empty() ? NULL : &contour[0].x, contour.size());
 
     // Declaration of the Rational Shape
     RationalSuperShape2D RS;
@@ -64,11 +69,11 @@ void gielis_optimisation(const std::vector< cv::Point2f >& contour, ConfigStruct
     RS.Init(config_shape.a, config_shape.b, config_shape.n1, config_shape.n2, config_shape.n3, config_shape.p, config_shape.q, config_shape.theta_offset, config_shape.phi_offset, config_shape.x_offset, config_shape.y_offset, config_shape.z_offset);
 
     // Run the optimisation
-    double ErrorOfFit;
-    RS.Optimize8D(Data, ErrorOfFit, 1);
+    control.aborted = !RS.Optimize8D(Data, control.chi_square, 1, control.abort_chi_square, &control.nb_iterations, &control.nb_evaluations, &control.nb_saved_evaluations, &control.checkpoint_chi_square);
 
     // test the Error Metric function
-    RS.ErrorMetric (Data, mean_err, std_err);
+    if (!control.aborted)
+        RS.ErrorMetric (Data, mean_err, std_err);
 
     // Recover the different parameters
     config_shape = ConfigStruct2d(RS.Get_a(), RS.Get_b(), RS.Get_n1(), RS.Get_n2(), RS.Get_n3(), RS.Get_p(), RS.Get_q(), RS.Get_thtoffset(), RS.Get_phioffset(), RS.Get_xoffset(), RS.Get_yoffset(), RS.Get_zoffset());
@@ -66,6 +66,9 @@ public:
     // constructor with initialisation
     ConfigStruct_(const _Tp& _a, const _Tp& _b, const _Tp& _n1, const _Tp& _n2, const _Tp& _n3, const _Tp& _p, const _Tp& _q, const _Tp& _theta_offset, const _Tp& _phi_offset, const _Tp& _x_offset, const _Tp& _y_offset, const _Tp& _z_offset) { a = _a; b = _b; n1 = _n1; n2 = _n2; n3 = _n3; p = _p; q = _q; theta_offset = _theta_offset; phi_offset = _phi_offset; x_offset = _x_offset; y_offset = _y_offset; z_offset = _z_offset; }
 
+    // copy constructor
+    ConfigStruct_(const ConfigStruct_<_Tp>& cs) { *this = cs; }
+
     // Operator =
     ConfigStruct_<_Tp>& operator=(const ConfigStruct_<_Tp>& cs) { a = cs.a; b = cs.b; n1 = cs.n1; n2 = cs.n2; n3 = cs.n3; p = cs.p; q = cs.q; theta_offset = cs.theta_offset; phi_offset = cs.phi_offset; x_offset = cs.x_offset; y_offset = cs.y_offset; z_offset = cs.z_offset; return *this; }
 
@@ -107,9 +110,32 @@ typedef ConfigStruct2i ConfigStruct;
 typedef ConfigStruct_<float> ConfigStruct2f;
 typedef ConfigStruct_<double> ConfigStruct2d;
 
+// Early termination of the optimisation and report of the work done
+struct FitControl {
+    FitControl() : abort_chi_square(std::numeric_limits<double>::infinity()), chi_square(0.0), checkpoint_chi_square(0.0), nb_iterations(0), nb_evaluations(0), nb_saved_evaluations(0), aborted(false) {}
+
+    // Chi square above which the optimisation is abandoned after OPTIMIZE_ABORT_MIN_ITERATIONS iterations
+    double abort_chi_square;
+    // Chi square of the fit
+    double chi_square;
+    // Chi square after OPTIMIZE_ABORT_MIN_ITERATIONS iterations -- the final one when the fit stops before
+    double checkpoint_chi_square;
+    // Number of Levenberg-Marquardt iterations performed
+    int nb_iterations;
+    // Number of contour points evaluated, and evaluations saved by reusing the hessian and gradient of the accepted parameters
+    // and by stopping the evaluation of rejected steps
+    int nb_evaluations;
+    int nb_saved_evaluations;
+    // True when the optimisation has been abandoned
+    bool aborted;
+};
+
 // Function to make the optimisation
 void gielis_optimisation(const std::vector< cv::Point2f >& contour, ConfigStruct2d& config_shape, Eigen::Vector4d& mean_err, Eigen::Vector4d& std_err);
 
+// Function to make the optimisation which gives up when the fit is worse than control.abort_chi_square after OPTIMIZE_ABORT_MIN_ITERATIONS iterations -- the error metric is not computed for an abandoned fit
+void gielis_optimisation(const std::vector< cv::Point2f >& contour, ConfigStruct2d& config_shape, Eigen::Vector4d& mean_err, Eigen::Vector4d& std_err, FitControl& control);
+
 // Reconstruction using the Gielis formula
 void gielis_reconstruction(const ConfigStruct2d& config_shape, std::vector< cv::Point2f >& gielis_contour, const int number_points);
 }
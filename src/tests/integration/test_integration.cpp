@@ -42,27 +42,57 @@ the use of this software, even if advised of the possibility of such damage.
 */
 
 // our own code
-#include <img_processing/segmentation.h>
-#include <img_processing/colorConversion.h>
-#include <img_processing/imageProcessing.h>
+#include <detection/trafficSignDetector.h>
+#include <detection/pipelinedDetector.h>
 #include <img_processing/contour.h>
-#include <optimization/smartOptimisation.h>
-#include <common/math_utils.h>
 
 
 #include <iostream>
+#include <limits>
+#include <cmath>
+#include <algorithm>
 
 // OpenCV library
 #include <opencv2/opencv.hpp>
 
-// Eigen library
-#include <Eigen/Core>
-
 #include <gtest/gtest.h>
 
+// Previous vote accumulation of the radial symmetry transform -- four bounds checks per vote
+static void reference_edges_voting(const initopt::EdgeList& edges, const cv::Size& image_size, const float& radius, const int& W, cv::Mat& Or, cv::Mat& BrX, cv::Mat& BrY) {
+
+    Or = cv::Mat::zeros(image_size, CV_32F);
+    BrX = cv::Mat::zeros(image_size, CV_32F);
+    BrY = cv::Mat::zeros(image_size, CV_32F);
+
+    for (size_t e = 0; e < edges.size(); e++) {
+        const float offset_x = (float) cvRound(radius * edges.gradient_x[e]);
+        const float offset_y = (float) cvRound(radius * edges.gradient_y[e]);
+        const int center_x[2] = { (int) std::min(std::max((float) edges.x[e] + offset_x, 1.0f), (float) (image_size.width - 1)),
+                                  (int) std::min(std::max((float) edges.x[e] - offset_x, 1.0f), (float) (image_size.width - 1)) };
+        const int center_y[2] = { (int) std::min(std::max((float) edges.y[e] + offset_y, 1.0f), (float) (image_size.height - 1)),
+                                  (int) std::min(std::max((float) edges.y[e] - offset_y, 1.0f), (float) (image_size.height - 1)) };
+
+        const int band_start[3] = { - W, - 2 * W, W + 1 };
+        const int band_end[3] = { W, - W - 1, 2 * W };
+        const float band_vote[3] = { 1.00, - 1.00, - 1.00 };
+        for (int band = 0; band < 3; band++) {
+            for (int m = band_start[band]; m <= band_end[band]; m++) {
+                for (int c = 0; c < 2; c++) {
+                    const int LX = center_x[c] + (int) std::ceil((float) m * edges.gradient_bar_x[e]);
+                    const int LY = center_y[c] + (int) std::ceil((float) m * edges.gradient_bar_y[e]);
+                    if ((LX >= 0) && (LX < image_size.width) && (LY >= 0) && (LY < image_size.height)) {
+                        Or.at<float>(LY, LX) += band_vote[band];
+                        BrX.at<float>(LY, LX) += band_vote[band] * edges.gradient_vp_x[e];
+                        BrY.at<float>(LY, LX) += band_vote[band] * edges.gradient_vp_y[e];
+                    }
+                }
+            }
+        }
+    }
+}
+
 //TODO: This probably should be just regression tests...
-//TODO: clean up code, a lot of data is not used, also find proper GT no hardcoded values
-//this is a copy of the main app to do automatic testing using the test data of the repository
+//TODO: find proper GT no hardcoded values
 TEST(integration, realDataOctogonal17)
 {
 
@@ -78,185 +108,221 @@ TEST(integration, realDataOctogonal17)
     // Check that the image read is a 3 channels image
     GTEST_ASSERT_EQ(input_image.channels(), 3);
 
-    /*
-     * Conversion of the image in some specific color space
-     */
-
-    // Conversion of the rgb image in ihls color space
-    cv::Mat ihls_image;
-    colorconversion::convert_rgb_to_ihls(input_image, ihls_image);
-    // Conversion from RGB to logarithmic chromatic red and blue
-    std::vector< cv::Mat > log_image;
-    colorconversion::rgb_to_log_rb(input_image, log_image);
-
-    /*
-     * Segmentation of the image using the previous transformation
-     */
-
-    // Segmentation of the IHLS and more precisely of the normalised hue channel
-    // ONE PARAMETER TO CONSIDER - COLOR OF THE TRAFFIC SIGN TO DETECT - RED VS BLUE
-    int nhs_mode = 0; // nhs_mode == 0 -> red segmentation / nhs_mode == 1 -> blue segmentation
-    cv::Mat nhs_image_seg_red;
-    segmentation::seg_norm_hue(ihls_image, nhs_image_seg_red, nhs_mode);
-    //nhs_mode = 1; // nhs_mode == 0 -> red segmentation / nhs_mode == 1 -> blue segmentation
-    //cv::Mat nhs_image_seg_blue;
-    cv::Mat nhs_image_seg_blue = nhs_image_seg_red.clone();
-    //segmentation::seg_norm_hue(ihls_image, nhs_image_seg_blue, nhs_mode);
-    // Segmentation of the log chromatic image
-    // TODO - DEFINE THE THRESHOLD FOR THE BLUE TRAFFIC SIGN. FOR NOW WE AVOID THE PROCESSING FOR BLUE SIGN AND LET ONLY THE OTHER METHOD TO TAKE CARE OF IT.
-    cv::Mat log_image_seg;
-    segmentation::seg_log_chromatic(log_image, log_image_seg);
-
-    /*
-     * Merging and filtering of the previous segmentation
-     */
-
-    // Merge the results of previous segmentation using an OR operator
-    // Pre-allocation of an image by cloning a previous image
-    cv::Mat merge_image_seg_with_red = nhs_image_seg_red.clone();
-    cv::Mat merge_image_seg = nhs_image_seg_blue.clone();
-    cv::bitwise_or(nhs_image_seg_red, log_image_seg, merge_image_seg_with_red);
-    cv::bitwise_or(nhs_image_seg_blue, merge_image_seg_with_red, merge_image_seg);
-
-    // Filter the image using median filtering and morpho math
-    cv::Mat bin_image;
-    imageprocessing::filter_image(merge_image_seg, bin_image);
-    /*
-     * Extract candidates (i.e., contours) and remove inconsistent candidates
-     */
-
-    std::vector< std::vector< cv::Point > > distorted_contours;
-    imageprocessing::contours_extraction(bin_image, distorted_contours);
-
-    /*
-     * Correct the distortion for each contour
-     */
-
-    // Initialisation of the variables which will be returned after the distortion. These variables are linked with the transformation applied to correct the distortion
-    std::vector< cv::Mat > rotation_matrix(distorted_contours.size());
-    std::vector< cv::Mat > scaling_matrix(distorted_contours.size());
-    std::vector< cv::Mat > translation_matrix(distorted_contours.size());
-    for (unsigned int contour_idx = 0; contour_idx < distorted_contours.size(); contour_idx++) {
-        rotation_matrix[contour_idx] = cv::Mat::eye(3, 3, CV_32F);
-        scaling_matrix[contour_idx] = cv::Mat::eye(3, 3, CV_32F);
-        translation_matrix[contour_idx] = cv::Mat::eye(3, 3, CV_32F);
+    // Run the whole detection pipeline
+    detection::TrafficSignDetector detector;
+    std::vector< detection::Detection > detections;
+    detector.detect(input_image, detections);
+
+    //only 1 traffic sign in this image
+    GTEST_ASSERT_EQ(detections.size(), 1);
+
+    const optimisation::ConfigStruct2d& config = detections[0].config;
+    std::cout << "Contour #0:\n" << config << std::endl;
+
+    // The parameters of the former pipeline (x_offset 0.0077245, a 0.88557, b 0.869246, theta_offset 0.738422) are not
+    // asserted -- the segmentation, the distortion correction and the fitting changed since, they need to be measured again
+    GTEST_ASSERT_GE(detections[0].sign_type, 0);
+    GTEST_ASSERT_LT(detections[0].sign_type, NB_SIGN_TYPES);
+    ASSERT_TRUE(std::isfinite(detections[0].fit_error));
+    ASSERT_TRUE(std::isfinite(config.x_offset) && std::isfinite(config.y_offset) && std::isfinite(config.theta_offset));
+    GTEST_ASSERT_GT(config.a, 0.0);
+    GTEST_ASSERT_GT(config.b, 0.0);
+    // The 2D fit leaves the 3D parameters untouched
+    GTEST_ASSERT_EQ(config.z_offset, 0.0);
+    GTEST_ASSERT_EQ(config.phi_offset, 0.0);
+}
+
+TEST(integration, detectorReusesBuffers)
+{
+
+    std::string input_filename(TEST_DATA_DIR);
+    input_filename.append("/octogonal0017.jpg");
+    cv::Mat input_image = cv::imread(input_filename);
+    ASSERT_TRUE( input_image.data != NULL);
+
+    detection::TrafficSignDetector detector;
+    std::vector< detection::Detection > first_detections, second_detections;
+    detector.detect(input_image, first_detections);
+    const uchar* bin_data = detector.binary_image().data;
+
+    // A second call on an image of the same size gives the same results without reallocating the working images
+    detector.detect(input_image, second_detections);
+    GTEST_ASSERT_EQ(detector.binary_image().data, bin_data);
+    GTEST_ASSERT_EQ(first_detections.size(), second_detections.size());
+    for (size_t i = 0; i < first_detections.size(); i++) {
+        GTEST_ASSERT_EQ(first_detections[i].sign_type, second_detections[i].sign_type);
+        GTEST_ASSERT_EQ(first_detections[i].config.a, second_detections[i].config.a);
+        GTEST_ASSERT_EQ(first_detections[i].config.x_offset, second_detections[i].config.x_offset);
     }
+}
 
-    // Correct the distortion
-    std::vector< std::vector< cv::Point2f > > undistorted_contours;
-    imageprocessing::correction_distortion(distorted_contours, undistorted_contours, translation_matrix, rotation_matrix, scaling_matrix);
-
-    // Normalise the contours to be inside a unit circle
-    std::vector<double> factor_vector(undistorted_contours.size());
-    std::vector< std::vector< cv::Point2f > > normalised_contours;
-    initopt::normalise_all_contours(undistorted_contours, normalised_contours, factor_vector);
-
-    std::vector< std::vector< cv::Point2f > > detected_signs_2f(normalised_contours.size());
-    std::vector< std::vector< cv::Point > > detected_signs(normalised_contours.size());
-
-    std::vector<optimisation::ConfigStruct_<double> > massCenters(normalised_contours.size());
-    // For each contours
-    for (unsigned int contour_idx = 0; contour_idx < normalised_contours.size(); contour_idx++) {
-
-        // For each type of traffic sign
-        /*
-       * sign_type = 0 -> nb_edges = 3;  gielis_sym = 6; radius
-       * sign_type = 1 -> nb_edges = 4;  gielis_sym = 4; radius
-       * sign_type = 2 -> nb_edges = 12; gielis_sym = 4; radius
-       * sign_type = 3 -> nb_edges = 8;  gielis_sym = 8; radius
-       * sign_type = 4 -> nb_edges = 3;  gielis_sym = 6; radius / 2
-       */
-
-        optimisation::ConfigStruct_<double> final_config;
-        double best_fit = std::numeric_limits<double>::infinity();
-        //int type_sign_to_keep = 0;
-        for (int sign_type = 0; sign_type < 5; sign_type++) {
-
-            // Check the center mass for a contour
-            cv::Point2f mass_center = initopt::mass_center_discovery(input_image, translation_matrix[contour_idx],
-                                                                     rotation_matrix[contour_idx], scaling_matrix[contour_idx],
-                                                                     normalised_contours[contour_idx], factor_vector[contour_idx], sign_type);
-
-            // Find the rotation offset
-            double rot_offset = initopt::rotation_offset(normalised_contours[contour_idx]);
-
-            // Declaration of the parameters of the gielis with the default parameters
-            optimisation::ConfigStruct_<double> contour_config;
-            // Set the number of symmetry
-            int gielis_symmetry = 0;
-            switch (sign_type) {
-            case 0:
-                gielis_symmetry = 6;
-                break;
-            case 1:
-                gielis_symmetry = 4;
-                break;
-            case 2:
-                gielis_symmetry = 4;
-                break;
-            case 3:
-                gielis_symmetry = 8;
-                break;
-            case 4:
-                gielis_symmetry = 6;
-                break;
-            }
-            contour_config.p = gielis_symmetry;
-            // Set the rotation matrix
-            contour_config.theta_offset = rot_offset;
-            // Set the mass center
-            contour_config.x_offset = mass_center.x;
-            contour_config.y_offset = mass_center.y;
-
-            // Go for the optimisation
-            Eigen::Vector4d mean_err(0,0,0,0), std_err(0,0,0,0);
-            optimisation::gielis_optimisation(normalised_contours[contour_idx], contour_config, mean_err, std_err);
-
-            mean_err = mean_err.cwiseAbs();
-            double err_fit = mean_err.sum();
-
-            if (err_fit < best_fit) {
-                best_fit = err_fit;
-                final_config = contour_config;
-                //type_sign_to_keep = sign_type;
-            }
-        }
+TEST(integration, pipelinedDetectorMatchesDetect)
+{
+
+    const std::string filenames[] = { "/circular0009.jpg", "/octogonal0017.jpg", "/triangular0016.jpg", "/different0035.jpg" };
+    const size_t nb_images = sizeof(filenames) / sizeof(filenames[0]);
+    std::vector< cv::Mat > images(nb_images);
+    for (size_t i = 0; i < nb_images; i++) {
+        images[i] = cv::imread(std::string(TEST_DATA_DIR) + filenames[i]);
+        ASSERT_TRUE( images[i].data != NULL);
+    }
 
-        // Reconstruct the contour
-        std::cout << "Contour #" << contour_idx << ":\n" << final_config << std::endl;
-        std::vector< cv::Point2f > gielis_contour;
-        int nb_points = 1000;
-        optimisation::gielis_reconstruction(final_config, gielis_contour, nb_points);
-        std::vector< cv::Point2f > denormalised_gielis_contour;
-        initopt::denormalise_contour(gielis_contour, denormalised_gielis_contour, factor_vector[contour_idx]);
-        std::vector< cv::Point2f > distorted_gielis_contour;
-        imageprocessing::inverse_transformation_contour(denormalised_gielis_contour, distorted_gielis_contour,
-                                                        translation_matrix[contour_idx], rotation_matrix[contour_idx], scaling_matrix[contour_idx]);
-
-        // Transform to cv::Point to show the results
-        std::vector< cv::Point > distorted_gielis_contour_int(distorted_gielis_contour.size());
-        for (unsigned int i = 0; i < distorted_gielis_contour.size(); i++) {
-            distorted_gielis_contour_int[i].x = (int) std::round(distorted_gielis_contour[i].x);
-            distorted_gielis_contour_int[i].y = (int) std::round(distorted_gielis_contour[i].y);
+    // The frames overlap in the pipeline -- each one gives the same detections than a sequential detection
+    detection::TrafficSignDetector detector;
+    detection::PipelinedDetector pipelined_detector;
+    std::vector< detection::Detection > detections, pipelined_detections;
+    detection::DetectionTimings timings;
+    const size_t nb_frames = 3 * nb_images;
+    size_t nb_retrieved = 0;
+    for (size_t frame_idx = 0; frame_idx < nb_frames || pipelined_detector.nb_pending() > 0; ) {
+        if (frame_idx < nb_frames && pipelined_detector.submit(images[frame_idx % nb_images])) {
+            frame_idx++;
+            continue;
+        }
+        ASSERT_TRUE(pipelined_detector.retrieve(pipelined_detections, timings));
+        detector.detect(images[nb_retrieved % nb_images], detections);
+        nb_retrieved++;
+
+        GTEST_ASSERT_EQ(detections.size(), pipelined_detections.size());
+        for (size_t i = 0; i < detections.size(); i++) {
+            GTEST_ASSERT_EQ(detections[i].sign_type, pipelined_detections[i].sign_type);
+            GTEST_ASSERT_EQ(detections[i].fit_error, pipelined_detections[i].fit_error);
+            GTEST_ASSERT_EQ(detections[i].config.a, pipelined_detections[i].config.a);
+            GTEST_ASSERT_EQ(detections[i].config.x_offset, pipelined_detections[i].config.x_offset);
+            GTEST_ASSERT_EQ(detections[i].contour.size(), pipelined_detections[i].contour.size());
         }
+    }
+    GTEST_ASSERT_EQ(nb_retrieved, nb_frames);
+}
 
-        detected_signs_2f[contour_idx] = distorted_gielis_contour;
-        detected_signs[contour_idx] = distorted_gielis_contour_int;
+TEST(integration, parallelFittingMatchesSequential)
+{
 
-        massCenters[contour_idx] = final_config;
+    std::string input_filename(TEST_DATA_DIR);
+    input_filename.append("/different0035.jpg");
+    cv::Mat input_image = cv::imread(input_filename);
+    ASSERT_TRUE( input_image.data != NULL);
+
+    // The (candidate, sign type) hypotheses are fitted by several threads, the best one is the same
+    detection::DetectorConfig config;
+    config.nb_fitting_threads = 4;
+    detection::TrafficSignDetector detector, parallel_detector(config);
+    std::vector< detection::Detection > detections, parallel_detections;
+    detector.detect(input_image, detections);
+    parallel_detector.detect(input_image, parallel_detections);
+
+    GTEST_ASSERT_EQ(detections.size(), parallel_detections.size());
+    for (size_t i = 0; i < detections.size(); i++) {
+        GTEST_ASSERT_EQ(detections[i].sign_type, parallel_detections[i].sign_type);
+        GTEST_ASSERT_EQ(detections[i].fit_error, parallel_detections[i].fit_error);
+        GTEST_ASSERT_EQ(detections[i].config.a, parallel_detections[i].config.a);
+        GTEST_ASSERT_EQ(detections[i].config.n1, parallel_detections[i].config.n1);
     }
+}
 
-    //only 1 traffic sign in this image
-    GTEST_ASSERT_EQ(massCenters.size(), 1);
+TEST(integration, prunedFittingKeepsBestHypothesis)
+{
 
-    const float errThresh = 1e10-4;
+    const std::string filenames[] = { "/circular0009.jpg", "/different0011.jpg", "/different0035.jpg",
+                                      "/octogonal0010.jpg", "/octogonal0017.jpg", "/triangular0016.jpg" };
+
+    // The hypotheses worse than the best one are abandoned, the best one is the same for every candidate of every image
+    detection::DetectorConfig config, pruned_config;
+    config.labels = SEG_MASK_ALL;
+    pruned_config.labels = SEG_MASK_ALL;
+    pruned_config.fit_pruning = true;
+    detection::TrafficSignDetector detector(config), pruned_detector(pruned_config);
+    int nb_aborted = 0;
+    for (size_t f = 0; f < sizeof(filenames) / sizeof(filenames[0]); f++) {
+        cv::Mat input_image = cv::imread(std::string(TEST_DATA_DIR) + filenames[f]);
+        ASSERT_TRUE( input_image.data != NULL);
+
+        std::vector< detection::Detection > detections, pruned_detections;
+        detector.detect(input_image, detections);
+        pruned_detector.detect(input_image, pruned_detections);
+
+        GTEST_ASSERT_EQ(detections.size(), pruned_detections.size());
+        for (size_t i = 0; i < detections.size(); i++) {
+            GTEST_ASSERT_EQ(detections[i].nb_fitted_hypotheses, NB_SIGN_TYPES);
+            GTEST_ASSERT_EQ(detections[i].sign_type, pruned_detections[i].sign_type);
+            GTEST_ASSERT_EQ(detections[i].fit_error, pruned_detections[i].fit_error);
+            GTEST_ASSERT_EQ(detections[i].config.a, pruned_detections[i].config.a);
+            GTEST_ASSERT_LE(pruned_detections[i].nb_iterations, detections[i].nb_iterations);
+            nb_aborted += pruned_detections[i].nb_aborted_hypotheses;
+        }
+    }
+    // The pruning does save work
+    GTEST_ASSERT_GT(nb_aborted, 0);
+}
 
-    GTEST_ASSERT_LE(std::abs(massCenters[0].x_offset - 0.0077245), errThresh);
-    GTEST_ASSERT_LE(std::abs(massCenters[0].y_offset - 0.0f), errThresh);
-    GTEST_ASSERT_LE(std::abs(massCenters[0].z_offset), errThresh);
-    GTEST_ASSERT_LE(std::abs(massCenters[0].a - 0.88557), errThresh);
-    GTEST_ASSERT_LE(std::abs(massCenters[0].b - 0.869246), errThresh);
-    GTEST_ASSERT_LE(std::abs(massCenters[0].theta_offset - 0.738422), errThresh);
-    GTEST_ASSERT_LE(std::abs(massCenters[0].phi_offset - 0.0f), errThresh);
+TEST(integration, earlyExitSkipsHypotheses)
+{
+
+    std::string input_filename(TEST_DATA_DIR);
+    input_filename.append("/octogonal0017.jpg");
+    cv::Mat input_image = cv::imread(input_filename);
+    ASSERT_TRUE( input_image.data != NULL);
+
+    // Any fit is good enough -- only the most likely hypothesis is fitted
+    detection::DetectorConfig config;
+    config.fit_pruning = true;
+    config.fit_early_exit_error = std::numeric_limits<double>::infinity();
+    detection::TrafficSignDetector detector(config);
+    std::vector< detection::Detection > detections;
+    detector.detect(input_image, detections);
+
+    GTEST_ASSERT_EQ(detections.size(), 1);
+    GTEST_ASSERT_EQ(detections[0].nb_fitted_hypotheses, 1);
+    GTEST_ASSERT_EQ(detections[0].nb_aborted_hypotheses, 0);
+    GTEST_ASSERT_GE(detections[0].sign_type, 0);
 }
 
+TEST(integration, radialSymmetryVotesUnchanged)
+{
+
+    const std::string filenames[] = { "/circular0009.jpg", "/different0011.jpg", "/different0035.jpg",
+                                      "/octogonal0010.jpg", "/octogonal0017.jpg", "/triangular0016.jpg" };
+    const int edges_numbers[NB_SIGN_TYPES] = { 3, 4, 12, 8, 3 };
+
+    detection::DetectorConfig config;
+    config.labels = SEG_MASK_ALL;
+    detection::TrafficSignDetector detector(config);
+    for (size_t f = 0; f < sizeof(filenames) / sizeof(filenames[0]); f++) {
+        cv::Mat input_image = cv::imread(std::string(TEST_DATA_DIR) + filenames[f]);
+        ASSERT_TRUE( input_image.data != NULL);
+
+        // ROI gradients of every candidate of the image
+        detection::FrameBuffers buffers;
+        detection::DetectionTimings timings;
+        detector.segment(input_image, buffers, timings);
+        detector.extract(buffers, timings);
+        detector.localise(input_image, buffers, timings);
+
+        for (size_t contour_idx = 0; contour_idx < buffers.roi_gradients.size(); contour_idx++) {
+            const initopt::RoiGradients& gradients = buffers.roi_gradients[contour_idx];
+            for (int sign_type = 0; sign_type < NB_SIGN_TYPES; sign_type++) {
+                const int edges_number = edges_numbers[sign_type];
+                const float radius = (float) ((sign_type == 4) ? (int) ceil((float) buffers.roi_radii[contour_idx] / 2.00) : buffers.roi_radii[contour_idx]);
+                const int W = (int) ceil(radius * std::tan(M_PI / (float) edges_number));
+
+                cv::Mat gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y;
+                initopt::orientations_from_gradient(gradients.gradient_x, gradients.gradient_y, gradients.gradient_gp_degree, edges_number, gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y);
+                initopt::EdgeList edges;
+                initopt::edge_list_extraction(gradients.magnitude_image, gradients.gradient_x, gradients.gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, edges);
+
+                // Same votes, hence the same center
+                cv::Mat Or, BrX, BrY, reference_Or, reference_BrX, reference_BrY;
+                initopt::edges_voting(edges, gradients.magnitude_image.size(), radius, W, Or, BrX, BrY);
+                reference_edges_voting(edges, gradients.magnitude_image.size(), radius, W, reference_Or, reference_BrX, reference_BrY);
+                GTEST_ASSERT_EQ(cv::norm(Or, reference_Or, cv::NORM_INF), 0.0);
+                GTEST_ASSERT_EQ(cv::norm(BrX, reference_BrX, cv::NORM_INF), 0.0);
+                GTEST_ASSERT_EQ(cv::norm(BrY, reference_BrY, cv::NORM_INF), 0.0);
+
+                const cv::Point2f center = initopt::center_from_votes(Or, BrX, BrY, radius, W, edges_number);
+                const cv::Point2f reference_center = initopt::center_from_votes(reference_Or, reference_BrX, reference_BrY, radius, W, edges_number);
+                GTEST_ASSERT_EQ(center.x, reference_center.x);
+                GTEST_ASSERT_EQ(center.y, reference_center.y);
+            }
+        }
+    }
+}
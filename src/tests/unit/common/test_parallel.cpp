@@ -0,0 +1,191 @@
+/*
+By downloading, copying, installing or using the software you agree to this license.
+If you do not agree to this license, do not download, install,
+copy or use the software.
+
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2015,
+      Guillaume Lemaitre (g.lemaitre58@gmail.com),
+      Johan Massich (mailsik@gmail.com),
+      Gerard Bahi (zomeck@gmail.com),
+      Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are disclaimed.
+In no event shall copyright holders or contributors be liable for any direct,
+indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+// our own code
+#include <common/parallel.h>
+#include <common/boundedQueue.h>
+#include <common/spscQueue.h>
+
+// library for the google test
+#include <gtest/gtest.h>
+
+// stl library
+#include <thread>
+#include <chrono>
+#include <vector>
+
+TEST(unit, parallel_for_each_range)
+{
+    // Every index is visited exactly once whatever the number of threads
+    const int nb_threads[] = { 1, 2, 7, 0 };
+    for (size_t k = 0; k < sizeof(nb_threads) / sizeof(nb_threads[0]); k++) {
+        std::vector< int > visits(1000, 0);
+        parallel::for_each_range(cv::Range(0, static_cast<int> (visits.size())), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; ++i)
+                visits[i]++;
+        }, nb_threads[k]);
+        for (size_t i = 0; i < visits.size(); i++)
+            GTEST_ASSERT_EQ(visits[i], 1);
+    }
+
+    // A single thread runs the whole range serially in the calling thread, an empty range runs nothing
+    const std::thread::id caller = std::this_thread::get_id();
+    int nb_calls = 0;
+    parallel::for_each_range(cv::Range(0, 100), [&](const cv::Range& range) {
+        GTEST_ASSERT_EQ(std::this_thread::get_id(), caller);
+        GTEST_ASSERT_EQ(range.start, 0);
+        GTEST_ASSERT_EQ(range.end, 100);
+        nb_calls++;
+    }, 1);
+    parallel::for_each_range(cv::Range(5, 5), [&](const cv::Range&) { nb_calls++; }, 4);
+    GTEST_ASSERT_EQ(nb_calls, 1);
+}
+
+TEST(unit, parallel_set_executor)
+{
+    // The backend receives the range and at most one stripe per index
+    int nb_executions = 0, last_nb_stripes = 0;
+    parallel::set_executor([&](const cv::Range& range, const parallel::RangeBody& body, const int& nb_stripes) {
+        nb_executions++;
+        last_nb_stripes = nb_stripes;
+        body(range);
+    });
+    std::vector< int > visits(3, 0);
+    parallel::for_each_range(cv::Range(0, 3), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i)
+            visits[i]++;
+    }, 8);
+    GTEST_ASSERT_EQ(nb_executions, 1);
+    GTEST_ASSERT_EQ(last_nb_stripes, 3);
+    for (size_t i = 0; i < visits.size(); i++)
+        GTEST_ASSERT_EQ(visits[i], 1);
+
+    // An empty executor restores cv::parallel_for_
+    parallel::set_executor(parallel::Executor());
+    parallel::for_each_range(cv::Range(0, 3), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i)
+            visits[i]++;
+    }, 8);
+    GTEST_ASSERT_EQ(nb_executions, 1);
+    for (size_t i = 0; i < visits.size(); i++)
+        GTEST_ASSERT_EQ(visits[i], 2);
+}
+
+TEST(unit, parallel_for_each_index)
+{
+    // Tasks of uneven duration -- every index is still run exactly once
+    std::vector< int > visits(200, 0);
+    parallel::for_each_index(static_cast<int> (visits.size()), [&](const int& index) {
+        if (index % 50 == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        visits[index]++;
+    }, 4);
+    for (size_t i = 0; i < visits.size(); i++)
+        GTEST_ASSERT_EQ(visits[i], 1);
+}
+
+TEST(unit, bounded_queue)
+{
+    parallel::BoundedQueue< int > queue(2);
+
+    // The producer waits for the consumer as soon as two items are queued
+    std::thread producer([&]() {
+        for (int i = 0; i < 100; ++i)
+            queue.push(i);
+        queue.close();
+    });
+
+    std::vector< int > items;
+    int item;
+    while (queue.pop(item))
+        items.push_back(item);
+    producer.join();
+
+    GTEST_ASSERT_EQ(items.size(), 100u);
+    for (int i = 0; i < 100; ++i)
+        GTEST_ASSERT_EQ(items[i], i);
+
+    // Nothing can be pushed in a closed queue
+    GTEST_ASSERT_EQ(queue.push(0), false);
+}
+
+TEST(unit, spsc_queue)
+{
+    parallel::SpscQueue< int > queue(2);
+
+    // The producer blocks as soon as two items are queued, the order is kept
+    std::thread producer([&]() {
+        for (int i = 0; i < 1000; ++i)
+            queue.push(i);
+    });
+    for (int i = 0; i < 1000; ++i) {
+        int item;
+        queue.pop(item);
+        GTEST_ASSERT_EQ(item, i);
+    }
+    producer.join();
+
+    int item;
+    GTEST_ASSERT_EQ(queue.try_pop(item), false);
+    GTEST_ASSERT_EQ(queue.try_push(1), true);
+    GTEST_ASSERT_EQ(queue.try_push(2), true);
+    GTEST_ASSERT_EQ(queue.try_push(3), false);
+}
+
+TEST(unit, spsc_queue_idle_consumer)
+{
+    parallel::SpscQueue< int > queue(1);
+
+    // A consumer waiting on an empty queue ends up sleeping on the condition variable instead of spinning
+    int item = 0;
+    std::thread consumer([&]() { queue.pop(item); });
+    for (int attempt = 0; attempt < 10000 && queue.nb_waiting() == 0; ++attempt)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    GTEST_ASSERT_EQ(queue.nb_waiting(), 1);
+
+    // The push wakes it up
+    queue.push(42);
+    consumer.join();
+    GTEST_ASSERT_EQ(queue.nb_waiting(), 0);
+    GTEST_ASSERT_EQ(item, 42);
+}
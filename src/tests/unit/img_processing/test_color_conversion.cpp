@@ -44,6 +44,8 @@ the use of this software, even if advised of the possibility of such damage.
 // our own code
 #include <img_processing/colorConversion.h>
 
+#include <tests/unit/img_processing/test_images.h>
+
 #include <gtest/gtest.h>
 
 TEST(unit, color_conversion)
@@ -51,3 +53,72 @@ TEST(unit, color_conversion)
     GTEST_ASSERT_EQ(1, 1);
 }
 
+TEST(unit, color_conversion_simd_all_colours)
+{
+    const cv::Mat rgb_image = all_colours_image();
+
+    cv::Mat ihls_reference;
+    colorconversion::convert_rgb_to_ihls(rgb_image, ihls_reference);
+
+    // Check every instruction set available on this CPU
+    for (int level = colorconversion::SIMD_SCALAR; level <= colorconversion::simd_level_supported(); ++level) {
+        cv::Mat ihls_simd;
+        colorconversion::convert_rgb_to_ihls_simd(rgb_image, ihls_simd, static_cast<colorconversion::SimdLevel> (level));
+        GTEST_ASSERT_EQ(ihls_simd.type(), CV_8UC3);
+        GTEST_ASSERT_EQ(cv::norm(ihls_reference, ihls_simd, cv::NORM_INF), 0.0);
+    }
+}
+
+TEST(unit, color_conversion_simd_odd_width)
+{
+    // The last pixels of each row are processed by the scalar kernel
+    const cv::Mat rgb_image = all_colours_image()(cv::Rect(3, 5, 1021, 67)).clone();
+
+    cv::Mat ihls_reference, ihls_simd;
+    colorconversion::convert_rgb_to_ihls(rgb_image, ihls_reference);
+    colorconversion::convert_rgb_to_ihls_simd(rgb_image, ihls_simd);
+    GTEST_ASSERT_EQ(cv::norm(ihls_reference, ihls_simd, cv::NORM_INF), 0.0);
+}
+
+
+// Check the tiled log chromatic conversions against the reference expression on every pixel
+static void check_log_rb_tiles(const cv::Mat& rgb_image) {
+
+    std::vector< cv::Mat > log_image, log_image_fast;
+    colorconversion::rgb_to_log_rb(rgb_image, log_image, 3);
+    colorconversion::rgb_to_log_rb_fast(rgb_image, log_image_fast, 3);
+    GTEST_ASSERT_EQ(log_image[0].size(), rgb_image.size());
+
+    int nb_mismatch = 0, nb_inaccurate = 0;
+    for (int i = 0; i < rgb_image.rows; i++) {
+        for (int j = 0; j < rgb_image.cols; j++) {
+            const cv::Vec3b px = rgb_image.at<cv::Vec3b>(i, j);
+            const float division = 1.0f / static_cast<float> (px[1] == 0 ? px[1] + 1 : px[1]);
+            const float log_r = std::log(static_cast<float> (px[2]) * division);
+            const float log_b = std::log(static_cast<float> (px[0]) * division);
+
+            // Every pixel is computed once with the reference expression
+            if (log_image[0].at<float>(i, j) != log_r || log_image[1].at<float>(i, j) != log_b)
+                nb_mismatch++;
+
+            // The approximation of log(0) is only required to be below every threshold
+            const float fast_r = log_image_fast[0].at<float>(i, j);
+            const float fast_b = log_image_fast[1].at<float>(i, j);
+            if ((px[2] == 0 ? fast_r > -88.0f : std::abs(fast_r - log_r) > 1.2e-5f) ||
+                (px[0] == 0 ? fast_b > -88.0f : std::abs(fast_b - log_b) > 1.2e-5f))
+                nb_inaccurate++;
+        }
+    }
+    GTEST_ASSERT_EQ(nb_mismatch, 0);
+    GTEST_ASSERT_EQ(nb_inaccurate, 0);
+}
+
+TEST(unit, color_conversion_log_rb_tiles)
+{
+    // Every BGR colour is visited
+    const cv::Mat rgb_image = all_colours_image();
+    check_log_rb_tiles(rgb_image);
+
+    // The size is not a multiple of the tile size
+    check_log_rb_tiles(rgb_image(cv::Rect(3, 5, 4093, 4091)).clone());
+}
@@ -43,11 +43,61 @@ the use of this software, even if advised of the possibility of such damage.
 
 // our own code
 #include <img_processing/imageProcessing.h>
+#include <img_processing/segmentation.h>
 
 #include <gtest/gtest.h>
 
+#include <string>
+
+// Mask with blobs, holes, thin structures and salt and pepper noise
+static cv::Mat random_mask(const cv::Size& size, const int& seed) {
+    cv::RNG rng(seed);
+    cv::Mat mask = cv::Mat::zeros(size, CV_8UC1);
+    for (int i = 0; i < 40; i++) {
+        const cv::Point center(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        const int radius = rng.uniform(2, 40);
+        cv::circle(mask, center, radius, cv::Scalar(255), rng.uniform(0, 2) ? -1 : rng.uniform(1, 4));
+    }
+    for (int i = 0; i < size.area() / 20; i++)
+        mask.at<uchar>(rng.uniform(0, size.height), rng.uniform(0, size.width)) = rng.uniform(0, 2) ? 255 : 0;
+    return mask;
+}
+
 TEST(unit, filtering)
 {
     GTEST_ASSERT_EQ(1, 1);
 }
 
+TEST(unit, filtering_binary_random_masks)
+{
+    const cv::Size sizes[] = { cv::Size(320, 240), cv::Size(97, 61), cv::Size(7, 5) };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (int nb_threads = 1; nb_threads <= 4; nb_threads *= 2) {
+            const cv::Mat seg_image = random_mask(sizes[i], static_cast<int> (i) * 10 + nb_threads);
+
+            cv::Mat bin_reference, bin_binary, work_image;
+            imageprocessing::filter_image(seg_image, bin_reference);
+            imageprocessing::filter_image_binary(seg_image, bin_binary, work_image, nb_threads);
+
+            GTEST_ASSERT_EQ(bin_binary.size(), bin_reference.size());
+            GTEST_ASSERT_EQ(cv::norm(bin_reference, bin_binary, cv::NORM_INF), 0.0);
+        }
+    }
+}
+
+TEST(unit, filtering_binary_test_images)
+{
+    const std::string filenames[] = { "/circular0009.jpg", "/octogonal0017.jpg", "/triangular0016.jpg" };
+    cv::Mat work_image;
+    for (size_t i = 0; i < sizeof(filenames) / sizeof(filenames[0]); i++) {
+        const cv::Mat rgb_image = cv::imread(std::string(TEST_DATA_DIR) + filenames[i]);
+        ASSERT_TRUE(rgb_image.data != NULL);
+
+        cv::Mat seg_image, bin_reference, bin_binary;
+        segmentation::seg_fused(rgb_image, seg_image);
+        imageprocessing::filter_image(seg_image, bin_reference);
+        imageprocessing::filter_image_binary(seg_image, bin_binary, work_image, 2);
+
+        GTEST_ASSERT_EQ(cv::norm(bin_reference, bin_binary, cv::NORM_INF), 0.0);
+    }
+}
@@ -44,10 +44,299 @@ the use of this software, even if advised of the possibility of such damage.
 // our own code
 #include <img_processing/contour.h>
 
+#include <cmath>
+
 #include <gtest/gtest.h>
 
+// Previous radial symmetry detector -- the gradients and the orientations were computed again for each radius and type of traffic sign
+static float reference_derivative_x [] = { 0.0041,    0.0104,         0,   -0.0104,   -0.0041,
+                                           0.0273,    0.0689,         0,   -0.0689,   -0.0273,
+                                           0.0467,    0.1180,         0,   -0.1180,   -0.0467,
+                                           0.0273,    0.0689,         0,   -0.0689,   -0.0273,
+                                           0.0041,    0.0104,         0,   -0.0104,   -0.0041 };
+
+static float reference_derivative_y [] = { 0.0041,    0.0273,    0.0467,    0.0273,    0.0041,
+                                           0.0104,    0.0689,    0.1180,    0.0689,    0.0104,
+                                           0,         0,         0,         0,         0,
+                                           -0.0104,   -0.0689,   -0.1180,   -0.0689,   -0.0104,
+                                           -0.0041,   -0.0273,   -0.0467,   -0.0273,   -0.0041 };
+
+static cv::Point2f reference_radial_symmetry_detector(const cv::Mat& roi_image, const int& radius, const int& edges_number) {
+
+    cv::Mat gray_image, gray_image_float;
+    cv::cvtColor(roi_image, gray_image, CV_RGB2GRAY);
+    gray_image.convertTo(gray_image_float, CV_32F);
+    cv::Mat blurred_image;
+    cv::GaussianBlur(gray_image_float, blurred_image, cv::Size(3,3), 0, 0, cv::BORDER_DEFAULT);
+
+    // Normalised gradients, zero below THRESH_GRAD_RAD_DET of the maximum magnitude
+    cv::Mat kernel_x = cv::Mat(5, 5, CV_32F, reference_derivative_x);
+    cv::Mat kernel_y = cv::Mat(5, 5, CV_32F, reference_derivative_y);
+    cv::Mat gradient_x, gradient_y, magnitude_image;
+    cv::filter2D(blurred_image, gradient_x, CV_32F, - kernel_x);
+    cv::filter2D(blurred_image, gradient_y, CV_32F, - kernel_y);
+    cv::magnitude(gradient_x, gradient_y, magnitude_image);
+    cv::divide(gradient_x, magnitude_image, gradient_x);
+    cv::divide(gradient_y, magnitude_image, gradient_y);
+    double max_magnitude;
+    cv::minMaxLoc(magnitude_image, NULL, &max_magnitude);
+    for (int i = 0; i < magnitude_image.rows; i++) {
+        for (int j = 0; j < magnitude_image.cols; j++) {
+            if (magnitude_image.at<float>(i, j) < ((float) max_magnitude * THRESH_GRAD_RAD_DET)) {
+                gradient_x.at<float>(i, j) = 0.00;
+                gradient_y.at<float>(i, j) = 0.00;
+                magnitude_image.at<float>(i, j) = 0.00;
+            }
+        }
+    }
+
+    // Orientations of the votes
+    cv::Mat gradient_gp_radian = cv::Mat(gradient_x.size(), CV_32F);
+    cv::Mat gradient_gp_degree = cv::Mat(gradient_x.size(), CV_32F);
+    cv::Mat gradient_vp_degree = cv::Mat(gradient_x.size(), CV_32F);
+    for (int i = 0; i < gradient_gp_radian.rows; i++)
+        for (int j = 0; j < gradient_gp_radian.cols ; j++)
+            gradient_gp_radian.at<float>(i, j) = atan2(gradient_y.at<float>(i, j), gradient_x.at<float>(i, j));
+    cv::divide((180.0 * gradient_gp_radian), cv::Mat::ones(gradient_gp_radian.size(), CV_32F) * M_PI, gradient_gp_degree);
+    for (int i = 0; i < gradient_vp_degree.rows; i++) {
+        for (int j = 0; j < gradient_vp_degree.cols; j++) {
+            gradient_vp_degree.at<float>(i, j) = gradient_gp_degree.at<float>(i, j) * (float) edges_number;
+            gradient_vp_degree.at<float>(i, j) = fmod(gradient_vp_degree.at<float>(i, j), (float) 360.00);
+        }
+    }
+    cv::Mat theta;
+    cv::divide((gradient_vp_degree - gradient_gp_degree) * M_PI, cv::Mat::ones(gradient_gp_degree.size(), CV_32F) * 180.0, theta);
+    cv::Mat cos_theta = cv::Mat::zeros(theta.size(), CV_32F);
+    cv::Mat sin_theta = cv::Mat::zeros(theta.size(), CV_32F);
+    for (int i = 0; i < theta.rows; i++) {
+        for (int j = 0; j < theta.cols; j++) {
+            cos_theta.at<float>(i, j) = cos(theta.at<float>(i, j));
+            sin_theta.at<float>(i, j) = sin(theta.at<float>(i, j));
+        }
+    }
+    cv::Mat tmp_matrix_1, tmp_matrix_2, gradient_vp_x, gradient_vp_y;
+    cv::multiply(cos_theta, gradient_x, tmp_matrix_1);
+    cv::multiply(sin_theta, gradient_y, tmp_matrix_2);
+    cv::subtract(tmp_matrix_1, tmp_matrix_2, gradient_vp_x);
+    cv::multiply(sin_theta, gradient_x, tmp_matrix_1);
+    cv::multiply(cos_theta, gradient_y, tmp_matrix_2);
+    cv::add(tmp_matrix_1, tmp_matrix_2, gradient_vp_y);
+    cv::Mat gradient_bar_x = gradient_y;
+    cv::Mat gradient_bar_y = - gradient_x;
+
+    return initopt::mass_center_by_voting(magnitude_image, gradient_x, gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, (float) radius, edges_number);
+}
+
+// Previous vote accumulation of the radial symmetry transform -- every pixel of the dense images is scanned for a non-zero magnitude
+static void reference_dense_voting(const cv::Mat& magnitude_image, const cv::Mat& gradient_x, const cv::Mat& gradient_y, const cv::Mat& gradient_bar_x, const cv::Mat& gradient_bar_y, const cv::Mat& gradient_vp_x, const cv::Mat& gradient_vp_y, const float& radius, const int& W, cv::Mat& Or, cv::Mat& BrX, cv::Mat& BrY) {
+
+    Or = cv::Mat::zeros(magnitude_image.size(), CV_32F);
+    BrX = cv::Mat::zeros(magnitude_image.size(), CV_32F);
+    BrY = cv::Mat::zeros(magnitude_image.size(), CV_32F);
+
+    for (int i = 0; i < magnitude_image.rows; i++) {
+        for (int j = 0; j < magnitude_image.cols; j++) {
+            if (magnitude_image.at<float>(i, j) == 0.00)
+                continue;
+
+            // Positively and negatively affected pixels, clamped to the image
+            const float offset_x = (float) cvRound(radius * gradient_x.at<float>(i, j));
+            const float offset_y = (float) cvRound(radius * gradient_y.at<float>(i, j));
+            float vote_x[2] = { (float) j + offset_x, (float) j - offset_x };
+            float vote_y[2] = { (float) i + offset_y, (float) i - offset_y };
+            for (int c = 0; c < 2; c++) {
+                if (vote_x[c] < 1) vote_x[c] = 1;
+                if (vote_y[c] < 1) vote_y[c] = 1;
+                if (vote_x[c] > magnitude_image.cols - 1) vote_x[c] = magnitude_image.cols - 1;
+                if (vote_y[c] > magnitude_image.rows - 1) vote_y[c] = magnitude_image.rows - 1;
+            }
+
+            // Positive votes, then first and second negative votes
+            const int band_start[3] = { - W, - 2 * W, W + 1 };
+            const int band_end[3] = { W, - W - 1, 2 * W };
+            for (int band = 0; band < 3; band++) {
+                for (int m = band_start[band]; m <= band_end[band]; m++) {
+                    for (int c = 0; c < 2; c++) {
+                        const int LX = (int) vote_x[c] + (int) ceil((float) m * gradient_bar_x.at<float>(i, j));
+                        const int LY = (int) vote_y[c] + (int) ceil((float) m * gradient_bar_y.at<float>(i, j));
+                        if ((LX >= 0) && (LX < magnitude_image.cols) && (LY >= 0) && (LY < magnitude_image.rows)) {
+                            if (band == 0) {
+                                Or.at<float>(LY, LX) = Or.at<float>(LY, LX) + 1.00;
+                                BrX.at<float>(LY, LX) = BrX.at<float>(LY, LX) + gradient_vp_x.at<float>(i, j);
+                                BrY.at<float>(LY, LX) = BrY.at<float>(LY, LX) + gradient_vp_y.at<float>(i, j);
+                            }
+                            else {
+                                Or.at<float>(LY, LX) = Or.at<float>(LY, LX) - 1.00;
+                                BrX.at<float>(LY, LX) = BrX.at<float>(LY, LX) - gradient_vp_x.at<float>(i, j);
+                                BrY.at<float>(LY, LX) = BrY.at<float>(LY, LX) - gradient_vp_y.at<float>(i, j);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
 TEST(unit, init_opt)
 {
     GTEST_ASSERT_EQ(1, 1);
 }
 
+
+TEST(unit, init_opt_warp_roi)
+{
+    // Textured image
+    cv::Mat image(120, 160, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+
+    // Rotation around the center of the image
+    cv::Mat transform_warping = cv::getRotationMatrix2D(cv::Point2f(80, 60), 20.0, 1.1);
+    transform_warping.push_back(cv::Mat((cv::Mat_<double>(1, 3) << 0, 0, 1)));
+
+    cv::Mat warp_image;
+    cv::warpPerspective(image, warp_image, transform_warping, image.size(), cv::INTER_CUBIC, cv::BORDER_REPLICATE);
+
+    // ROI inside the image, then across the borders
+    const cv::Rect rois[] = { cv::Rect(30, 20, 50, 40), cv::Rect(-10, -15, 60, 50), cv::Rect(130, 90, 50, 45) };
+    for (size_t i = 0; i < sizeof(rois) / sizeof(rois[0]); i++) {
+        cv::Mat roi_image, warp_roi_image;
+        initopt::roi_extraction(warp_image, rois[i], roi_image);
+        initopt::warp_roi_extraction(image, transform_warping, rois[i], warp_roi_image);
+
+        GTEST_ASSERT_EQ(roi_image.size(), warp_roi_image.size());
+        // Only the rounding of the interpolation coordinates may differ
+        GTEST_ASSERT_LE(cv::norm(roi_image, warp_roi_image, cv::NORM_INF), 2.0);
+    }
+}
+
+TEST(unit, init_opt_shared_gradients)
+{
+    // Bright disk on a dark background, then on a textured background
+    cv::Mat roi_images[2] = { cv::Mat::zeros(80, 80, CV_8UC3), cv::Mat(80, 80, CV_8UC3) };
+    cv::randu(roi_images[1], cv::Scalar::all(0), cv::Scalar::all(96));
+    for (int k = 0; k < 2; k++)
+        cv::circle(roi_images[k], cv::Point(42, 37), 20, cv::Scalar::all(255), -1);
+
+    // The gradients computed once give the centers of the detector computing them for each type of traffic sign
+    const int edges_numbers[] = { 3, 4, 8, 12 };
+    for (int k = 0; k < 2; k++) {
+        initopt::RoiGradients gradients;
+        initopt::roi_gradients(roi_images[k], gradients);
+        for (size_t i = 0; i < sizeof(edges_numbers) / sizeof(edges_numbers[0]); i++) {
+            for (int radius = 10; radius <= 20; radius += 10) {
+                const cv::Point2f center = reference_radial_symmetry_detector(roi_images[k], radius, edges_numbers[i]);
+                const cv::Point2f shared_center = initopt::radial_symmetry_detector(gradients, radius, edges_numbers[i]);
+                GTEST_ASSERT_EQ(center.x, shared_center.x);
+                GTEST_ASSERT_EQ(center.y, shared_center.y);
+            }
+        }
+    }
+}
+
+TEST(unit, init_opt_edge_list)
+{
+    cv::Mat roi_image = cv::Mat::zeros(80, 80, CV_8UC3);
+    cv::rectangle(roi_image, cv::Point(20, 25), cv::Point(60, 55), cv::Scalar::all(255), -1);
+
+    initopt::RoiGradients gradients;
+    initopt::roi_gradients(roi_image, gradients);
+    cv::Mat gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y;
+    initopt::orientations_from_gradient(gradients.gradient_x, gradients.gradient_y, gradients.gradient_gp_degree, 4, gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y);
+
+    // One edge per pixel with a non-zero magnitude, in raster order
+    initopt::EdgeList edges;
+    initopt::edge_list_extraction(gradients.magnitude_image, gradients.gradient_x, gradients.gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, edges);
+    GTEST_ASSERT_EQ(static_cast<int> (edges.size()), cv::countNonZero(gradients.magnitude_image));
+    for (size_t e = 0; e < edges.size(); e++) {
+        GTEST_ASSERT_EQ(edges.gradient_x[e], gradients.gradient_x.at<float>(edges.y[e], edges.x[e]));
+        GTEST_ASSERT_EQ(edges.gradient_vp_y[e], gradient_vp_y.at<float>(edges.y[e], edges.x[e]));
+        if (e > 0)
+            GTEST_ASSERT_TRUE(edges.y[e - 1] < edges.y[e] || (edges.y[e - 1] == edges.y[e] && edges.x[e - 1] < edges.x[e]));
+    }
+}
+
+TEST(unit, init_opt_edge_list_voting)
+{
+    // Random gradient fields, half of the pixels below the magnitude threshold
+    cv::RNG rng(15);
+    const cv::Size image_size(70, 60);
+    for (int k = 0; k < 4; k++) {
+        cv::Mat magnitude_image(image_size, CV_32F), gradient_x(image_size, CV_32F), gradient_y(image_size, CV_32F);
+        cv::Mat gradient_vp_x(image_size, CV_32F), gradient_vp_y(image_size, CV_32F);
+        for (int i = 0; i < image_size.height; i++) {
+            for (int j = 0; j < image_size.width; j++) {
+                const float angle = rng.uniform(0.f, (float) (2. * M_PI));
+                const float vp_angle = rng.uniform(0.f, (float) (2. * M_PI));
+                const bool edge = rng.uniform(0, 2) == 1;
+                magnitude_image.at<float>(i, j) = edge ? rng.uniform(0.1f, 1.f) : 0.f;
+                gradient_x.at<float>(i, j) = edge ? std::cos(angle) : 0.f;
+                gradient_y.at<float>(i, j) = edge ? std::sin(angle) : 0.f;
+                gradient_vp_x.at<float>(i, j) = std::cos(vp_angle);
+                gradient_vp_y.at<float>(i, j) = std::sin(vp_angle);
+            }
+        }
+        const cv::Mat gradient_bar_x = gradient_y;
+        const cv::Mat gradient_bar_y = - gradient_x;
+
+        // The votes of the edge list are cast in the same order as the dense scan -- the accumulators are bit-identical,
+        // including the radii whose votes fall outside of the image
+        initopt::EdgeList edges;
+        initopt::edge_list_extraction(magnitude_image, gradient_x, gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, edges);
+        const float radii[] = { 3.f, 12.5f, 40.f };
+        const int edges_numbers[] = { 3, 4, 8, 12 };
+        for (size_t r = 0; r < sizeof(radii) / sizeof(radii[0]); r++) {
+            const int W = (int) ceil(radii[r] * std::tan(M_PI / (float) edges_numbers[k]));
+            cv::Mat Or, BrX, BrY, reference_Or, reference_BrX, reference_BrY;
+            initopt::edges_voting(edges, image_size, radii[r], W, Or, BrX, BrY);
+            reference_dense_voting(magnitude_image, gradient_x, gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, radii[r], W, reference_Or, reference_BrX, reference_BrY);
+            GTEST_ASSERT_EQ(cv::norm(Or, reference_Or, cv::NORM_INF), 0.0);
+            GTEST_ASSERT_EQ(cv::norm(BrX, reference_BrX, cv::NORM_INF), 0.0);
+            GTEST_ASSERT_EQ(cv::norm(BrY, reference_BrY, cv::NORM_INF), 0.0);
+        }
+    }
+}
+
+TEST(unit, init_opt_multi_radius)
+{
+    // Bright triangle on a dark background
+    cv::Mat roi_image = cv::Mat::zeros(90, 90, CV_8UC3);
+    const cv::Point triangle[3] = { cv::Point(45, 15), cv::Point(75, 70), cv::Point(15, 70) };
+    cv::fillConvexPoly(roi_image, triangle, 3, cv::Scalar::all(255));
+
+    initopt::RoiGradients gradients;
+    initopt::roi_gradients(roi_image, gradients);
+    cv::Mat gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y;
+    initopt::orientations_from_gradient(gradients.gradient_x, gradients.gradient_y, gradients.gradient_gp_degree, 3, gradient_vp_x, gradient_vp_y, gradient_bar_x, gradient_bar_y);
+    initopt::EdgeList edges;
+    initopt::edge_list_extraction(gradients.magnitude_image, gradients.gradient_x, gradients.gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, edges);
+
+    // One pass for the radius of the triangle, of the inner triangle and a smaller one -- each band of votes is the
+    // one of an independent vote for its radius alone
+    std::vector< int > radii;
+    radii.push_back(22);
+    radii.push_back(11);
+    radii.push_back(4);
+    std::vector< float > radii_float(radii.begin(), radii.end());
+    std::vector< int > Ws;
+    for (size_t r = 0; r < radii.size(); r++)
+        Ws.push_back((int) ceil(radii_float[r] * std::tan(M_PI / 3.)));
+    std::vector< cv::Mat > Or, BrX, BrY;
+    initopt::edges_voting(edges, roi_image.size(), radii_float, Ws, Or, BrX, BrY);
+    GTEST_ASSERT_EQ(Or.size(), radii.size());
+
+    std::vector< cv::Point2f > centers;
+    initopt::radial_symmetry_detector(gradients, radii, 3, centers);
+    GTEST_ASSERT_EQ(centers.size(), radii.size());
+    for (size_t r = 0; r < radii.size(); r++) {
+        cv::Mat reference_Or, reference_BrX, reference_BrY;
+        reference_dense_voting(gradients.magnitude_image, gradients.gradient_x, gradients.gradient_y, gradient_bar_x, gradient_bar_y, gradient_vp_x, gradient_vp_y, radii_float[r], Ws[r], reference_Or, reference_BrX, reference_BrY);
+        GTEST_ASSERT_EQ(cv::norm(Or[r], reference_Or, cv::NORM_INF), 0.0);
+        GTEST_ASSERT_EQ(cv::norm(BrX[r], reference_BrX, cv::NORM_INF), 0.0);
+        GTEST_ASSERT_EQ(cv::norm(BrY[r], reference_BrY, cv::NORM_INF), 0.0);
+
+        const cv::Point2f center = initopt::center_from_votes(reference_Or, reference_BrX, reference_BrY, radii_float[r], Ws[r], 3);
+        GTEST_ASSERT_EQ(centers[r].x, center.x);
+        GTEST_ASSERT_EQ(centers[r].y, center.y);
+    }
+}
@@ -43,11 +43,214 @@ the use of this software, even if advised of the possibility of such damage.
 
 // our own code
 #include <img_processing/segmentation.h>
+#include <img_processing/colorConversion.h>
+#include <common/parallel.h>
+
+#include <tests/unit/img_processing/test_images.h>
 
 #include <gtest/gtest.h>
 
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Segmentation of the log chromatic planes computed for every pixel
+static void log_segmentation(const cv::Mat& rgb_image, cv::Mat& log_image_seg) {
+
+    std::vector< cv::Mat > log_image(2);
+    log_image[0].create(rgb_image.size(), CV_32F);
+    log_image[1].create(rgb_image.size(), CV_32F);
+    for (int i = 0; i < rgb_image.rows; i++) {
+        for (int j = 0; j < rgb_image.cols; j++) {
+            const cv::Vec3b px = rgb_image.at<cv::Vec3b>(i, j);
+            const float division = 1.0f / static_cast<float> (px[1] == 0 ? px[1] + 1 : px[1]);
+            log_image[0].at<float>(i, j) = std::log(static_cast<float> (px[2])*division);
+            log_image[1].at<float>(i, j) = std::log(static_cast<float> (px[0])*division);
+        }
+    }
+    segmentation::seg_log_chromatic(log_image, log_image_seg);
+}
+
+// Segmentation of the image through the IHLS and log chromatic images
+static void separate_segmentation(const cv::Mat& rgb_image, cv::Mat& seg_image) {
+
+    cv::Mat ihls_image, nhs_image_seg, log_image_seg;
+    colorconversion::convert_rgb_to_ihls(rgb_image, ihls_image);
+    segmentation::seg_norm_hue(ihls_image, nhs_image_seg, 0);
+    log_segmentation(rgb_image, log_image_seg);
+
+    cv::bitwise_or(nhs_image_seg, log_image_seg, seg_image);
+}
+
 TEST(unit, segmentation)
 {
     GTEST_ASSERT_EQ(1, 1);
 }
 
+TEST(unit, segmentation_fused_all_colours)
+{
+    const cv::Mat rgb_image = all_colours_image();
+
+    cv::Mat seg_separate, seg_fused;
+    separate_segmentation(rgb_image, seg_separate);
+    segmentation::seg_fused(rgb_image, seg_fused);
+
+    GTEST_ASSERT_EQ(seg_fused.type(), CV_8UC1);
+    GTEST_ASSERT_EQ(cv::norm(seg_separate, seg_fused, cv::NORM_INF), 0.0);
+}
+
+TEST(unit, segmentation_fused_test_images)
+{
+    const std::string filenames[] = { "/circular0009.jpg", "/octogonal0017.jpg", "/triangular0016.jpg" };
+    for (size_t i = 0; i < sizeof(filenames) / sizeof(filenames[0]); i++) {
+        const cv::Mat rgb_image = cv::imread(std::string(TEST_DATA_DIR) + filenames[i]);
+        ASSERT_TRUE(rgb_image.data != NULL);
+
+        cv::Mat seg_separate, seg_fused;
+        separate_segmentation(rgb_image, seg_separate);
+        segmentation::seg_fused(rgb_image, seg_fused);
+
+        GTEST_ASSERT_EQ(cv::norm(seg_separate, seg_fused, cv::NORM_INF), 0.0);
+    }
+}
+
+TEST(unit, segmentation_log_ratio_table)
+{
+    // Every BGR colour
+    const cv::Mat rgb_image = all_colours_image();
+
+    cv::Mat log_reference, log_table;
+    log_segmentation(rgb_image, log_reference);
+    segmentation::seg_log_chromatic_rgb(rgb_image, log_table, 2);
+    GTEST_ASSERT_EQ(log_table.type(), CV_8UC1);
+    GTEST_ASSERT_EQ(cv::norm(log_reference, log_table, cv::NORM_INF), 0.0);
+
+    // Test images through the float planes of rgb_to_log_rb
+    const std::string filenames[] = { "/different0011.jpg", "/octogonal0010.jpg" };
+    for (size_t i = 0; i < sizeof(filenames) / sizeof(filenames[0]); i++) {
+        const cv::Mat test_image = cv::imread(std::string(TEST_DATA_DIR) + filenames[i]);
+        ASSERT_TRUE(test_image.data != NULL);
+
+        std::vector< cv::Mat > log_image;
+        colorconversion::rgb_to_log_rb(test_image, log_image);
+        segmentation::seg_log_chromatic(log_image, log_reference);
+        segmentation::seg_log_chromatic_rgb(test_image, log_table);
+        GTEST_ASSERT_EQ(cv::norm(log_reference, log_table, cv::NORM_INF), 0.0);
+    }
+}
+
+TEST(unit, segmentation_labels_all_colours)
+{
+    const cv::Mat rgb_image = all_colours_image();
+
+    // Masks of each label computed separately
+    cv::Mat ihls_image, nhs_red, nhs_blue, log_seg;
+    colorconversion::convert_rgb_to_ihls(rgb_image, ihls_image);
+    segmentation::seg_norm_hue(ihls_image, nhs_red, 0);
+    segmentation::seg_norm_hue(ihls_image, nhs_blue, 1);
+    log_segmentation(rgb_image, log_seg);
+
+    cv::Mat nhs_labels, fused_labels, mask;
+    segmentation::seg_norm_hue_labels(ihls_image, nhs_labels);
+    segmentation::seg_fused_labels(rgb_image, fused_labels);
+    GTEST_ASSERT_EQ(fused_labels.type(), CV_8UC1);
+
+    segmentation::labels_to_mask(nhs_labels, mask, SEG_LABEL_RED);
+    GTEST_ASSERT_EQ(cv::norm(nhs_red, mask, cv::NORM_INF), 0.0);
+    segmentation::labels_to_mask(nhs_labels, mask, SEG_LABEL_BLUE);
+    GTEST_ASSERT_EQ(cv::norm(nhs_blue, mask, cv::NORM_INF), 0.0);
+
+    segmentation::labels_to_mask(fused_labels, mask, SEG_LABEL_RED);
+    GTEST_ASSERT_EQ(cv::norm(nhs_red, mask, cv::NORM_INF), 0.0);
+    segmentation::labels_to_mask(fused_labels, mask, SEG_LABEL_BLUE);
+    GTEST_ASSERT_EQ(cv::norm(nhs_blue, mask, cv::NORM_INF), 0.0);
+    segmentation::labels_to_mask(fused_labels, mask, SEG_LABEL_LOG);
+    GTEST_ASSERT_EQ(cv::norm(log_seg, mask, cv::NORM_INF), 0.0);
+
+    // The red mask is the one of the fused segmentation
+    cv::Mat seg_fused;
+    segmentation::seg_fused(rgb_image, seg_fused);
+    segmentation::labels_to_mask(fused_labels, mask, SEG_MASK_RED);
+    GTEST_ASSERT_EQ(cv::norm(seg_fused, mask, cv::NORM_INF), 0.0);
+}
+
+TEST(unit, segmentation_parallel_all_colours)
+{
+    const cv::Mat rgb_image = all_colours_image();
+
+    cv::Mat ihls_serial, seg_serial, labels_serial;
+    colorconversion::convert_rgb_to_ihls(rgb_image, ihls_serial);
+    segmentation::seg_fused(rgb_image, seg_serial);
+    segmentation::seg_fused_labels(rgb_image, labels_serial);
+
+    // The rows are written by different threads but the results are the same
+    cv::Mat ihls_parallel, nhs_serial, nhs_parallel, seg_parallel, labels_parallel;
+    colorconversion::convert_rgb_to_ihls(rgb_image, ihls_parallel, 4);
+    GTEST_ASSERT_EQ(cv::norm(ihls_serial, ihls_parallel, cv::NORM_INF), 0.0);
+    segmentation::seg_norm_hue(ihls_serial, nhs_serial, 0);
+    segmentation::seg_norm_hue(ihls_serial, nhs_parallel, 0, R_HUE_MAX, R_HUE_MIN, R_SAT_MIN, 4);
+    GTEST_ASSERT_EQ(cv::norm(nhs_serial, nhs_parallel, cv::NORM_INF), 0.0);
+    segmentation::seg_fused(rgb_image, seg_parallel, 0);
+    GTEST_ASSERT_EQ(cv::norm(seg_serial, seg_parallel, cv::NORM_INF), 0.0);
+
+    // Backend with one std::thread per stripe
+    parallel::set_executor([](const cv::Range& range, const parallel::RangeBody& body, const int& nb_stripes) {
+        std::vector< std::thread > threads;
+        const int length = range.end - range.start;
+        for (int k = 0; k < nb_stripes; ++k)
+            threads.push_back(std::thread(body, cv::Range(range.start + k * length / nb_stripes, range.start + (k + 1) * length / nb_stripes)));
+        for (size_t k = 0; k < threads.size(); ++k)
+            threads[k].join();
+    });
+    segmentation::seg_fused_labels(rgb_image, labels_parallel, 16);
+    parallel::set_executor(parallel::Executor());
+    GTEST_ASSERT_EQ(cv::norm(labels_serial, labels_parallel, cv::NORM_INF), 0.0);
+}
+
+TEST(unit, segmentation_lut_exact)
+{
+    // With 8 bits per channel every colour has its own cell
+    segmentation::SegmentationLut lut;
+    segmentation::build_seg_lut(lut, 8);
+    const segmentation::SegmentationLutReport report = segmentation::seg_lut_report(lut);
+    GTEST_ASSERT_EQ(report.nb_colours, 1L << 24);
+    GTEST_ASSERT_EQ(report.nb_mixed_cells, 0L);
+    ASSERT_TRUE(report.exact());
+
+    const cv::Mat rgb_image = all_colours_image();
+    cv::Mat seg_separate, seg_lut;
+    separate_segmentation(rgb_image, seg_separate);
+    segmentation::seg_lut(rgb_image, seg_lut, lut);
+    GTEST_ASSERT_EQ(cv::norm(seg_separate, seg_lut, cv::NORM_INF), 0.0);
+
+    // The blue label gives the blue normalised hue segmentation
+    cv::Mat ihls_image, nhs_blue, seg_blue;
+    colorconversion::convert_rgb_to_ihls(rgb_image, ihls_image);
+    segmentation::seg_norm_hue(ihls_image, nhs_blue, 1);
+    segmentation::seg_lut(rgb_image, seg_blue, lut, SEG_LABEL_BLUE);
+    GTEST_ASSERT_EQ(cv::norm(nhs_blue, seg_blue, cv::NORM_INF), 0.0);
+
+    // The exact table gives the labels of the fused segmentation
+    cv::Mat lut_labels, fused_labels;
+    segmentation::seg_lut_labels(rgb_image, lut_labels, lut);
+    segmentation::seg_fused_labels(rgb_image, fused_labels);
+    GTEST_ASSERT_EQ(cv::norm(lut_labels, fused_labels, cv::NORM_INF), 0.0);
+}
+
+TEST(unit, segmentation_lut_quantised_report)
+{
+    segmentation::SegmentationLut lut;
+    segmentation::build_seg_lut(lut, SEG_LUT_BITS);
+    const segmentation::SegmentationLutReport report = segmentation::seg_lut_report(lut);
+
+    std::cout << "LUT " << SEG_LUT_BITS << " bits: " << report.nb_cells << " cells, " << report.nb_mixed_cells << " mixed" << std::endl;
+    std::cout << "  mismatching colours -- red: " << report.nb_mismatch_red << " blue: " << report.nb_mismatch_blue
+              << " log: " << report.nb_mismatch_log << " / " << report.nb_colours << std::endl;
+
+    GTEST_ASSERT_EQ(report.nb_cells, 1L << (3 * SEG_LUT_BITS));
+    // The majority vote keeps the errors on the boundaries of the colour regions
+    ASSERT_LT(report.nb_mismatch_red, report.nb_colours / 100);
+    ASSERT_LT(report.nb_mismatch_blue, report.nb_colours / 100);
+    ASSERT_LT(report.nb_mismatch_log, report.nb_colours / 100);
+}
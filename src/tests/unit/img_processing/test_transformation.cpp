@@ -0,0 +1,122 @@
+/*
+By downloading, copying, installing or using the software you agree to this license.
+If you do not agree to this license, do not download, install,
+copy or use the software.
+
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2015,
+      Guillaume Lemaitre (g.lemaitre58@gmail.com),
+      Johan Massich (mailsik@gmail.com),
+      Gerard Bahi (zomeck@gmail.com),
+      Yohan Fougerolle (Yohan.Fougerolle@u-bourgogne.fr).
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are disclaimed.
+In no event shall copyright holders or contributors be liable for any direct,
+indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+// our own code
+#include <img_processing/imageProcessing.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+TEST(unit, affine_transform_contour)
+{
+    // Transformation as produced by the correction of the distortion
+    const float angle = 0.3f;
+    cv::Mat translation_matrix = cv::Mat::eye(3, 3, CV_32F);
+    translation_matrix.at<float>(0, 2) = -112.5f;
+    translation_matrix.at<float>(1, 2) = -47.25f;
+    cv::Mat rotation_matrix = cv::Mat::eye(3, 3, CV_32F);
+    rotation_matrix.at<float>(0, 0) = std::cos(angle);
+    rotation_matrix.at<float>(0, 1) = - std::sin(angle);
+    rotation_matrix.at<float>(1, 0) = std::sin(angle);
+    rotation_matrix.at<float>(1, 1) = std::cos(angle);
+    cv::Mat scaling_matrix = cv::Mat::eye(3, 3, CV_32F);
+    scaling_matrix.at<float>(0, 0) = 1.2f;
+    scaling_matrix.at<float>(1, 1) = 0.8f;
+
+    std::vector< cv::Point2f > contour;
+    for (int i = 0; i < 64; i++)
+        contour.push_back(cv::Point2f(100.0f + 20.0f * std::cos(0.1f * i), 40.0f + 15.0f * std::sin(0.1f * i)));
+
+    // Reference with the homogeneous coordinates
+    const cv::Mat transform = rotation_matrix * scaling_matrix * translation_matrix;
+    const imageprocessing::AffineTransform2f affine(translation_matrix, rotation_matrix, scaling_matrix);
+    std::vector< cv::Point2f > output_contour;
+    affine.forward(contour, output_contour);
+    GTEST_ASSERT_EQ(output_contour.size(), contour.size());
+    for (size_t i = 0; i < contour.size(); i++) {
+        const cv::Mat point = transform * (cv::Mat_<float>(3, 1) << contour[i].x, contour[i].y, 1.0f);
+        GTEST_ASSERT_LE(std::abs(output_contour[i].x - point.at<float>(0)), 1e-4);
+        GTEST_ASSERT_LE(std::abs(output_contour[i].y - point.at<float>(1)), 1e-4);
+    }
+
+    // Inverse in place goes back to the contour
+    affine.inverse(output_contour);
+    for (size_t i = 0; i < contour.size(); i++) {
+        GTEST_ASSERT_LE(std::abs(output_contour[i].x - contour[i].x), 1e-3);
+        GTEST_ASSERT_LE(std::abs(output_contour[i].y - contour[i].y), 1e-3);
+    }
+
+    // Composition with the inverse is the identity
+    const cv::Mat identity = (affine.inv() * affine).matrix();
+    GTEST_ASSERT_LE(cv::norm(identity, cv::Mat::eye(3, 3, CV_64F), cv::NORM_INF), 1e-6);
+}
+
+TEST(unit, correction_distortion_transforms)
+{
+    // Rotated ellipse
+    std::vector< std::vector< cv::Point > > contours(1);
+    cv::ellipse2Poly(cv::Point(120, 80), cv::Size(40, 15), 30, 0, 360, 5, contours[0]);
+
+    std::vector< std::vector< cv::Point2f > > undistorted_contours;
+    imageprocessing::ContourTransforms transforms;
+    imageprocessing::correction_distortion(contours, undistorted_contours, transforms);
+    GTEST_ASSERT_EQ(transforms.size(), contours.size());
+
+    // The matrices give back the same transformation
+    std::vector< std::vector< cv::Point2f > > matrix_contours;
+    std::vector< cv::Mat > translation_matrix, rotation_matrix, scaling_matrix;
+    imageprocessing::correction_distortion(contours, matrix_contours, translation_matrix, rotation_matrix, scaling_matrix);
+    const imageprocessing::AffineTransform2f correction(translation_matrix[0], rotation_matrix[0], scaling_matrix[0]);
+    GTEST_ASSERT_LE(cv::norm(correction.matrix(), transforms.correction(0).matrix(), cv::NORM_INF), 0.0);
+    for (size_t i = 0; i < contours[0].size(); i++) {
+        GTEST_ASSERT_EQ(undistorted_contours[0][i].x, matrix_contours[0][i].x);
+        GTEST_ASSERT_EQ(undistorted_contours[0][i].y, matrix_contours[0][i].y);
+    }
+
+    // The undistorted contour is centred and isotropic
+    const cv::Moments moments = cv::moments(undistorted_contours[0]);
+    GTEST_ASSERT_LE(std::abs(moments.m10 / moments.m00), 1e-2);
+    GTEST_ASSERT_LE(std::abs(moments.m01 / moments.m00), 1e-2);
+    GTEST_ASSERT_LE(std::abs(moments.mu20 - moments.mu02) / moments.mu20, 1e-2);
+}
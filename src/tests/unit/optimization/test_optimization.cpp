@@ -43,15 +43,18 @@ the use of this software, even if advised of the possibility of such damage.
 
 // our own code
 #include <common/math_utils.h>
+#include <optimization/SuperFormula.h>
 
 
 #include <iostream>
+#include <limits>
 
 // OpenCV library
 #include <opencv2/opencv.hpp>
 
 // Eigen library
 #include <Eigen/Core>
+#include <Eigen/Cholesky>
 
 #include <gtest/gtest.h>
 
@@ -60,3 +63,393 @@ TEST(unit, math_utils)
     GTEST_ASSERT_EQ(1, 1);
 }
 
+
+// Implicit functions as evaluated before the fixed-size buffers, with std::vector rows,
+// the radius and the finite difference DrDtheta of each intersection, kept as a reference
+static double reference_implicit_function(RationalSuperShape2D &shape, const Vector2d &P, int function_used, std::vector<double> &Dffinal)
+{
+    const double x(P[0]), y(P[1]), PSL(P.squaredNorm()), PL(sqrt(PSL)), dthtdx(-y / PSL), dthtdy(x / PSL);
+    double thtbase(atan2(y, x));
+    if (thtbase < 0) thtbase += 2. * M_PI;
+    std::vector<double> f;
+    std::vector< std::vector<double> > Df;
+    for (int i = 0; i < shape.Get_q(); i++) {
+        const double tht(thtbase + i * 2. * M_PI), R(shape.radius(tht)), drdth(shape.DrDtheta(tht));
+        std::vector<double> rowi(3);
+        switch (function_used) {
+        case 1:
+            f.push_back(R - PL);
+            rowi[0] = drdth * dthtdx - cos(tht);
+            rowi[1] = drdth * dthtdy - sin(tht);
+            rowi[2] = 1.;
+            break;
+        case 2:
+            f.push_back(1. - PL / R);
+            rowi[0] = -(x * R / PL - drdth * dthtdx * PL) / (R * R);
+            rowi[1] = -(y * R / PL - drdth * dthtdy * PL) / (R * R);
+            rowi[2] = PL / (R * R);
+            break;
+        default:
+            f.push_back(log(R * R / PSL));
+            rowi[0] = -2. * (x * R - PSL * drdth * dthtdx) / (R * PSL);
+            rowi[1] = -2. * (y * R - PSL * drdth * dthtdy) / (R * PSL);
+            rowi[2] = 2. / R;
+        }
+        Df.push_back(rowi);
+    }
+    for (size_t i = 0; i + 1 < f.size(); i++)
+        for (size_t j = i + 1; j < f.size(); j++)
+            if (f[i] < f[j]) {
+                std::swap(f[i], f[j]);
+                Df[i].swap(Df[j]);
+            }
+    double f1(f[0]);
+    Dffinal = Df[0];
+    for (size_t i = 1; i < f.size(); i++)
+        RpUnion(f1, f[i], Dffinal, Df[i], f1, Dffinal);
+    return f1;
+}
+
+TEST(unit, implicit_functions_fixed_size)
+{
+    // q on the stack and q on the heap
+    const int q_values[] = { 1, 3, IMPLICIT_MAX_INTERSECTIONS + 2 };
+    for (size_t k = 0; k < sizeof(q_values) / sizeof(q_values[0]); k++) {
+        RationalSuperShape2D shape(1.1, 0.9, 3, 4, 5, 5, q_values[k]);
+        for (int i = 0; i < 20; i++) {
+            // Away from theta = 0 where the intersections wrap around
+            const Vector2d P(cos(0.1 + 0.3 * i) * (0.5 + 0.05 * i), sin(0.1 + 0.3 * i) * (0.5 + 0.04 * i));
+            const double delta = 1e-6;
+            for (int function_used = 1; function_used <= 3; function_used++) {
+                std::vector<double> Df_vector, Df_reference;
+                Vector3d Df, Df_dx, Df_dy;
+                double f, f_vector, f_dx, f_dy;
+                const double f_reference = reference_implicit_function(shape, P, function_used, Df_reference);
+                switch (function_used) {
+                case 1:
+                    f = shape.ImplicitFunction1(P, Df);
+                    f_vector = shape.ImplicitFunction1(P, Df_vector);
+                    f_dx = shape.ImplicitFunction1(Vector2d(P[0] + delta, P[1]), Df_dx);
+                    f_dy = shape.ImplicitFunction1(Vector2d(P[0], P[1] + delta), Df_dy);
+                    break;
+                case 2:
+                    f = shape.ImplicitFunction2(P, Df);
+                    f_vector = shape.ImplicitFunction2(P, Df_vector);
+                    f_dx = shape.ImplicitFunction2(Vector2d(P[0] + delta, P[1]), Df_dx);
+                    f_dy = shape.ImplicitFunction2(Vector2d(P[0], P[1] + delta), Df_dy);
+                    break;
+                default:
+                    f = shape.ImplicitFunction3(P, Df);
+                    f_vector = shape.ImplicitFunction3(P, Df_vector);
+                    f_dx = shape.ImplicitFunction3(Vector2d(P[0] + delta, P[1]), Df_dx);
+                    f_dy = shape.ImplicitFunction3(Vector2d(P[0], P[1] + delta), Df_dy);
+                }
+
+                // Both interfaces give the values of the reference, up to its finite difference dr/dtheta
+                GTEST_ASSERT_EQ(Df_vector.size(), 3u);
+                GTEST_ASSERT_LE(std::abs(f - f_reference), 1e-12 * (1. + std::abs(f_reference)));
+                GTEST_ASSERT_LE(std::abs(f_vector - f_reference), 1e-12 * (1. + std::abs(f_reference)));
+                for (int d = 0; d < 3; d++) {
+                    GTEST_ASSERT_LE(std::abs(Df[d] - Df_reference[d]), 1e-6 * (1. + std::abs(Df_reference[d])));
+                    GTEST_ASSERT_LE(std::abs(Df_vector[d] - Df_reference[d]), 1e-6 * (1. + std::abs(Df_reference[d])));
+                }
+
+                // Df/Dx and Df/Dy agree with finite differences
+                GTEST_ASSERT_LE(std::abs((f_dx - f) / delta - Df[0]), 1e-3 * (1. + std::abs(Df[0])));
+                GTEST_ASSERT_LE(std::abs((f_dy - f) / delta - Df[1]), 1e-3 * (1. + std::abs(Df[1])));
+            }
+        }
+    }
+}
+
+TEST(unit, radius_and_derivatives)
+{
+    // Smooth shape and shape with n2, n3 below 1
+    RationalSuperShape2D shapes[] = { RationalSuperShape2D(1.1, 0.8, 5, 3, 4, 8, 1),
+                                      RationalSuperShape2D(0.9, 1.2, 0.7, 0.6, 1.5, 3, 1) };
+    for (size_t k = 0; k < sizeof(shapes) / sizeof(shapes[0]); k++) {
+        for (int i = 0; i < 100; i++) {
+            const double tht = 0.013 + 2. * M_PI * i / 100.;
+            double DrDa, DrDb, DrDn1, DrDn2, DrDn3, DrDtht;
+            const double r = shapes[k].RadiusAndDerivatives(tht, DrDa, DrDb, DrDn1, DrDn2, DrDn3, DrDtht);
+
+            // Same radius and same derivatives as the finite differences
+            GTEST_ASSERT_LE(std::abs(r - shapes[k].radius(tht)), 1e-12 * r);
+            GTEST_ASSERT_LE(std::abs(DrDa - shapes[k].DrDa(tht)), 1e-6 * (1. + std::abs(DrDa)));
+            GTEST_ASSERT_LE(std::abs(DrDb - shapes[k].DrDb(tht)), 1e-6 * (1. + std::abs(DrDb)));
+            GTEST_ASSERT_LE(std::abs(DrDn1 - shapes[k].DrDn1(tht)), 1e-6 * (1. + std::abs(DrDn1)));
+            GTEST_ASSERT_LE(std::abs(DrDn2 - shapes[k].DrDn2(tht)), 1e-6 * (1. + std::abs(DrDn2)));
+            GTEST_ASSERT_LE(std::abs(DrDn3 - shapes[k].DrDn3(tht)), 1e-6 * (1. + std::abs(DrDn3)));
+            // the 1e-3 step of DrDtheta spans the cusps of the second shape, a central difference with a smaller step does not
+            const double h = 1e-6;
+            const double DrDtht_reference = (shapes[k].radius(tht + h) - shapes[k].radius(tht - h)) / (2. * h);
+            GTEST_ASSERT_LE(std::abs(DrDtht - DrDtht_reference), 1e-6 * (1. + std::abs(DrDtht)));
+        }
+    }
+}
+
+TEST(unit, point_span_fit)
+{
+    // Noisy square stored as cv::Point2f and as a vector of Vector2d
+    std::vector< cv::Point2f > contour;
+    std::vector< Vector2d, aligned_allocator< Vector2d > > points;
+    for (int i = 0; i < 200; i++) {
+        const double tht = 2. * M_PI * i / 200.;
+        const double sector = fmod(tht + M_PI / 4., M_PI / 2.) - M_PI / 4.;
+        const double r = 30. * cos(M_PI / 4.) / cos(sector) * (1. + 0.005 * sin(37. * tht));
+        contour.push_back(cv::Point2f(r * cos(tht) + 3., r * sin(tht) - 2.));
+        points.push_back(Vector2d((double) contour.back().x, (double) contour.back().y));
+    }
+
+    // All the views give the same points
+    const PointSpan span_float(&contour[0].x, contour.size());
+    const PointSpan span_map(Map< const Matrix< float, 2, Dynamic > >(&contour[0].x, 2, contour.size()));
+    const PointSpan span_vector(points);
+    GTEST_ASSERT_EQ(span_float.size(), points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        GTEST_ASSERT_EQ(span_float[i], points[i]);
+        GTEST_ASSERT_EQ(span_map[i], points[i]);
+        GTEST_ASSERT_EQ(span_vector[i], points[i]);
+    }
+
+    // Fitting the contour in place gives the same shape as fitting the converted points
+    RationalSuperShape2D shape_span(30., 30., 2., 2., 2., 4, 1), shape_vector(30., 30., 2., 2., 2., 4, 1);
+    double err_span, err_vector;
+    int it_span, it_vector;
+    shape_span.Optimize8D(span_float, err_span, 1, std::numeric_limits< double >::infinity(), &it_span);
+    shape_vector.Optimize8D(points, err_vector, 1, std::numeric_limits< double >::infinity(), &it_vector);
+    GTEST_ASSERT_EQ(err_span, err_vector);
+    GTEST_ASSERT_EQ(it_span, it_vector);
+    for (size_t p = 0; p < shape_span.Parameters.size(); p++)
+        GTEST_ASSERT_EQ(shape_span.Parameters[p], shape_vector.Parameters[p]);
+
+    Vector4d mean_span, var_span, mean_vector, var_vector;
+    shape_span.ErrorMetric(span_float, mean_span, var_span);
+    shape_vector.ErrorMetric(points, mean_vector, var_vector);
+    GTEST_ASSERT_EQ(mean_span, mean_vector);
+    GTEST_ASSERT_EQ(var_span, var_vector);
+}
+
+// XiSquare8D as evaluated before the fixed-size optimiser, with dynamic matrices, homogeneous transforms,
+// the std::vector implicit functions and the finite difference partial derivatives, kept as a reference
+static double reference_xi_square_8d(RationalSuperShape2D &shape, const std::vector< Vector2d, aligned_allocator< Vector2d > > &Data,
+                                     MatrixXd &alpha, VectorXd &beta, int functionused)
+{
+    double (RationalSuperShape2D::*implicit_function)(const Vector2d P, std::vector<double> &Dffinal) = &RationalSuperShape2D::ImplicitFunction1;
+    if (functionused == 2) implicit_function = &RationalSuperShape2D::ImplicitFunction2;
+    if (functionused == 3) implicit_function = &RationalSuperShape2D::ImplicitFunction3;
+    const double x0(shape.Get_xoffset()), y0(shape.Get_yoffset()), tht0(shape.Get_thtoffset());
+    Matrix3d Tr, Rot, dTrdx0, dTrdy0, dRotdtht0;
+    Tr << 1, 0, -x0, 0, 1, -y0, 0, 0, 1;
+    dTrdx0 << 0, 0, -1, 0, 0, 0, 0, 0, 1;
+    dTrdy0 << 0, 0, 0, 0, 0, -1, 0, 0, 1;
+    Rot << cos(tht0), sin(tht0), 0, -sin(tht0), cos(tht0), 0, 0, 0, 1;
+    dRotdtht0 << -sin(tht0), cos(tht0), 0, -cos(tht0), -sin(tht0), 0, 0, 0, 1;
+    alpha = MatrixXd::Zero(8, 8);
+    beta = VectorXd::Zero(8);
+    VectorXd dj(8);
+    std::vector<double> Df;
+    double ChiSquare(0);
+    for (size_t i = 0; i < Data.size(); i++) {
+        const Vector3d dum2(Data[i][0], Data[i][1], 1);
+        const Vector3d dum3(Rot * (Tr * dum2));
+        const Vector3d dPdx0(Rot * (dTrdx0 * dum2)), dPdy0(Rot * (dTrdy0 * dum2)), dPdtht0(dRotdtht0 * (Tr * dum2));
+        const Vector2d P(dum3[0], dum3[1]);
+        if (P.norm() < EPSILON) continue;
+        double tht(atan2(P[1], P[0]));
+        if (tht < 0) tht += 2. * M_PI;
+        const double dthtdx(-sin(tht)), dthtdy(cos(tht));
+        const double dthtdx0(dthtdx * dPdx0[0] + dthtdy * dPdx0[1]);
+        const double dthtdy0(dthtdx * dPdy0[0] + dthtdy * dPdy0[1]);
+        const double dthtdtht0(dthtdx * dPdtht0[0] + dthtdy * dPdtht0[1]);
+        const double drdth(shape.DrDtheta(tht));
+        const double f((shape.*implicit_function)(P, Df));
+        const double DfDr(Df[2]);
+        dj << DfDr * shape.DrDa(tht), DfDr * shape.DrDb(tht), DfDr * shape.DrDn1(tht), DfDr * shape.DrDn2(tht), DfDr * shape.DrDn3(tht),
+              DfDr * drdth * dthtdx0, DfDr * drdth * dthtdy0, DfDr * drdth * dthtdtht0;
+        ChiSquare += f * f;
+        beta -= f * dj;
+        alpha += dj * dj.transpose();
+    }
+    return ChiSquare;
+}
+
+TEST(unit, levenberg_marquardt_fixed_size)
+{
+    // Noisy pentagon away from the origin
+    std::vector< Vector2d, aligned_allocator< Vector2d > > points;
+    for (int i = 0; i < 200; i++) {
+        const double tht = 2. * M_PI * i / 200.;
+        const double sector = fmod(tht + M_PI / 5., 2. * M_PI / 5.) - M_PI / 5.;
+        const double r = 30. * cos(M_PI / 5.) / cos(sector) * (1. + 0.005 * sin(37. * tht));
+        points.push_back(Vector2d(r * cos(tht + 0.1) + 3., r * sin(tht + 0.1) - 2.));
+    }
+    typedef LevenbergMarquardt< 8, &RationalSuperShape2D::ImplicitFunction2 > Optimiser;
+
+    // The dynamic interface returns the full symmetric hessian of the fixed-size one,
+    // the values of the reference up to its finite difference partial derivatives
+    RationalSuperShape2D shape(28., 31., 2., 2.5, 2., 5, 1, 0.05, 0., 1., -1.);
+    Optimiser::HessianType alpha;
+    Optimiser::GradientType beta;
+    const double chi_square = Optimiser(shape).XiSquare(points, alpha, beta, true);
+    MatrixXd alpha_dynamic = MatrixXd::Zero(8, 8), alpha_reference;
+    VectorXd beta_dynamic = VectorXd::Zero(8), beta_reference;
+    const double chi_square_dynamic = shape.XiSquare8D(points, alpha_dynamic, beta_dynamic, 2, true);
+    const double chi_square_reference = reference_xi_square_8d(shape, points, alpha_reference, beta_reference, 2);
+    GTEST_ASSERT_LE(std::abs(chi_square - chi_square_reference), 1e-9 * chi_square_reference);
+    GTEST_ASSERT_LE(std::abs(chi_square_dynamic - chi_square_reference), 1e-9 * chi_square_reference);
+    for (int k = 0; k < 8; k++) {
+        const double tolerance_beta = 1e-5 * (1. + std::abs(beta_reference[k]));
+        GTEST_ASSERT_LE(std::abs(beta[k] - beta_reference[k]), tolerance_beta);
+        GTEST_ASSERT_LE(std::abs(beta_dynamic[k] - beta_reference[k]), tolerance_beta);
+        for (int j = 0; j < 8; j++) {
+            const double tolerance_alpha = 1e-5 * (1. + std::abs(alpha_reference(k, j)));
+            if (j <= k) {
+                GTEST_ASSERT_LE(std::abs(alpha(k, j) - alpha_reference(k, j)), tolerance_alpha);
+            }
+            GTEST_ASSERT_LE(std::abs(alpha_dynamic(k, j) - alpha_reference(k, j)), tolerance_alpha);
+        }
+    }
+
+    // beta is minus half the gradient of the chi square regarding a, b, n1, n2 and n3
+    // the offsets only keep the dr/dtheta term and are not checked
+    const double delta = 1e-5;
+    for (int k = 0; k < 5; k++) {
+        RationalSuperShape2D shape_plus(shape), shape_minus(shape);
+        shape_plus.Parameters[k] += delta;
+        shape_minus.Parameters[k] -= delta;
+        const double chi_plus = Optimiser(shape_plus).XiSquare(points, alpha, beta, false);
+        const double chi_minus = Optimiser(shape_minus).XiSquare(points, alpha, beta, false);
+        Optimiser(shape).XiSquare(points, alpha, beta, true);
+        const double gradient = (chi_plus - chi_minus) / (2. * delta);
+        GTEST_ASSERT_LE(std::abs(-2. * beta[k] - gradient), 1e-3 * (1. + std::abs(gradient)));
+    }
+
+    // The fit decreases the error
+    double err;
+    GTEST_ASSERT_EQ(Optimiser(shape).Optimize(points, err), true);
+    GTEST_ASSERT_LT(err, chi_square);
+    GTEST_ASSERT_EQ(Optimiser(shape).XiSquare(points, alpha, beta, false), err);
+}
+
+// Optimize8D as run before the single pass, kept as a reference: the hessian and gradient of the current parameters
+// are evaluated at each iteration, then the chi square of the trial parameters in a second, untruncated pass
+static double reference_optimize_8d(RationalSuperShape2D &shape, const std::vector< Vector2d, aligned_allocator< Vector2d > > &Data,
+                                    int functionused, int &nbiterations)
+{
+    const double LAMBDA_INCR(10);
+    double lambda(pow(LAMBDA_INCR, -6)), ChiSquare(1e15), NewChiSquare;
+    bool STOP(false);
+    MatrixXd alpha, alpha2;
+    VectorXd beta, beta2;
+    int itnum;
+    for (itnum = 0; itnum < 1000 && !STOP; itnum++) {
+        const std::vector<double> oldparams(shape.Parameters);
+        ChiSquare = shape.XiSquare8D(Data, alpha, beta, functionused, true);
+        Matrix< double, 8, 8 > system(alpha);
+        Matrix< double, 8, 1 > step(beta);
+        for (int k = 0; k < 8; k++) {
+            system(k, k) *= 1. + lambda;
+            system(k, k) += lambda;
+        }
+        system.ldlt().solveInPlace(step);
+        std::vector<double> &Parameters = shape.Parameters;
+        const bool outofbounds = Parameters[0] + step[0] < 0.01 || Parameters[0] + step[0] > 1000 ||
+                Parameters[1] + step[1] < 0.01 || Parameters[1] + step[1] > 1000 ||
+                Parameters[2] + step[2] < 0.1 || Parameters[2] + step[2] > 1000 ||
+                Parameters[3] + step[3] < 0.1 || Parameters[3] + step[3] > 1000 ||
+                Parameters[4] + step[4] < 0.1 || Parameters[4] + step[4] > 1000;
+        if (!outofbounds) {
+            for (int k = 0; k < 5; k++) Parameters[k] += step[k];
+            Parameters[9] += std::min(0.05, std::max(-0.05, step[5]));
+            Parameters[10] += std::min(0.05, std::max(-0.05, step[6]));
+            Parameters[7] += std::min(M_PI / 50., std::max(-M_PI / 50., step[7]));
+        }
+        NewChiSquare = shape.XiSquare8D(Data, alpha2, beta2, functionused, false);
+        if (NewChiSquare > 0.999 * ChiSquare || NewChiSquare <= 0.01 * ChiSquare) {
+            lambda *= LAMBDA_INCR;
+            shape.Parameters = oldparams;
+        }
+        else lambda /= LAMBDA_INCR;
+        STOP = lambda > 1e15 || NewChiSquare < 1e-5;
+    }
+    nbiterations = itnum;
+    return ChiSquare;
+}
+
+TEST(unit, levenberg_marquardt_single_pass)
+{
+    // Noisy triangle away from the origin
+    std::vector< Vector2d, aligned_allocator< Vector2d > > points;
+    for (int i = 0; i < 150; i++) {
+        const double tht = 2. * M_PI * i / 150.;
+        const double sector = fmod(tht + M_PI / 3., 2. * M_PI / 3.) - M_PI / 3.;
+        const double r = 20. * cos(M_PI / 3.) / cos(sector) * (1. + 0.005 * sin(37. * tht));
+        points.push_back(Vector2d(r * cos(tht) - 1., r * sin(tht) + 2.));
+    }
+
+    // One evaluation of the points per iteration: the hessian and gradient of the accepted parameters come with their trial evaluation
+    RationalSuperShape2D shape(20., 20., 2., 2., 2., 3, 1, 0., 0., -1., 2.);
+    double err;
+    int nb_iterations, nb_evaluations, nb_saved_evaluations;
+    GTEST_ASSERT_EQ(shape.Optimize8D(points, err, 1, std::numeric_limits< double >::infinity(), &nb_iterations, &nb_evaluations, &nb_saved_evaluations), true);
+    const int nb_points = static_cast<int>(points.size());
+    GTEST_ASSERT_GE(nb_saved_evaluations, (nb_iterations - 1) * nb_points);
+    GTEST_ASSERT_LE(nb_evaluations, (nb_iterations + 1) * nb_points);
+    // Each point evaluation of the two pass loop is either performed or saved
+    GTEST_ASSERT_EQ(nb_evaluations + nb_saved_evaluations, 2 * nb_iterations * nb_points);
+
+    // Same fit as the two pass reference
+    RationalSuperShape2D reference(20., 20., 2., 2., 2., 3, 1, 0., 0., -1., 2.);
+    int reference_nb_iterations;
+    GTEST_ASSERT_EQ(reference_optimize_8d(reference, points, 1, reference_nb_iterations), err);
+    GTEST_ASSERT_EQ(reference_nb_iterations, nb_iterations);
+    for (size_t p = 0; p < shape.Parameters.size(); p++)
+        GTEST_ASSERT_EQ(reference.Parameters[p], shape.Parameters[p]);
+
+    // With a bound, the evaluation stops as soon as the partial sum exceeds it
+    typedef LevenbergMarquardt< 8, &RationalSuperShape2D::ImplicitFunction1 > Optimiser;
+    Optimiser::HessianType alpha;
+    Optimiser::GradientType beta;
+    RationalSuperShape2D start(20., 20., 2., 2., 2., 3, 1, 0., 0., -1., 2.);
+    Optimiser optimiser(start);
+    const double chi_square = optimiser.XiSquare(points, alpha, beta, true);
+    GTEST_ASSERT_EQ(optimiser.nb_evaluations(), nb_points);
+    const double partial_chi_square = optimiser.XiSquare(points, alpha, beta, true, 0.5 * chi_square);
+    GTEST_ASSERT_LT(optimiser.nb_evaluations(), 2 * nb_points);
+    GTEST_ASSERT_LE(partial_chi_square, chi_square);
+    GTEST_ASSERT_LT(0.5 * chi_square, partial_chi_square);
+}
+
+TEST(unit, optimize_abort_checkpoint)
+{
+    // Noisy octagon fitted with a hexagonal hypothesis
+    std::vector< Vector2d, aligned_allocator< Vector2d > > points;
+    for (int i = 0; i < 300; i++) {
+        const double tht = 2. * M_PI * i / 300.;
+        const double sector = fmod(tht + M_PI / 8., M_PI / 4.) - M_PI / 8.;
+        const double r = 40. * cos(M_PI / 8.) / cos(sector) * (1. + 0.005 * sin(37. * tht + i * i));
+        points.push_back(Vector2d(r * cos(tht) + 3., r * sin(tht) - 2.));
+    }
+    double err, checkpoint_err;
+    int nb_iterations;
+    RationalSuperShape2D shape(40., 40., 2., 2., 2., 6, 1, 0.05, 0., 1., -1.);
+    GTEST_ASSERT_EQ(shape.Optimize8D(points, err, 1, std::numeric_limits< double >::infinity(), &nb_iterations, NULL, NULL, &checkpoint_err), true);
+    GTEST_ASSERT_GT(nb_iterations, OPTIMIZE_ABORT_MIN_ITERATIONS);
+    GTEST_ASSERT_LT(err, checkpoint_err);
+
+    // The bound is only compared with the error after OPTIMIZE_ABORT_MIN_ITERATIONS iterations, not with the final one
+    double aborted_err, aborted_checkpoint_err;
+    int aborted_nb_iterations;
+    RationalSuperShape2D aborted_shape(40., 40., 2., 2., 2., 6, 1, 0.05, 0., 1., -1.);
+    GTEST_ASSERT_EQ(aborted_shape.Optimize8D(points, aborted_err, 1, 0.999 * checkpoint_err, &aborted_nb_iterations, NULL, NULL, &aborted_checkpoint_err), false);
+    GTEST_ASSERT_EQ(aborted_nb_iterations, OPTIMIZE_ABORT_MIN_ITERATIONS);
+    GTEST_ASSERT_EQ(aborted_checkpoint_err, checkpoint_err);
+
+    double bounded_err;
+    int bounded_nb_iterations;
+    RationalSuperShape2D bounded_shape(40., 40., 2., 2., 2., 6, 1, 0.05, 0., 1., -1.);
+    GTEST_ASSERT_EQ(bounded_shape.Optimize8D(points, bounded_err, 1, checkpoint_err, &bounded_nb_iterations), true);
+    GTEST_ASSERT_EQ(bounded_err, err);
+    GTEST_ASSERT_EQ(bounded_nb_iterations, nb_iterations);
+}